@@ -0,0 +1,89 @@
+#include <sys/stat.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "../src/parser/parser.h"
+#include "../src/database/dbms.h"
+#include "../src/expression/expression.h"
+#include "../src/table/table.h"
+#include "../src/table/table_header.h"
+
+static const char *conditions[] = {
+	"A.b + A.x > 300",
+	"A.b * 2 + A.x - 1 > 300 AND A.x < 5 OR A.id = 3",
+	"A.x IN (1, 3, 5, 7, 9) AND A.b >= 10 + 20",
+};
+
+// the best of 5 runs, in ns per evaluation
+static double time_eval(const expr_node_t *expr, int iterations)
+{
+	double best = 0;
+	for(int run = 0; run != 5; ++run)
+	{
+		int true_count = 0;
+		auto start = std::chrono::steady_clock::now();
+		for(int i = 0; i != iterations; ++i)
+			true_count += expression::eval(expr).val_b;
+		double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		double ns = secs * 1e9 / iterations;
+		if(run == 0 || ns < best) best = ns;
+		if(true_count != 0 && true_count != iterations)
+			std::fprintf(stderr, "[Error] the result changes between evaluations.\n");
+	}
+
+	return best;
+}
+
+// evaluates WHERE conditions on one cached row of a 3-column int table,
+// with the tree interpreter and with the compiled program.
+// usage: expr_bench [iterations], a table is created in data/ and dropped
+int main(int argc, char *argv[])
+{
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 2000000;
+	mkdir("data", 0755);
+
+	parser_result_t create;
+	run_parser("CREATE TABLE A (id int PRIMARY KEY, b int, x int);", &create);
+	table_header_t header;
+	if(create.type != SQL_CREATE_TABLE || !fill_table_header(&header, (table_def_t*)create.param))
+	{
+		std::fprintf(stderr, "[Error] fail to create table!\n");
+		return 1;
+	}
+
+	parser_free_result(&create);
+
+	table_manager tm;
+	tm.create("A", &header);
+	int values[] = { 3, 150, 7 };
+	tm.init_temp_record();
+	for(int i = 0; i != 3; ++i)
+		tm.set_temp_record(i, &values[i]);
+	int rid = tm.insert_record();
+	record_manager rm = tm.get_record_ptr(rid);
+	tm.cache_record(&rm);
+
+	std::vector<table_manager*> tables(1, &tm);
+	for(const char *cond : conditions)
+	{
+		std::string sql = std::string("SELECT * FROM A WHERE ") + cond + ";";
+		parser_result_t result;
+		run_parser(sql.c_str(), &result);
+		expr_node_t *where = ((select_info_t*)result.param)->where;
+		dbms::bind_columns(where, tables);
+
+		double interpreted = time_eval(where, iterations);
+		if(!expression::compile(where))
+			std::fprintf(stderr, "[Error] `%s` is not compiled.\n", cond);
+		double compiled = time_eval(where, iterations);
+		expression::free_program(where);
+		std::printf("%-50s %6.1f ns -> %6.1f ns\n", cond, interpreted, compiled);
+
+		parser_free_result(&result);
+	}
+
+	tm.drop();
+	return 0;
+}
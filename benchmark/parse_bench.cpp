@@ -0,0 +1,42 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "../src/parser/parser.h"
+
+// parses and frees an INSERT of many rows over and over,
+// usage: parse_bench [iterations] [rows]
+int main(int argc, char *argv[])
+{
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 2000;
+	int rows = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+	std::string sql = "INSERT INTO Persons VALUES ";
+	char row[96];
+	for(int i = 0; i != rows; ++i)
+	{
+		std::snprintf(row, sizeof(row), "%s(%d, 'name_%d', %d.5, '2020-01-%02d')",
+			i ? "," : "", i, i, i, i % 28 + 1);
+		sql += row;
+	}
+	sql += ";";
+
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i != iterations; ++i)
+	{
+		parser_result_t result;
+		run_parser(sql.c_str(), &result);
+		if(result.type != SQL_INSERT)
+		{
+			std::fprintf(stderr, "[Error] the statement is not parsed as INSERT.\n");
+			return 1;
+		}
+
+		parser_free_result(&result);
+	}
+
+	double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::printf("%d rows, %zu bytes of SQL: %.1f statements/s, %.2f MB/s\n",
+		rows, sql.size(), iterations / secs, iterations * sql.size() / secs / 1e6);
+	return 0;
+}
@@ -96,3 +96,7 @@ void AsyncBuffer::Skip(size_t size) {
     buffer_.AdjustReadPtr(size);
   }
 }
+
+size_t AsyncBuffer::PendingBytes() const {
+  return buffer_.ReadableSize() + backBytes_;
+}
@@ -32,6 +32,10 @@ class AsyncBuffer {
   void ProcessBuffer(BufferSequence &data);
   void Skip(std::size_t size);
 
+  // Bytes written but not yet taken by the send thread. The chunk the
+  // send thread is working on is not counted.
+  std::size_t PendingBytes() const;
+
  private:
   Buffer buffer_;
 
@@ -20,21 +20,24 @@
 
 #include <algorithm>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "auth.h"
 #include "common.h"
 #include "greeting.h"
+#include "thread_pool.h"
 #include "unbounded_buffer.h"
 #include "err.h"
+#include "../src/defs.h"
 #include "../src/parser/defs.h"
 #include "../src/parser/parser.h"
 #include "../src/database/dbms.h"
 #include "../src/table/table_header.h"
 
-extern "C" char run_parser(const char *input);
-
 template<typename T, typename DataDeleter>
 void free_linked_list(linked_list_t *linked_list, DataDeleter data_deleter)
 {
@@ -80,15 +83,183 @@ void expression::free_exprnode(expr_node_t *expr)
 	free(expr);
 }
 
-void free_column_ref(column_ref_t *cref)
-{
-	if(!cref) return;
-	free(cref->column);
-	free(cref->table);
-	free(cref);
-}
+// The storage engine is not thread-safe: page_fs is one page cache whose
+// raw page pointers any read may evict, dbms keeps one current database,
+// and every table caches its current record. So statements are parsed on
+// any worker but run one at a time, and a statement lets go of the engine
+// only while it is parked, with its tables held against the others.
+static std::mutex engineLock;
+
+// guarded by engineLock, the tables held by parked commands, and the
+// connections whose next command waits for some of them
+static std::multiset<std::string> heldTables;
+static int heldCommands, heldExclusive;
+static std::vector<std::shared_ptr<Client>> blockedClients;
+
+// the stack of a command, only the pages it touches are allocated
+static const std::size_t kCommandStackSize = 4 << 20;
 
 PacketLength Client::_HandlePacket(const char *start, std::size_t bytes) {
+  // the packets of a connection run one after another on a worker
+  {
+    std::lock_guard<std::mutex> guard(pendingLock_);
+    pending_.emplace_back(start, bytes);
+    if (running_) return static_cast<PacketLength>(bytes);
+    running_ = true;
+  }
+
+  _Schedule();
+  return static_cast<PacketLength>(bytes);
+}
+
+void Client::_Schedule() {
+  auto self = std::static_pointer_cast<Client>(shared_from_this());
+  ThreadPool::Instance().ExecuteTask([self]() { self->_RunPending(); });
+}
+
+void Client::_RunPending() {
+  auto self = std::static_pointer_cast<Client>(shared_from_this());
+  for (;;) {
+    if (!task_) {
+      std::string pkt;
+      {
+        std::lock_guard<std::mutex> guard(pendingLock_);
+        if (pending_.empty()) {
+          running_ = false;
+          return;
+        }
+
+        if (!_Behind(RESULT_SEND_BUFFER_LIMIT)) {
+          pkt.swap(pending_.front());
+          pending_.pop_front();
+        }
+      }
+
+      if (pkt.empty()) {
+        // the next packet waits without a worker, until the send thread
+        // finds most of the results taken by the client
+        OnSendDrained(RESULT_SEND_BUFFER_LIMIT, [self]() { self->_Schedule(); });
+        return;
+      }
+
+      _BeginCommand(&pkt);
+    }
+
+    std::unique_lock<std::mutex> guard(engineLock);
+    if (parked_) {
+      _Release();
+    } else if (!task_->Started()) {
+      tables_.clear();
+      if (parsed_)
+        exclusive_ = !dbms::get_instance()->get_statement_tables(&query_, tables_);
+      if (_Blocked()) {
+        // scheduled again when a parked command ends
+        blockedClients.push_back(self);
+        return;
+      }
+    }
+
+    if (!task_->Resume()) {
+      // parked by WaitSendBuffer, the engine is left to the other
+      // connections until the client has taken half of the results
+      _Hold();
+      guard.unlock();
+      OnSendDrained(RESULT_SEND_BUFFER_LIMIT / 2,
+                    [self]() { self->_Schedule(); });
+      return;
+    }
+
+    std::vector<std::shared_ptr<Client>> blocked;
+    if (held_) blocked.swap(blockedClients);
+    guard.unlock();
+
+    for (const auto &client : blocked) client->_Schedule();
+    _EndCommand();
+  }
+}
+
+bool Client::_Behind(std::size_t limit) const {
+  // nothing drains the buffer of a socket without a connection
+  if (localSock_ == INVALID_SOCKET || Invalid()) return false;
+  return PendingSendBytes() > limit;
+}
+
+void Client::_BeginCommand(std::string *pkt) {
+  command_.swap(*pkt);
+  parsed_ = false;
+  exclusive_ = false;
+
+  // the statements are parsed before they wait for their tables
+  if (command_.size() >= 5 && command_[3] != INIT_PACKET_CNT) {
+    uint8_t cmdType = static_cast<uint8_t>(command_[4]);
+    std::string queryStr = command_.substr(5);
+    if (queryStr == "select @@version_comment limit 1") {
+      // answered without the engine
+    } else if (cmdType == MYSQL_COM_QUERY) {
+      queryStr.push_back(';');
+      run_parser(queryStr.c_str(), &query_);
+      parsed_ = true;
+    } else if (cmdType == MYSQL_COM_INIT_DB) {
+      exclusive_ = true;
+    }
+  }
+
+  task_.reset(new Coroutine(
+      [this]() {
+        // an exception must not leave the coroutine
+        try {
+          _ExecutePacket(command_.data(), command_.size());
+        } catch (const std::exception &e) {
+          std::cout << "[Error] Command aborted: " << e.what() << std::endl;
+        } catch (...) {
+          std::cout << "[Error] Command aborted" << std::endl;
+        }
+      },
+      kCommandStackSize));
+}
+
+void Client::_EndCommand() {
+  task_.reset();
+  if (parsed_) parser_free_result(&query_);
+  parsed_ = false;
+  held_ = false;
+  command_.clear();
+}
+
+bool Client::_Blocked() const {
+  if (heldExclusive > 0) return true;
+  if (exclusive_) return heldCommands > 0;
+  for (const std::string &table : tables_) {
+    if (heldTables.count(table)) return true;
+  }
+
+  return false;
+}
+
+void Client::_Hold() {
+  parked_ = held_ = true;
+  ++heldCommands;
+  if (exclusive_) ++heldExclusive;
+  heldTables.insert(tables_.begin(), tables_.end());
+}
+
+void Client::_Release() {
+  parked_ = false;
+  --heldCommands;
+  if (exclusive_) --heldExclusive;
+  for (const std::string &table : tables_)
+    heldTables.erase(heldTables.find(table));
+}
+
+bool Client::WaitSendBuffer(std::size_t limit) {
+  if (task_ && _Behind(limit)) task_->Yield();
+  return !Invalid();
+}
+
+void Client::_ExecutePacket(const char *start, std::size_t bytes) {
+  // a command has at least its type after the header
+  if (bytes < 5) return;
+
   const char *const end = start + bytes;
   const char *ptr = start;
   Protocol::AuthPacket ap;
@@ -108,7 +279,6 @@ PacketLength Client::_HandlePacket(const char *start, std::size_t bytes) {
                     OkPacket.size());
     SendPacket(reply_);
     _Reset();
-    return static_cast<PacketLength>(bytes);
   } else {
     if(queryStr != "select @@version_comment limit 1") {
       std::cout << "cmd type -> " << std::to_string(cmdType) << std::endl;
@@ -116,19 +286,14 @@ PacketLength Client::_HandlePacket(const char *start, std::size_t bytes) {
       {
       case MYSQL_COM_INIT_DB:
         {
-          queryStr.push_back(';');
-          run_parser(queryStr.c_str());
+          // the payload is the bare database name, not a statement
           std::cout << "execute_use_database -> " << queryStr << std::endl;
-          std::string dbName((char*)result.param);
-          std::cout << dbName << std::endl;
-          dbms::get_instance()->switch_database(dbName.c_str(), this, start);
-          result.type = SQL_RESET;
+          dbms::get_instance()->switch_database(queryStr.c_str(), this, start);
           break;
         }
       case MYSQL_COM_QUERY:
         {
-          queryStr.push_back(';');
-          run_parser(queryStr.c_str());
+          const parser_result_t &result = query_;
           std::cout << "result type -> " << std::to_string(result.type) << std::endl;
           switch (result.type)
           {
@@ -136,24 +301,18 @@ PacketLength Client::_HandlePacket(const char *start, std::size_t bytes) {
             {
               std::string dbName((char*)result.param);
               dbms::get_instance()->create_database(dbName.c_str(), this, start);
-              result.type = SQL_RESET;
-              free((char*) result.param);
               break;
             }
           case SQL_DROP_DATABASE: 
             {
               std::string dbName((char*)result.param);
               dbms::get_instance()->drop_database(dbName.c_str(), this, start);
-              result.type = SQL_RESET;
-              free((char*) result.param);
               break;
             }
           case SQL_SHOW_DATABASE: 
             {
               std::string dbName((char*)result.param);
               dbms::get_instance()->show_database(dbName.c_str(), this, start); 
-              result.type = SQL_RESET;
-              free((char*) result.param);
               break;      
             }
           case SQL_CREATE_TABLE:
@@ -167,80 +326,42 @@ PacketLength Client::_HandlePacket(const char *start, std::size_t bytes) {
               } else {
                   printf("[Error] Fail to create table!\t");
               }
-              // free resources
               delete header;
-              free(table->name);
-              free_linked_list<table_constraint_t>(table->constraints, [](table_constraint_t *data) {
-                expression::free_exprnode(data->check_cond);
-                free_column_ref(data->column_ref);
-                free_column_ref(data->foreign_column_ref);
-                free(data);
-              });
-              for(field_item_t *it = table->fields; it; )
-              {
-                field_item_t *tmp = it;
-                free(it->name);
-                expression::free_exprnode(it->default_value);
-                it = it->next;
-                free(tmp);
-              }
-              free((void*)table);
-              result.type = SQL_RESET;
               break;
             }
           case SQL_INSERT: 
             {
               insert_info_t *info = (insert_info_t*)result.param;
               dbms::get_instance()->insert_rows(info, this, start);
-              // free resources
-              free(info->table);
-              free_linked_list<column_ref_t>(info->columns, free_column_ref);
-              free_linked_list<linked_list_t>(info->values, [](linked_list_t *expr_list) {
-                  free_linked_list<expr_node_t>(expr_list, expression::free_exprnode);
-              } );
-              free((void*)info);
-              result.type = SQL_RESET;
               break;
             }
           case SQL_SELECT:
             {
               select_info_t *select_info = (select_info_t*)result.param;
               dbms::get_instance()->select_rows(select_info, this, start);
-              expression::free_exprnode(select_info->where);
-              free_linked_list<expr_node_t>(select_info->exprs, expression::free_exprnode);
-              free_linked_list<table_join_info_t>(select_info->tables, [](table_join_info_t *data) {
-                  free(data->table);
-                  if(data->join_table)
-                      free(data->join_table);
-                  if(data->alias)
-                      free(data->alias);
-                  expression::free_exprnode(data->cond);
-                  free(data);
-              });	
-              free((void*)select_info);
-              result.type = SQL_RESET;
+              break;
+            }
+          case SQL_EXPLAIN:
+            {
+              select_info_t *select_info = (select_info_t*)result.param;
+              dbms::get_instance()->explain_select(select_info, this, start);
               break;
             }
           case SQL_UPDATE:
             {
               update_info_t *update_info = (update_info_t*)result.param;
               dbms::get_instance()->update_rows(update_info, this, start);
-              free(update_info->table);
-              free_column_ref(update_info->column_ref);
-              expression::free_exprnode(update_info->where);
-              expression::free_exprnode(update_info->value);
-              free((void*)update_info);
-              result.type = SQL_RESET;
               break;
             }
           case SQL_DELETE:
             {
               delete_info_t *delete_info = (delete_info_t*)result.param;
               dbms::get_instance()->delete_rows(delete_info, this, start);
-              free(delete_info->table);
-              expression::free_exprnode(delete_info->where);
-              free((void*)delete_info); 
-              result.type = SQL_RESET;
+              break;
+            }
+          case SQL_ANALYZE_TABLE:
+            {
+              dbms::get_instance()->analyze_table((char*)result.param, this, start);
               break;
             }
           default:
@@ -267,12 +388,17 @@ PacketLength Client::_HandlePacket(const char *start, std::size_t bytes) {
         SendPacket(reply_);
         reply_.Clear();
     }
-
-    return static_cast<PacketLength>(bytes);
   }
 }
 
-Client::Client() { _Reset(); }
+Client::Client()
+    : running_(false),
+      parsed_(false),
+      exclusive_(false),
+      parked_(false),
+      held_(false) {
+  _Reset();
+}
 
 void Client::_Reset() {
   parser_.Reset();
@@ -15,16 +15,58 @@
 
 #pragma once
 
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "../src/parser/defs.h"
+#include "coroutine.h"
 #include "proto_parser.h"
 #include "stream_socket.h"
 #include "unbounded_buffer.h"
 
 class Client : public StreamSocket {
  private:
+  // queues the packet for a worker of ThreadPool
   PacketLength _HandlePacket(const char *msg, std::size_t len) override;
+  // runs the pending packets on a worker of ThreadPool
+  void _Schedule();
+  void _RunPending();
+  // more results than limit are left to send
+  bool _Behind(std::size_t limit) const;
+  // parses the command of pkt and makes the task running it
+  void _BeginCommand(std::string *pkt);
+  void _EndCommand();
+  // the tables of the command are held by a parked command
+  bool _Blocked() const;
+  // adds the tables of the parked command to the held ones, or takes them
+  // out again before it is resumed
+  void _Hold();
+  void _Release();
+  void _ExecutePacket(const char *msg, std::size_t len);
 
   UnboundedBuffer reply_;
 
+  std::mutex pendingLock_;
+  std::deque<std::string> pending_;
+  // a worker is running the pending packets
+  bool running_;
+
+  // the command being run, on a stack of its own so that it can be parked
+  // while the client is behind on its results
+  std::string command_;
+  std::unique_ptr<Coroutine> task_;
+  parser_result_t query_;
+  bool parsed_;
+  // the tables the command reads or writes, or all of them if exclusive_
+  std::vector<std::string> tables_;
+  bool exclusive_;
+  bool parked_;
+  // the command has been parked, and may have kept others waiting
+  bool held_;
+
   ProtoParser parser_;
 
  public:
@@ -33,5 +75,7 @@ class Client : public StreamSocket {
   void _Reset();
 
   void OnConnect() override;
+  // parks the command running while more than limit bytes are left to send
+  bool WaitSendBuffer(std::size_t limit) override;
 
 };
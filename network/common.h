@@ -275,6 +275,9 @@ struct NocaseComp {
 
 #define INIT_PACKET_CNT 1
 
+// a payload of this size continues in the next packet
+#define MAX_PACKET_PAYLOAD 0xffffff
+
 #define MYSQL_COM_INIT_DB 0x02
 
 #define MYSQL_COM_QUERY 0x03
@@ -0,0 +1,68 @@
+// Copyright 2022 The uhp-sql Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "coroutine.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <new>
+
+Coroutine::Coroutine(const std::function<void()> &fn, std::size_t stackSize)
+    : fn_(fn), started_(false), finished_(false) {
+  // the lowest page is left unmapped, so an overflow faults at once
+  std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  stackSize_ = (stackSize + page - 1) / page * page + page;
+  stack_ = ::mmap(nullptr, stackSize_, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (stack_ == MAP_FAILED) throw std::bad_alloc();
+  ::mprotect(stack_, page, PROT_NONE);
+
+  ::getcontext(&context_);
+  context_.uc_stack.ss_sp = stack_;
+  context_.uc_stack.ss_size = stackSize_;
+  context_.uc_link = &caller_;
+
+  // makecontext passes int arguments only
+  uintptr_t self = reinterpret_cast<uintptr_t>(this);
+  ::makecontext(&context_, reinterpret_cast<void (*)()>(&Coroutine::_Entry),
+                2, static_cast<unsigned int>(self >> 32),
+                static_cast<unsigned int>(self));
+}
+
+Coroutine::~Coroutine() {
+  // the objects on a suspended stack would never be destroyed
+  assert(!started_ || finished_);
+  ::munmap(stack_, stackSize_);
+}
+
+void Coroutine::_Entry(unsigned int high, unsigned int low) {
+  uintptr_t self = (static_cast<uintptr_t>(high) << 32) | low;
+  Coroutine *co = reinterpret_cast<Coroutine *>(self);
+  co->fn_();
+  co->finished_ = true;
+  // returns to caller_ through uc_link
+}
+
+bool Coroutine::Resume() {
+  assert(!finished_);
+  started_ = true;
+  ::swapcontext(&caller_, &context_);
+  return finished_;
+}
+
+void Coroutine::Yield() { ::swapcontext(&context_, &caller_); }
@@ -0,0 +1,52 @@
+// Copyright 2022 The uhp-sql Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <ucontext.h>
+
+#include <cstddef>
+#include <functional>
+
+// Runs a function on a stack of its own. The function may suspend itself
+// with Yield, and it carries on from there when it is resumed again, which
+// may be on another thread. An exception must not leave the function.
+class Coroutine {
+ public:
+  Coroutine(const std::function<void()> &fn, std::size_t stackSize);
+  ~Coroutine();
+
+  Coroutine(const Coroutine &) = delete;
+  void operator=(const Coroutine &) = delete;
+
+  // Runs the function until it yields or returns, true once it has
+  // returned. Not called again after that.
+  bool Resume();
+  // Goes back to the Resume running the function, only called by it.
+  void Yield();
+
+  bool Started() const { return started_; }
+
+ private:
+  static void _Entry(unsigned int high, unsigned int low);
+
+  std::function<void()> fn_;
+  void *stack_;
+  std::size_t stackSize_;
+  ucontext_t context_;
+  ucontext_t caller_;
+  bool started_;
+  bool finished_;
+};
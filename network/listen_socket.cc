@@ -104,7 +104,7 @@ bool ListenSocket::OnReadable() {
   return true;
 }
 
-bool ListenSocket::OnWriteable() { return false; }
+bool ListenSocket::OnWritable() { return false; }
 
 bool ListenSocket::OnError() {
   if (Socket::OnError()) {
@@ -30,7 +30,7 @@ class ListenSocket : public Socket {
 
   bool Bind(const SocketAddr &addr);
   bool OnReadable();
-  bool OnWriteable();
+  bool OnWritable();
   bool OnError();
 
  private:
@@ -0,0 +1,142 @@
+// Copyright 2022 The uhp-sql Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "result_set.h"
+
+#include <algorithm>
+
+#include "common.h"
+#include "stream_socket.h"
+
+using std::size_t;
+
+ResultSetWriter::ResultSetWriter(StreamSocket *sock, uint8_t seq,
+                                 size_t flushSize, size_t sendLimit)
+    : sock_(sock),
+      packetStart_(0),
+      seq_(seq),
+      flushSize_(flushSize),
+      sendLimit_(sendLimit) {}
+
+void ResultSetWriter::BeginPacket() {
+  static const char header[4] = {0};
+
+  packetStart_ = buf_.ReadableSize();
+  buf_.PushData(header, sizeof(header));
+}
+
+bool ResultSetWriter::EndPacket() {
+  size_t len = buf_.ReadableSize() - packetStart_ - 4;
+  if (len < MAX_PACKET_PAYLOAD)
+    FillHeader(len);
+  else
+    SplitPacket(len);
+
+  if (buf_.ReadableSize() < flushSize_) return true;
+  return Flush();
+}
+
+void ResultSetWriter::FillHeader(size_t len) {
+  char *header = buf_.ReadAddr() + packetStart_;
+  header[0] = static_cast<char>(len);
+  header[1] = static_cast<char>(len >> 8);
+  header[2] = static_cast<char>(len >> 16);
+  header[3] = static_cast<char>(++seq_);
+}
+
+void ResultSetWriter::SplitPacket(size_t len) {
+  // rare enough to move the payload once, the last packet is shorter
+  // than MAX_PACKET_PAYLOAD and may be empty
+  const char *begin = buf_.ReadAddr() + packetStart_ + 4;
+  std::vector<char> payload(begin, begin + len);
+  buf_.Truncate(packetStart_);
+
+  for (size_t pos = 0;;) {
+    size_t n = std::min<size_t>(len - pos, MAX_PACKET_PAYLOAD);
+    BeginPacket();
+    buf_.PushData(payload.data() + pos, n);
+    FillHeader(n);
+    pos += n;
+    if (n < MAX_PACKET_PAYLOAD) break;
+  }
+}
+
+void ResultSetWriter::PutU16(uint16_t v) {
+  PutU8(static_cast<uint8_t>(v));
+  PutU8(static_cast<uint8_t>(v >> 8));
+}
+
+void ResultSetWriter::PutLenEncode(uint64_t v) {
+  uint8_t bytes[9];
+  size_t n;
+  if (v < 251) {
+    bytes[0] = static_cast<uint8_t>(v);
+    n = 1;
+  } else if (v < (1 << 16)) {
+    bytes[0] = 0xfc;
+    n = 3;
+  } else if (v < (1 << 24)) {
+    bytes[0] = 0xfd;
+    n = 4;
+  } else {
+    bytes[0] = 0xfe;
+    n = 9;
+  }
+
+  for (size_t i = 1; i < n; ++i)
+    bytes[i] = static_cast<uint8_t>(v >> ((i - 1) * 8));
+  buf_.PushData(bytes, n);
+}
+
+void ResultSetWriter::PutLenEncodeString(const char *s, size_t len) {
+  PutLenEncode(len);
+  buf_.PushData(s, len);
+}
+
+bool ResultSetWriter::WriteColumnCount(size_t count) {
+  BeginPacket();
+  PutLenEncode(count);
+  return EndPacket();
+}
+
+bool ResultSetWriter::WritePacket(const std::vector<uint8_t> &payload) {
+  BeginPacket();
+  buf_.PushData(payload.data(), payload.size());
+  return EndPacket();
+}
+
+bool ResultSetWriter::WriteRow(const std::vector<std::string> &row) {
+  BeginPacket();
+  for (const std::string &item : row)
+    PutLenEncodeString(item.data(), item.size());
+  return EndPacket();
+}
+
+bool ResultSetWriter::WriteEof(uint16_t warnings, uint16_t statusFlags) {
+  BeginPacket();
+  PutU8(0xfe);
+  PutU16(warnings);
+  PutU16(statusFlags);
+  return EndPacket();
+}
+
+bool ResultSetWriter::Flush() {
+  if (!buf_.IsEmpty()) {
+    sock_->SendPacket(buf_);
+    buf_.Clear();
+  }
+
+  return sock_->WaitSendBuffer(sendLimit_);
+}
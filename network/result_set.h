@@ -0,0 +1,70 @@
+// Copyright 2022 The uhp-sql Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "unbounded_buffer.h"
+
+class StreamSocket;
+
+// Writes the packets of a result set one after another into one buffer.
+// A packet is encoded in place after 4 bytes reserved for its header, and
+// the header is filled in when the packet is complete. The buffer is handed
+// to the socket in chunks of flushSize bytes, and while more than sendLimit
+// bytes are left to send the socket may suspend the writer, so a result set
+// takes about as much memory as the limit however fast the peer reads it.
+// Payloads of MAX_PACKET_PAYLOAD bytes or more are split into several
+// packets.
+class ResultSetWriter {
+ public:
+  ResultSetWriter(StreamSocket *sock, uint8_t seq, std::size_t flushSize,
+                  std::size_t sendLimit);
+  ResultSetWriter(const ResultSetWriter &) = delete;
+  ResultSetWriter &operator=(const ResultSetWriter &) = delete;
+
+  // The writers return false once the connection is closed.
+  bool WriteColumnCount(std::size_t count);
+  bool WritePacket(const std::vector<uint8_t> &payload);
+  bool WriteRow(const std::vector<std::string> &row);
+  bool WriteEof(uint16_t warnings, uint16_t statusFlags);
+
+  // hands the packets written so far to the socket
+  bool Flush();
+
+  uint8_t Seq() const { return seq_; }
+
+ private:
+  void BeginPacket();
+  bool EndPacket();
+  void FillHeader(std::size_t len);
+  void SplitPacket(std::size_t len);
+
+  void PutU8(uint8_t v) { buf_.PushData(&v, 1); }
+  void PutU16(uint16_t v);
+  void PutLenEncode(uint64_t v);
+  void PutLenEncodeString(const char *s, std::size_t len);
+
+  StreamSocket *sock_;
+  UnboundedBuffer buf_;
+  // offset of the header of the packet being written
+  std::size_t packetStart_;
+  uint8_t seq_;
+  std::size_t flushSize_;
+  std::size_t sendLimit_;
+};
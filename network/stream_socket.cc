@@ -15,17 +15,26 @@
 
 #include "stream_socket.h"
 
+#include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <netinet/tcp.h>
 #include <unistd.h>
 
+#include <algorithm>
+
+#include "common.h"
 #include "net_thread_pool.h"
 #include "server.h"
 
 using std::size_t;
 
-StreamSocket::StreamSocket() {}
+StreamSocket::StreamSocket()
+    : frameLeft_(0),
+      inFrame_(false),
+      frameLast_(true),
+      drainWaiting_(false),
+      drainLimit_(0) {}
 
 StreamSocket::~StreamSocket() {}
 
@@ -96,6 +105,35 @@ bool StreamSocket::SendPacket(UnboundedBuffer &ubf) {
   return SendPacket(ubf.ReadAddr(), ubf.ReadableSize());
 }
 
+void StreamSocket::OnSendDrained(size_t limit, const std::function<void()> &cb) {
+  {
+    std::lock_guard<std::mutex> guard(drainLock_);
+    assert(!onDrained_);
+    drainLimit_ = limit;
+    onDrained_ = cb;
+    drainWaiting_ = true;
+  }
+
+  // the send thread may have taken the data before the callback was set
+  _NotifySendDrained();
+}
+
+void StreamSocket::_NotifySendDrained() {
+  if (!drainWaiting_) return;
+
+  std::function<void()> cb;
+  {
+    std::lock_guard<std::mutex> guard(drainLock_);
+    if (!onDrained_) return;
+    if (sendBuf_.PendingBytes() > drainLimit_ && !Invalid()) return;
+
+    cb.swap(onDrained_);
+    drainWaiting_ = false;
+  }
+
+  cb();
+}
+
 bool StreamSocket::OnReadable() {
   int nBytes = StreamSocket::Recv();
 
@@ -128,11 +166,12 @@ bool StreamSocket::Send() {
     // register write event
   }
 
+  _NotifySendDrained();
   return nSent >= 0;
 }
 
 // EPOLLOUT
-bool StreamSocket::OnWriteable() {
+bool StreamSocket::OnWritable() {
   BufferSequence bf;
   sendBuf_.ProcessBuffer(bf);
 
@@ -150,12 +189,15 @@ bool StreamSocket::OnWriteable() {
     Internal::NetThreadPool::Instance().DisableWrite(shared_from_this());
   }
 
+  _NotifySendDrained();
   return nSent >= 0;
 }
 
 bool StreamSocket::OnError() {
   if (Socket::OnError()) {
     if (onDisconnect_) onDisconnect_();
+    // nothing is sent any more, a waiting producer gives up
+    _NotifySendDrained();
 
     return true;
   }
@@ -166,18 +208,57 @@ bool StreamSocket::OnError() {
 // deal with message
 bool StreamSocket::DoMsgParse() {
   bool busy = false;
-  while (!recvBuf_.IsEmpty()) {
-    BufferSequence datum;
-    recvBuf_.GetDatum(datum, recvBuf_.ReadableSize());
-
-    AttachedBuffer af(datum);
-    auto bodyLen = _HandlePacket(af.ReadAddr(), af.ReadableSize());
-    if (bodyLen > 0) {
-      busy = true;
-      recvBuf_.AdjustReadPtr(bodyLen);
-    } else {
-      break;
+  for (;;) {
+    if (!inFrame_) {
+      uint8_t header[4];
+      if (!recvBuf_.PeekDataAt(header, sizeof(header))) break;
+
+      std::size_t len = header[0] | (header[1] << 8) | (header[2] << 16);
+      frameLast_ = len < MAX_PACKET_PAYLOAD;
+
+      // a packet in one piece is handled where it is
+      if (packet_.IsEmpty() && frameLast_ &&
+          recvBuf_.ReadableSize() >= sizeof(header) + len) {
+        BufferSequence datum;
+        recvBuf_.GetDatum(datum, sizeof(header) + len);
+        if (datum.count == 1) {
+          _HandlePacket(static_cast<const char *>(datum.buffers[0].iov_base),
+                        sizeof(header) + len);
+          recvBuf_.AdjustReadPtr(sizeof(header) + len);
+          busy = true;
+          continue;
+        }
+      }
+
+      // the reply follows the sequence id of the last frame
+      if (packet_.IsEmpty())
+        packet_.PushData(header, sizeof(header));
+      else
+        packet_.ReadAddr()[3] = static_cast<char>(header[3]);
+
+      recvBuf_.AdjustReadPtr(sizeof(header));
+      frameLeft_ = len;
+      inFrame_ = true;
+    }
+
+    std::size_t n = std::min(frameLeft_, recvBuf_.ReadableSize());
+    if (n > 0) {
+      BufferSequence datum;
+      recvBuf_.GetDatum(datum, n);
+      for (std::size_t i = 0; i < datum.count; ++i)
+        packet_.PushData(datum.buffers[i].iov_base, datum.buffers[i].iov_len);
+      recvBuf_.AdjustReadPtr(n);
+      frameLeft_ -= n;
     }
+
+    if (frameLeft_ > 0) break;
+
+    inFrame_ = false;
+    if (!frameLast_) continue;
+
+    _HandlePacket(packet_.ReadAddr(), packet_.ReadableSize());
+    packet_.Clear();
+    busy = true;
   }
 
   return busy;
@@ -18,6 +18,10 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+
 #include "async_buffer.h"
 #include "socket.h"
 
@@ -42,9 +46,20 @@ class StreamSocket : public Socket {
   bool SendPacket(AttachedBuffer &abf);
   bool SendPacket(UnboundedBuffer &ubf);
 
-  bool OnReadable();
-  bool OnWriteable();
-  bool OnError();
+  // Bytes queued but not taken by the send thread yet.
+  std::size_t PendingSendBytes() const { return sendBuf_.PendingBytes(); }
+  // Calls cb once at most limit bytes are left to send, or once the
+  // connection is closed. That is right away if it is so already, or else
+  // on the send thread. One callback is waiting at a time.
+  void OnSendDrained(std::size_t limit, const std::function<void()> &cb);
+  // Called by a writer after queueing data, false once the connection is
+  // closed. A subclass may suspend the writer here while more than limit
+  // bytes are left to send.
+  virtual bool WaitSendBuffer(std::size_t /* limit */) { return !Invalid(); }
+
+  bool OnReadable() override;
+  bool OnWritable() override;
+  bool OnError() override;
 
   bool DoMsgParse();
 
@@ -65,6 +80,10 @@ class StreamSocket : public Socket {
 
   // send buf to peer
   int _Send(const BufferSequence &bf);
+  // calls the callback of OnSendDrained if it is time to
+  void _NotifySendDrained();
+  // msg is one complete packet starting with its 4-byte header, the
+  // payloads of a split packet are joined after the first header
   virtual PacketLength _HandlePacket(const char *msg, std::size_t len) = 0;
 
   enum {
@@ -75,5 +94,17 @@ class StreamSocket : public Socket {
 
   Buffer recvBuf_;
 
+  // a packet split by MAX_PACKET_PAYLOAD or by the recv buffer boundary
+  UnboundedBuffer packet_;
+  // payload bytes of the current frame not received yet
+  std::size_t frameLeft_;
+  bool inFrame_;
+  bool frameLast_;
+
   AsyncBuffer sendBuf_;
+
+  std::mutex drainLock_;
+  std::atomic<bool> drainWaiting_;
+  std::size_t drainLimit_;
+  std::function<void()> onDrained_;
 };
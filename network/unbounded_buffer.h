@@ -27,6 +27,8 @@ class UnboundedBuffer {
   std::size_t PushData(const void* pData, std::size_t nSize);
   std::size_t Write(const void* pData, std::size_t nSize);
   void AdjustWritePtr(std::size_t nBytes) { writePos_ += nBytes; }
+  // drops the data after the first nBytes readable ones
+  void Truncate(std::size_t nBytes) { writePos_ = readPos_ + nBytes; }
 
   std::size_t PeekDataAt(void* pBuf, std::size_t nSize, std::size_t offset = 0);
   std::size_t PeekData(void* pBuf, std::size_t nSize);
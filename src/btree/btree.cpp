@@ -1,12 +1,24 @@
 #include "btree.h"
 #include "../algo/search.h"
 
-template<typename KeyType, typename Comparer, typename Copier>
-btree<KeyType, Comparer, Copier>::btree(
+static bool is_interior(uint16_t magic)
+{
+	return magic == PAGE_FIXED || magic == PAGE_VARKEY;
+}
+
+static bool is_leaf(uint16_t magic)
+{
+	return magic == PAGE_VARIANT || magic == PAGE_INDEX_LEAF || magic == PAGE_VARKEY_LEAF;
+}
+
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::btree(
 		pager *pg, int root_page_id, int field_size,
 		Comparer compare, Copier copier)
 	: pg(pg), root_page_id(root_page_id),
-	  field_size(field_size), compare(compare), copy_to_temp(copier)
+	  field_size(field_size), compare(compare), copy_to_temp(copier),
+	  separator_buf(field_size)
 {
 	if(root_page_id == 0)
 	{
@@ -15,94 +27,126 @@ btree<KeyType, Comparer, Copier>::btree(
 	}
 }
 
-template<typename KeyType, typename Comparer, typename Copier>
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+typename btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::key_t
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::split_key(interior_page lower, interior_page)
+{
+	// the last key of the lower half separates its last child from the upper half
+	return copy_to_temp(lower.get_key(lower.size() - 1));
+}
+
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+typename btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::key_t
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::split_key(leaf_page lower, leaf_page upper)
+{
+	return copy_to_temp(leaf_page::separator(
+		lower.get_key(lower.size() - 1), upper.get_key(0), separator_buf.data()));
+}
+
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+typename btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::key_t
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::separator_at(interior_page page, int pos)
+{
+	return page.get_key(pos);
+}
+
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+typename btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::key_t
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::separator_at(leaf_page page, int pos)
+{
+	return leaf_page::separator(page.get_key(pos),
+		page.get_key(pos + 1), separator_buf.data());
+}
+
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
 template<typename Page>
-inline void btree<KeyType, Comparer, Copier>::insert_split_root(insert_ret ret)
+inline void btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::insert_split_root(insert_ret ret)
 {
 	if(ret.split)
 	{
 		debug_puts("B-tree split root.");
+		key_t key = split_key(Page { ret.lower_half, pg }, Page { ret.upper_half, pg });
 		int new_pid = pg->new_page();
 		interior_page page { pg->read_for_write(new_pid), pg };
 		page.init(field_size);
 
-		Page lower { ret.lower_half, pg };
-		Page upper { ret.upper_half, pg };
-		page.insert(0, lower.get_key(lower.size() - 1), root_page_id);
-		page.insert(1, upper.get_key(upper.size() - 1), ret.upper_pid);
+		// the key of the last child is not compared
+		page.insert(0, key, root_page_id);
+		page.insert(1, key, ret.upper_pid);
 		root_page_id = new_pid;
 	}
 }
 
-template<typename KeyType, typename Comparer, typename Copier>
-void btree<KeyType, Comparer, Copier>::insert(
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+void btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::insert(
 		key_t key, const char *data, int data_size)
 {
 	char *addr = pg->read_for_write(root_page_id);
 	uint16_t magic = general_page::get_magic_number(addr);
-	if(magic == PAGE_FIXED)
+	if(is_interior(magic))
 	{
 		insert_ret ret = insert_interior(
 			root_page_id, addr, key, data, data_size);
 		insert_split_root<interior_page>(ret);
 	} else {
-		assert(magic == PAGE_VARIANT || magic == PAGE_INDEX_LEAF);
+		assert(is_leaf(magic));
 		insert_ret ret = insert_leaf(
 			root_page_id, addr, key, data, data_size);
 		insert_split_root<leaf_page>(ret);
 	}
 }
 
-template<typename KeyType, typename Comparer, typename Copier>
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
 template<typename Page, typename ChPage>
-inline typename btree<KeyType, Comparer, Copier>::insert_ret
-btree<KeyType, Comparer, Copier>::insert_post_process(
+inline typename btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::insert_ret
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::insert_post_process(
 	int pid, int ch_pid, int ch_pos, insert_ret ch_ret)
 {
 	insert_ret ret;
 	ret.split = false;
+	if(!ch_ret.split)
+		return ret;
+
+	// the upper half of the child takes its key
 	Page page { pg->read_for_write(pid), pg };
-	if(ch_ret.split)
+	key_t key = split_key(ChPage { ch_ret.lower_half, pg }, ChPage { ch_ret.upper_half, pg });
+	page.set_child(ch_pos, ch_ret.upper_pid);
+	bool succ_ins = page.insert(ch_pos, key, ch_pid);
+	if(!succ_ins)
 	{
-		ChPage lower_ch { ch_ret.lower_half, pg };
-		ChPage upper_ch { ch_ret.upper_half, pg };
-		page.set_key(ch_pos, lower_ch.get_key(lower_ch.size() - 1));
-		key_t ch_largest = copy_to_temp(upper_ch.get_key(upper_ch.size() - 1));
-		bool succ_ins = page.insert(ch_pos + 1, ch_largest, ch_ret.upper_pid);
-		if(!succ_ins)
+		auto upper = page.split(pid);
+		Page upper_page = upper.second;
+		Page lower_page = page;
+		if(ch_pos < lower_page.size())
 		{
-			auto upper = page.split(pid);
-			Page upper_page = upper.second;
-			Page lower_page = page;
-			if(ch_pos < lower_page.size())
-			{
-				succ_ins = lower_page.insert(
-					ch_pos + 1, ch_largest, ch_ret.upper_pid);
-				assert(succ_ins);
-			} else {
-				succ_ins = upper_page.insert(
-					ch_pos - lower_page.size() + 1,
-					ch_largest, ch_ret.upper_pid
-				);
-				assert(succ_ins);
-			}
-
-			ret.split = true;
-			ret.lower_half = lower_page.buf;
-			ret.upper_half = upper_page.buf;
-			ret.upper_pid  = upper.first;
+			succ_ins = lower_page.insert(ch_pos, key, ch_pid);
+			assert(succ_ins);
+		} else {
+			succ_ins = upper_page.insert(
+				ch_pos - lower_page.size(), key, ch_pid);
+			assert(succ_ins);
 		}
-	} else {
-		ChPage ch_page { pg->read(ch_pid), pg };
-		page.set_key(ch_pos, ch_page.get_key(ch_page.size() - 1));
+
+		ret.split = true;
+		ret.lower_half = lower_page.buf;
+		ret.upper_half = upper_page.buf;
+		ret.upper_pid  = upper.first;
 	}
 
 	return ret;
 }
 
-template<typename KeyType, typename Comparer, typename Copier>
-typename btree<KeyType, Comparer, Copier>::insert_ret
-btree<KeyType, Comparer, Copier>::insert_interior(
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+typename btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::insert_ret
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::insert_interior(
 	int now, char* addr, key_t key, const char *data, int data_size)
 {
 	interior_page page { addr, pg };
@@ -117,7 +161,7 @@ btree<KeyType, Comparer, Copier>::insert_interior(
 	char *ch_addr = pg->read_for_write(ch_pid);
 	uint16_t ch_magic = general_page::get_magic_number(ch_addr);
 
-	if(ch_magic == PAGE_FIXED)
+	if(is_interior(ch_magic))
 	{
 		auto ch_ret = insert_interior(ch_pid, ch_addr, key, data, data_size);
 		return insert_post_process<interior_page, interior_page>(
@@ -125,7 +169,7 @@ btree<KeyType, Comparer, Copier>::insert_interior(
 		);
 	} else {
 		// leaf page
-		assert(ch_magic == PAGE_VARIANT || ch_magic == PAGE_INDEX_LEAF);
+		assert(is_leaf(ch_magic));
 		auto ch_ret = insert_leaf(ch_pid, ch_addr, key, data, data_size);
 		return insert_post_process<interior_page, leaf_page>(
 			now, ch_pid, ch_pos, ch_ret
@@ -133,9 +177,10 @@ btree<KeyType, Comparer, Copier>::insert_interior(
 	}
 }
 
-template<typename KeyType, typename Comparer, typename Copier>
-typename btree<KeyType, Comparer, Copier>::insert_ret 
-btree<KeyType, Comparer, Copier>::insert_leaf(
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+typename btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::insert_ret 
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::insert_leaf(
 	int now, char* addr, key_t key, const char *data, int data_size)
 {
 	leaf_page page { addr, pg };
@@ -178,20 +223,22 @@ btree<KeyType, Comparer, Copier>::insert_leaf(
 	return ret;
 }
 
-template<typename KeyType, typename Comparer, typename Copier>
-typename btree<KeyType, Comparer, Copier>::search_result 
-btree<KeyType, Comparer, Copier>::lower_bound(key_t key)
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+typename btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::search_result 
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::lower_bound(key_t key)
 {
 	return lower_bound(root_page_id, key);
 }
 
-template<typename KeyType, typename Comparer, typename Copier>
-typename btree<KeyType, Comparer, Copier>::search_result
-btree<KeyType, Comparer, Copier>::lower_bound(int now, key_t key)
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+typename btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::search_result
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::lower_bound(int now, key_t key)
 {
 	char *addr = pg->read_for_write(now);
 	uint16_t magic = general_page::get_magic_number(addr);
-	if(magic == PAGE_FIXED)
+	if(is_interior(magic))
 	{
 		interior_page page { addr, pg };
 		int ch_pos = ::lower_bound(0, page.size(), [&](int id) {
@@ -201,81 +248,119 @@ btree<KeyType, Comparer, Copier>::lower_bound(int now, key_t key)
 		ch_pos = std::min(page.size() - 1, ch_pos);
 		return lower_bound(page.get_child(ch_pos), key);
 	} else {
-		assert(magic == PAGE_VARIANT || magic == PAGE_INDEX_LEAF);
+		assert(is_leaf(magic));
 		leaf_page page { addr, pg };
 		int pos = ::lower_bound(0, page.size(), [&](int id) {
 			return compare(page.get_key(id), key) < 0;
 		} );
 
+		// the key of this page in its parent is only an upper bound, so
+		// the entry may be the first one of the next page
 		if(pos == page.size())
-			return { 0, 0 };
+			return { page.next_page(), 0 };
 		else return { now, pos };
 	}
 }
 
-template<typename KeyType, typename Comparer, typename Copier>
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+typename btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::search_result
+btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::last()
+{
+	int now = root_page_id;
+	for(;;)
+	{
+		char *addr = pg->read(now);
+		uint16_t magic = general_page::get_magic_number(addr);
+		if(is_interior(magic))
+		{
+			interior_page page { addr, pg };
+			now = page.get_child(page.size() - 1);
+		} else {
+			assert(is_leaf(magic));
+			leaf_page page { addr, pg };
+			if(page.size() == 0)
+				return { 0, 0 };
+			return { now, page.size() - 1 };
+		}
+	}
+}
+
+/* Fix the child at ch_pos of page after an element is erased from it.
+ * An underflowed child borrows an element from or is merged with its
+ * siblings, only those under the same parent, so that the keys of the
+ * parent keep separating the children. The last key of an interior page
+ * is never compared, so the key in the parent takes its place when the
+ * elements of interior children are moved. The keys of varkey pages may
+ * not fit after that, and then the child is left underflowed. */
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
 template<typename Page>
-typename btree<KeyType, Comparer, Copier>::merge_ret
-btree<KeyType, Comparer, Copier>::erase_try_merge(int pid, char *addr)
+void btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::erase_fix_child(interior_page &page, int ch_pos)
 {
-	Page page { addr, pg };
+	int ch_pid = page.get_child(ch_pos);
+	Page ch_page { pg->read_for_write(ch_pid), pg };
+	int next_pid = ch_pos + 1 < page.size() ? page.get_child(ch_pos + 1) : 0;
+	int prev_pid = ch_pos > 0 ? page.get_child(ch_pos - 1) : 0;
+	if(!ch_page.underflow())
+		return;
 
-	if(page.underflow())
+	if(next_pid)
 	{
-		char *next_addr = nullptr, *prev_addr = nullptr;
-		if(page.next_page())
+		Page next_page { pg->read_for_write(next_pid), pg };
+		if(!next_page.underflow_if_remove(0))
 		{
-			next_addr = pg->read(page.next_page());
-			Page next_page { next_addr, pg };
-			if(!next_page.underflow_if_remove(0))
+			key_t ch_key = copy_to_temp(page.get_key(ch_pos));
+			if(page.replace_key(ch_pos, separator_at(next_page, 0)))
 			{
-				pg->mark_dirty(page.next_page());
-				page.move_from(next_page, 0, page.size());
-				return { false, false, 0 };
+				replace_child_key(ch_page, ch_page.size() - 1, ch_key);
+				ch_page.move_from(next_page, 0, ch_page.size());
+				return;
 			}
 		}
+	}
 
-		if(page.prev_page())
+	if(prev_pid)
+	{
+		Page prev_page { pg->read_for_write(prev_pid), pg };
+		int last = prev_page.size() - 1;
+		if(!prev_page.underflow_if_remove(last))
 		{
-			prev_addr = pg->read(page.prev_page());
-			Page prev_page { prev_addr, pg };
-			if(!prev_page.underflow_if_remove(prev_page.size() - 1))
+			key_t prev_key = copy_to_temp(page.get_key(ch_pos - 1));
+			if(page.replace_key(ch_pos - 1, separator_at(prev_page, last - 1)))
 			{
-				pg->mark_dirty(page.prev_page());
-				page.move_from(prev_page, prev_page.size() - 1, 0);
-				return { false, false, 0 };
+				ch_page.move_from(prev_page, last, 0);
+				replace_child_key(ch_page, 0, prev_key);
+				return;
 			}
 		}
+	}
 
-		if(next_addr)
+	if(next_pid && replace_child_key(ch_page, ch_page.size() - 1, page.get_key(ch_pos))
+		&& ch_page.merge({ pg->read_for_write(next_pid), pg }, ch_pid))
+	{
+		pg->free_page(next_pid);
+		page.set_child(ch_pos + 1, ch_pid);
+		page.erase(ch_pos);
+	} else if(prev_pid) {
+		Page prev_page { pg->read_for_write(prev_pid), pg };
+		if(replace_child_key(prev_page, prev_page.size() - 1, page.get_key(ch_pos - 1))
+			&& prev_page.merge(ch_page, prev_pid))
 		{
-			int next_pid = page.next_page();
-			bool succ_merge = page.merge( { next_addr, pg }, pid);
-			UNUSED(succ_merge);
-			assert(succ_merge);
-			pg->free_page(next_pid);
-			return { false, true, pid };
-		} else if(prev_addr) {
-			int prev_pid = page.prev_page();
-			Page prev_page { prev_addr, pg };
-			bool succ_merge = prev_page.merge(page, prev_pid);
-			UNUSED(succ_merge);
-			assert(succ_merge);
-			pg->free_page(pid);
-			return { true, false, prev_pid };
+			pg->free_page(ch_pid);
+			page.set_child(ch_pos, prev_pid);
+			page.erase(ch_pos - 1);
 		}
-	} 
-
-	return { false, false, 0 };
+	}
 }
 
-template<typename KeyType, typename Comparer, typename Copier>
-typename btree<KeyType, Comparer, Copier>::erase_ret
-btree<KeyType, Comparer, Copier>::erase(int now, key_t key)
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+bool btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::erase(int now, key_t key)
 {
 	char *addr = pg->read_for_write(now);
 	uint16_t magic = general_page::get_magic_number(addr);
-	if(magic == PAGE_FIXED)
+	if(is_interior(magic))
 	{
 		interior_page page { addr, pg };
 		int ch_pos = ::lower_bound(0, page.size(), [&](int id) {
@@ -283,54 +368,39 @@ btree<KeyType, Comparer, Copier>::erase(int now, key_t key)
 		} );
 
 		ch_pos = std::min(page.size() - 1, ch_pos);
-		erase_ret ret = erase(page.get_child(ch_pos), key);
-
-		if(!ret.found) return ret;
-
-		addr = pg->read_for_write(now);
-		page = interior_page { addr, pg };
-		if(ret.merged_right)
-		{
-			page.erase(ch_pos + 1);
-			page.set_key(ch_pos, ret.largest);
-			page.set_child(ch_pos, ret.merged_pid);
-		} else if(ret.merged_left) {
-			page.erase(ch_pos);
-			page.set_key(ch_pos - 1, ret.largest);
-			page.set_child(ch_pos - 1, ret.merged_pid);
-		} else {
-			page.set_key(ch_pos, ret.largest);
-		}
-
-		merge_ret mret = erase_try_merge<interior_page>(now, addr);
-		return { true, mret.merged_left, mret.merged_right,
-			mret.merged_pid, copy_to_temp(page.get_key(page.size() - 1)) };
+		int ch_pid = page.get_child(ch_pos);
+		if(!erase(ch_pid, key))
+			return false;
+
+		page = interior_page { pg->read_for_write(now), pg };
+		if(is_interior(general_page::get_magic_number(pg->read(ch_pid))))
+			erase_fix_child<interior_page>(page, ch_pos);
+		else erase_fix_child<leaf_page>(page, ch_pos);
+		return true;
 	} else {
-		assert(magic == PAGE_VARIANT || magic == PAGE_INDEX_LEAF);
+		assert(is_leaf(magic));
 		leaf_page page { addr, pg };
 		int pos = ::lower_bound(0, page.size(), [&](int id) {
 			return compare(page.get_key(id), key) < 0;
 		} );
 
 		if(pos == page.size() || compare(page.get_key(pos), key) != 0)
-			return { false, false, false, 0, 0};
+			return false;
 
 		page.erase(pos);
-		auto ret = erase_try_merge<leaf_page>(now, addr);
-
-		return { true, ret.merged_left, ret.merged_right, ret.merged_pid,
-			now == root_page_id ? 0 : copy_to_temp(page.get_key(page.size() - 1)) };
+		return true;
 	}
 }
 
-template<typename KeyType, typename Comparer, typename Copier>
-bool btree<KeyType, Comparer, Copier>::erase(key_t key)
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage, typename LeafPage>
+bool btree<KeyType, Comparer, Copier, InteriorPage, LeafPage>::erase(key_t key)
 {
-	erase_ret ret = erase(root_page_id, key);
+	bool found = erase(root_page_id, key);
 
 	char *addr = pg->read_for_write(root_page_id);
 	uint16_t magic = general_page::get_magic_number(addr);
-	if(magic == PAGE_FIXED)
+	if(is_interior(magic))
 	{
 		interior_page page { addr, pg };
 		if(page.size() == 1 && page.get_child(0))
@@ -341,7 +411,7 @@ bool btree<KeyType, Comparer, Copier>::erase(key_t key)
 		}
 	}
 
-	return ret.found;
+	return found;
 }
 
 /* Explicitly instantiate templates */
@@ -350,3 +420,8 @@ template class btree<const char*,
 		 index_btree::comparer_t,
 		 __impl::index_btree_copier_t
 	 >;
+template class btree<const char*,
+		 index_btree::comparer_t,
+		 __impl::varkey_btree_copier_t,
+		 varkey_page, varkey_leaf_page
+	 >;
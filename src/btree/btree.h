@@ -6,28 +6,36 @@
 #include "../page/fixed_page.h"
 #include "../page/data_page.h"
 #include "../page/index_leaf_page.h"
+#include "../page/varkey_page.h"
 #include <functional>
 #include <memory>
 #include <type_traits>
+#include <vector>
 
 /* Each node of the b-tree is a page.
- * For an interior node, the key of a page element is the largest
- * element of its children. */
-
-template<typename KeyType, typename Comparer, typename Copier>
+ * For an interior node, the key of a page element separates its child
+ * from the next one: it is not less than the elements of the child,
+ * and less than those of the next child. The key of the last child is
+ * never compared, as the elements larger than the others go there. */
+
+template<typename KeyType, typename Comparer, typename Copier,
+	typename InteriorPage = fixed_page<KeyType>,
+	typename LeafPage = typename std::conditional<
+		std::is_same<KeyType, const char*>::value,
+		index_leaf_page<KeyType>,
+		data_page<KeyType>>::type>
 class btree
 {
 	pager *pg;
 	int root_page_id, field_size;
 	Comparer compare;
 	Copier copy_to_temp;
+	// separators of leaves are built here
+	std::vector<char> separator_buf;
 public:
 	typedef KeyType key_t;
-	typedef fixed_page<key_t> interior_page;
-	typedef typename std::conditional<
-		std::is_same<KeyType, const char*>::value,
-		index_leaf_page<key_t>,
-		data_page<key_t>>::type leaf_page;
+	typedef InteriorPage interior_page;
+	typedef LeafPage leaf_page;
 	typedef std::pair<int, int> search_result;  // (page_id, pos)
 public:
 	/* create/load a btree
@@ -40,6 +48,8 @@ public:
 	bool erase(key_t key);
 	// the first element x for which x >= key
 	search_result lower_bound(key_t key);
+	// the largest element, (0, 0) if the tree is empty
+	search_result last();
 
 	int get_root_page_id() { return root_page_id; }
 
@@ -51,20 +61,15 @@ private:
 		char *lower_half, *upper_half;
 	};
 
-	struct erase_ret
-	{
-		bool found;
-		bool merged_left, merged_right;
-		int merged_pid;
-		key_t largest;
-	};
-
-	struct merge_ret
-	{
-		bool merged_left, merged_right;
-		int merged_pid;
-	};
-
+	// the key separating the lower half of a split page from the upper
+	key_t split_key(interior_page lower, interior_page upper);
+	key_t split_key(leaf_page lower, leaf_page upper);
+	// the key separating the elements of page up to pos from the others
+	key_t separator_at(interior_page page, int pos);
+	key_t separator_at(leaf_page page, int pos);
+	// leaves have no keys of children
+	bool replace_child_key(interior_page page, int pos, key_t key) { return page.replace_key(pos, key); }
+	bool replace_child_key(leaf_page, int, key_t) { return true; }
 	template<typename Page, typename ChPage>
 	insert_ret insert_post_process(int, int, int, insert_ret);
 	template<typename Page>
@@ -72,9 +77,9 @@ private:
 	insert_ret insert_interior(int, char*, key_t, const char*, int);
 	insert_ret insert_leaf(int, char*, key_t, const char*, int);
 	search_result lower_bound(int now, key_t key);
-	erase_ret erase(int, key_t);
+	bool erase(int, key_t);
 	template<typename Page>
-	merge_ret erase_try_merge(int pid, char *addr);
+	void erase_fix_child(interior_page &page, int ch_pos);
 };
 
 class int_btree : public btree<int, int(*)(int, int), int(*)(int)>
@@ -110,6 +115,20 @@ namespace __impl
 			return buf.get();
 		}
 	};
+
+	// keys in varkey pages end at the terminating zero of the string
+	struct varkey_btree_copier_t : index_btree_copier_t
+	{
+		using index_btree_copier_t::index_btree_copier_t;
+
+		char *operator () (const char *src)
+		{
+			const int prefix = sizeof(int) + 1;
+			std::memcpy(buf.get(), src, prefix);
+			std::strncpy(buf.get() + prefix, src + prefix, size - prefix);
+			return buf.get();
+		}
+	};
 }
 
 class index_btree : public btree<const char*,
@@ -138,4 +157,33 @@ public:
 	}
 };
 
+// index on a VARCHAR column keeping the keys with their actual lengths
+class varkey_btree : public btree<const char*,
+	std::function<int(const char*, const char*)>,
+	__impl::varkey_btree_copier_t,
+	varkey_page, varkey_leaf_page>
+{
+	typedef std::function<int(const char*, const char*)> comparer_t;
+	typedef btree<const char*, comparer_t,
+		__impl::varkey_btree_copier_t,
+		varkey_page, varkey_leaf_page> base_class;
+public:
+	varkey_btree(pager *pg,
+			int root_page_id,
+			int size,
+			comparer_t comparer
+		) : btree(
+			pg,
+			root_page_id,
+			size,
+			comparer,
+			__impl::varkey_btree_copier_t(size)
+		) {}
+
+	void insert(const char* key, int rid)
+	{
+		base_class::insert(key, key, rid);
+	}
+};
+
 #endif
@@ -19,7 +19,8 @@ private:
 		if(p)
 		{
 			PageType page { pg->read(p), pg };
-			assert(page.magic() == PAGE_VARIANT || page.magic() == PAGE_INDEX_LEAF);
+			assert(page.magic() == PAGE_VARIANT || page.magic() == PAGE_INDEX_LEAF
+				|| page.magic() == PAGE_VARKEY_LEAF);
 			cur_size = page.size();
 			next_pid = page.next_page();
 			prev_pid = page.prev_page();
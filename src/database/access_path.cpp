@@ -0,0 +1,467 @@
+#include "access_path.h"
+#include "dbms.h"
+#include "../expression/expression.h"
+#include "../utils/type_cast.h"
+#include "external_sort.h"
+#include "../utils/like_matcher.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+const char *literal_key(const expr_node_t *expr, int col_type)
+{
+	if(!expr || expr->op != OPERATOR_NONE
+		|| typecast::column_to_term(col_type) != expr->term_type)
+		return nullptr;
+
+	switch(expr->term_type)
+	{
+		case TERM_INT:
+		case TERM_DATE:
+			return (const char*)&expr->val_i;
+		case TERM_FLOAT:
+			return (const char*)&expr->val_f;
+		case TERM_STRING:
+			return expr->val_s;
+		default:
+			return nullptr;
+	}
+}
+
+static operator_type_t flip_compare(operator_type_t op)
+{
+	switch(op)
+	{
+		case OPERATOR_GT:  return OPERATOR_LT;
+		case OPERATOR_LT:  return OPERATOR_GT;
+		case OPERATOR_GEQ: return OPERATOR_LEQ;
+		case OPERATOR_LEQ: return OPERATOR_GEQ;
+		default: return op;
+	}
+}
+
+static double index_scan_cost(double rows)
+{
+	return COST_INDEX_DESCENT + rows * (COST_INDEX_ENTRY + COST_RANDOM_PAGE + COST_TUPLE);
+}
+
+// the least string greater than all strings beginning with prefix, empty if none
+static std::string prefix_successor(std::string prefix)
+{
+	while(!prefix.empty() && (unsigned char)prefix.back() == 0xff)
+		prefix.pop_back();
+	if(!prefix.empty())
+		prefix.back() = (char)((unsigned char)prefix.back() + 1);
+	return prefix;
+}
+
+static index_range_t &range_of(index_range_t *ranges, bool *has_range, int cid, index_manager *index)
+{
+	index_range_t &r = ranges[cid];
+	if(!has_range[cid])
+	{
+		has_range[cid] = true;
+		r.cid = cid;
+		r.index = index;
+		r.lo = r.hi = nullptr;
+		r.lo_expr = r.hi_expr = nullptr;
+		r.lo_inclusive = r.hi_inclusive = true;
+		r.with_null = r.backward = false;
+		r.selectivity = 1;
+	}
+
+	return r;
+}
+
+// narrow the range by (key op), where op is =, <, <=, > or >=
+static void add_bound(index_range_t &r, operator_type_t op, const char *key,
+	const expr_node_t *expr, const std::shared_ptr<const std::string> &owner)
+{
+	if(op == OPERATOR_EQ || op == OPERATOR_GT || op == OPERATOR_GEQ)
+	{
+		bool inclusive = op != OPERATOR_GT;
+		int c = r.lo ? r.index->compare(key, r.lo) : 1;
+		if(c > 0 || (c == 0 && !inclusive))
+		{
+			r.lo = key;
+			r.lo_expr = expr;
+			r.lo_key = owner;
+			r.lo_inclusive = inclusive;
+		}
+	}
+
+	if(op == OPERATOR_EQ || op == OPERATOR_LT || op == OPERATOR_LEQ)
+	{
+		bool inclusive = op != OPERATOR_LT;
+		int c = r.hi ? r.index->compare(key, r.hi) : -1;
+		if(c < 0 || (c == 0 && !inclusive))
+		{
+			r.hi = key;
+			r.hi_expr = expr;
+			r.hi_key = owner;
+			r.hi_inclusive = inclusive;
+		}
+	}
+}
+
+// strings LIKE the pattern are in [prefix, successor) of its literal prefix,
+// the keys are padded to key_size since the index reads that many bytes
+static void add_like_bounds(index_range_t &r, const like_matcher &pattern, int key_size)
+{
+	std::string prefix = pattern.literal_prefix();
+	auto lo = std::make_shared<const std::string>(prefix + std::string(key_size - prefix.size(), 0));
+	if(pattern.get_kind() == like_matcher::EXACT)
+	{
+		add_bound(r, OPERATOR_EQ, lo->c_str(), nullptr, lo);
+		return;
+	}
+
+	add_bound(r, OPERATOR_GEQ, lo->c_str(), nullptr, lo);
+	std::string next = prefix_successor(prefix);
+	if(!next.empty())
+	{
+		auto hi = std::make_shared<const std::string>(next + std::string(key_size - next.size(), 0));
+		add_bound(r, OPERATOR_LT, hi->c_str(), nullptr, hi);
+	}
+}
+
+// the values of an IN list as keys of column cid, false if one of them
+// is not of the type of the column. Strings too long for the column
+// match no key and are left out.
+static bool in_list_keys(table_manager *table, int cid,
+	const expr_node_t *list, std::vector<std::string> &keys)
+{
+	if(list->op != OPERATOR_NONE || list->term_type != TERM_LITERAL_LIST)
+		return false;
+
+	int col_type = table->get_column_type(cid);
+	size_t key_size = table->get_column_length(cid);
+	for(linked_list_t *l_ptr = list->literal_list; l_ptr; l_ptr = l_ptr->next)
+	{
+		const expr_node_t *val = (const expr_node_t*)l_ptr->data;
+		if(col_type == COL_TYPE_VARCHAR)
+		{
+			if(val->term_type != TERM_STRING && val->term_type != TERM_DATE)
+				return false;
+			size_t len = std::strlen(val->val_s);
+			if(len < key_size)
+				keys.push_back(std::string(val->val_s, len) + std::string(key_size - len, 0));
+			continue;
+		}
+
+		// date literals are strings until evaluated
+		expression v;
+		try {
+			v = expression::eval(val);
+		} catch(const char *) {
+			return false;
+		}
+
+		if(v.type != typecast::column_to_term(col_type))
+			return false;
+		if(v.type == TERM_FLOAT)
+			keys.emplace_back((const char*)&v.val_f, sizeof(float));
+		else if(v.type == TERM_INT || v.type == TERM_DATE)
+			keys.emplace_back((const char*)&v.val_i, sizeof(int));
+		else return false;
+	}
+
+	return true;
+}
+
+// narrow the range to the keys, which are both in r.points if it has them
+static void add_points(index_range_t &r, std::vector<std::string> keys)
+{
+	index_manager *index = r.index;
+	auto less = [index](const std::string &a, const std::string &b) {
+		return index->compare(a.data(), b.data()) < 0;
+	};
+	auto equal = [index](const std::string &a, const std::string &b) {
+		return index->compare(a.data(), b.data()) == 0;
+	};
+
+	std::sort(keys.begin(), keys.end(), less);
+	keys.erase(std::unique(keys.begin(), keys.end(), equal), keys.end());
+	if(r.points)
+	{
+		std::vector<std::string> common;
+		std::set_intersection(r.points->begin(), r.points->end(),
+			keys.begin(), keys.end(), std::back_inserter(common), less);
+		keys.swap(common);
+	}
+
+	r.points = std::make_shared<const std::vector<std::string>>(std::move(keys));
+}
+
+// drop the points out of [lo, hi] of r, or not in the index by its bloom
+// filter, and make r a range of the points only
+static void restrict_points(index_range_t &r)
+{
+	auto points = std::make_shared<std::vector<std::string>>();
+	for(const std::string &key : *r.points)
+	{
+		const char *k = key.data();
+		if(r.lo)
+		{
+			int c = r.index->compare(k, r.lo);
+			if(c < 0 || (c == 0 && !r.lo_inclusive))
+				continue;
+		}
+
+		if(r.hi)
+		{
+			int c = r.index->compare(k, r.hi);
+			if(c > 0 || (c == 0 && !r.hi_inclusive))
+				continue;
+		}
+
+		if(r.index->may_contain(k))
+			points->push_back(key);
+	}
+
+	r.points = points;
+	r.lo = r.hi = nullptr;
+	r.lo_expr = r.hi_expr = nullptr;
+	r.lo_key.reset();
+	r.hi_key.reset();
+}
+
+access_path_t choose_access_path(table_manager *table, expr_node_t *cond)
+{
+	std::vector<expr_node_t*> and_cond;
+	dbms::extract_and_cond(cond, and_cond);
+	return choose_access_path(table, and_cond);
+}
+
+access_path_t choose_access_path(table_manager *table, const std::vector<expr_node_t*> &and_cond)
+{
+	access_path_t path;
+	path.type  = access_path_t::FULL_SCAN;
+	path.table = table;
+	path.empty = false;
+
+	double row_num = table->estimate_row_num();
+	double selectivity = 1;
+	for(expr_node_t *expr : and_cond)
+		selectivity *= table->estimate_selectivity(expr);
+	path.rows = row_num * selectivity;
+	path.cost = table->estimate_page_num() * COST_SEQ_PAGE + row_num * COST_TUPLE;
+
+	// merge the bounds on the same indexed column
+	index_range_t ranges[MAX_COL_NUM];
+	bool has_range[MAX_COL_NUM] = { false };
+	for(expr_node_t *expr : and_cond)
+	{
+		operator_type_t op = expr->op;
+		if(op != OPERATOR_EQ && op != OPERATOR_LT && op != OPERATOR_LEQ
+			&& op != OPERATOR_GT && op != OPERATOR_GEQ
+			&& op != OPERATOR_LIKE && op != OPERATOR_IN)
+			continue;
+
+		const expr_node_t *col = expr->left, *val = expr->right;
+		if(op != OPERATOR_LIKE && op != OPERATOR_IN && val->term_type == TERM_COLUMN_REF)
+		{
+			std::swap(col, val);
+			op = flip_compare(op);
+		}
+
+		if(col->term_type != TERM_COLUMN_REF)
+			continue;
+		if(col->column_ref->table && std::strcmp(col->column_ref->table, table->get_table_name()) != 0)
+			continue;
+
+		int cid = table->lookup_column(col->column_ref->column);
+		if(cid < 0) continue;
+		index_manager *index = table->get_index(cid);
+		if(!index) continue;
+
+		if(op == OPERATOR_LIKE)
+		{
+			if(table->get_column_type(cid) != COL_TYPE_VARCHAR
+				|| val->op != OPERATOR_NONE || val->term_type != TERM_STRING)
+				continue;
+			// a prefix as long as the column matches no key
+			like_matcher pattern(val->val_s);
+			size_t prefix_len = pattern.literal_prefix().size();
+			int key_size = table->get_column_length(cid);
+			if(prefix_len == 0 || prefix_len >= (size_t)key_size)
+				continue;
+			index_range_t &r = range_of(ranges, has_range, cid, index);
+			r.selectivity *= table->estimate_selectivity(expr);
+			add_like_bounds(r, pattern, key_size);
+			continue;
+		}
+
+		if(op == OPERATOR_IN)
+		{
+			std::vector<std::string> keys;
+			if(!in_list_keys(table, cid, val, keys))
+				continue;
+			index_range_t &r = range_of(ranges, has_range, cid, index);
+			r.selectivity *= table->estimate_selectivity(expr);
+			add_points(r, std::move(keys));
+			continue;
+		}
+
+		const char *key = literal_key(val, table->get_column_type(cid));
+		if(!key) continue;
+
+		index_range_t &r = range_of(ranges, has_range, cid, index);
+		r.selectivity *= table->estimate_selectivity(expr);
+		add_bound(r, op, key, val, nullptr);
+	}
+
+	std::vector<index_range_t> candidates;
+	for(int i = 0; i < table->get_column_num(); ++i)
+	{
+		if(!has_range[i]) continue;
+		index_range_t &r = ranges[i];
+		if(r.points)
+			restrict_points(r);
+		if((r.is_point() && !r.index->may_contain(r.lo)) || (r.points && r.points->empty()))
+		{
+			path.type = access_path_t::INDEX_SCAN;
+			path.range[0] = r;
+			path.rows = path.cost = 0;
+			path.empty = true;
+			return path;
+		}
+
+		candidates.push_back(r);
+	}
+
+	std::sort(candidates.begin(), candidates.end(),
+		[](const index_range_t &a, const index_range_t &b) {
+			return a.selectivity < b.selectivity;
+		} );
+
+	for(const index_range_t &r : candidates)
+	{
+		// the index is descended once for each point
+		double cost = index_scan_cost(row_num * r.selectivity);
+		if(r.points)
+			cost += (r.points->size() - 1) * COST_INDEX_DESCENT;
+		if(cost < path.cost)
+		{
+			path.type = access_path_t::INDEX_SCAN;
+			path.range[0] = r;
+			path.cost = cost;
+		}
+	}
+
+	if(candidates.size() >= 2)
+	{
+		// only the rids matched by both indices are read
+		const index_range_t &a = candidates[0], &b = candidates[1];
+		double cost = 2 * COST_INDEX_DESCENT
+			+ row_num * (a.selectivity + b.selectivity) * COST_INDEX_ENTRY
+			+ row_num * a.selectivity * b.selectivity * (COST_RANDOM_PAGE + COST_TUPLE);
+		if(cost < path.cost)
+		{
+			path.type = access_path_t::INDEX_INTERSECT;
+			path.range[0] = a;
+			path.range[1] = b;
+			path.cost = cost;
+		}
+	}
+
+	return path;
+}
+
+double pages_touched(double pages, double k)
+{
+	if(pages <= 1) return std::min(pages, k);
+	return pages * (1 - std::pow(1 - 1 / pages, k));
+}
+
+bool order_by_index(access_path_t &path, int cid, bool desc, double limit)
+{
+	if(path.type == access_path_t::INDEX_SCAN && path.range[0].cid == cid)
+	{
+		path.range[0].backward = desc;
+		return true;
+	}
+
+	table_manager *table = path.table;
+	index_manager *index = table->get_index(cid);
+	if(!index || path.empty)
+		return path.empty;
+
+	// the index is read with the rows in the order of keys, and only a
+	// part of it if the scan stops after limit rows
+	double row_num = table->estimate_row_num();
+	double read_num = row_num;
+	if(limit >= 0 && limit < path.rows)
+		read_num *= limit / path.rows;
+	double cost = COST_INDEX_DESCENT + read_num * (COST_INDEX_ENTRY + COST_TUPLE)
+		+ pages_touched(table->estimate_page_num(), read_num) * COST_RANDOM_PAGE;
+	double sort_cost = path.cost
+		+ external_sorter::estimate_cost(path.rows, table->get_record_size(), limit);
+	if(cost >= sort_cost)
+		return false;
+
+	index_range_t &r = path.range[0];
+	r.cid = cid;
+	r.index = index;
+	r.lo = r.hi = nullptr;
+	r.lo_expr = r.hi_expr = nullptr;
+	r.lo_key.reset();
+	r.hi_key.reset();
+	r.points.reset();
+	r.lo_inclusive = r.hi_inclusive = true;
+	r.with_null = true;
+	r.backward = desc;
+	r.selectivity = 1;
+	path.type = access_path_t::INDEX_SCAN;
+	path.cost = cost;
+	return true;
+}
+
+// keys without a literal node are strings from LIKE patterns
+static std::string bound_to_string(const expr_node_t *expr, const char *key)
+{
+	return expr ? expression::to_string(expr) : "'" + std::string(key) + "'";
+}
+
+static std::string range_to_string(table_manager *table, const index_range_t &r)
+{
+	std::string col = std::string(table->get_table_name()) + "." + table->get_column_name(r.cid);
+	if(r.points)
+		return col + " IN " + std::to_string(r.points->size()) + " keys";
+	if(r.is_point())
+		return col + " = " + bound_to_string(r.lo_expr, r.lo);
+	if(r.with_null)
+		return col;
+
+	return col + " IN "
+		+ (r.lo && r.lo_inclusive ? "[" : "(")
+		+ (r.lo ? bound_to_string(r.lo_expr, r.lo) : "-INF") + ", "
+		+ (r.hi ? bound_to_string(r.hi_expr, r.hi) : "+INF")
+		+ (r.hi && r.hi_inclusive ? "]" : ")");
+}
+
+std::string access_path_t::to_string(bool with_cost) const
+{
+	std::string ret;
+	switch(type)
+	{
+		case FULL_SCAN:
+			ret = std::string("FULL SCAN ") + table->get_table_name();
+			break;
+		case INDEX_SCAN:
+			ret = (empty ? "EMPTY (bloom filter) " : "INDEX SCAN ")
+				+ range_to_string(table, range[0]) + (range[0].backward ? " DESC" : "");
+			break;
+		case INDEX_INTERSECT:
+			ret = "INDEX INTERSECT " + range_to_string(table, range[0])
+				+ " AND " + range_to_string(table, range[1]);
+			break;
+	}
+
+	if(!with_cost) return ret;
+	char buf[64];
+	std::snprintf(buf, sizeof(buf), " (rows=%.1f, cost=%.1f)", rows, cost);
+	return ret + buf;
+}
@@ -0,0 +1,71 @@
+#ifndef __TRIVIALDB_ACCESS_PATH__
+#define __TRIVIALDB_ACCESS_PATH__
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "../table/table.h"
+#include "../index/index.h"
+#include "../parser/defs.h"
+
+/* Keys in [lo, hi] of one index. A bound is nullptr if unbounded,
+ * lo == hi for equation. Keys point into the literal nodes of the
+ * condition (lo_expr, hi_expr), so the condition must outlive the range.
+ * Keys derived from the prefix of a LIKE pattern have no literal node,
+ * and are owned by the range in lo_key, hi_key instead.
+ *
+ * A range of several points, from an IN list, reads the keys in points
+ * one by one instead, and has no lo or hi. */
+struct index_range_t
+{
+	int cid;
+	index_manager *index;
+	const char *lo, *hi;
+	const expr_node_t *lo_expr, *hi_expr;
+	std::shared_ptr<const std::string> lo_key, hi_key;
+	// distinct keys in the order of the index, nullptr if not a multi-point range
+	std::shared_ptr<const std::vector<std::string>> points;
+	bool lo_inclusive, hi_inclusive;
+	// NULL keys are read too, only for unbounded ranges
+	bool with_null;
+	// keys are read in descending order
+	bool backward;
+	double selectivity;
+
+	bool is_point() const { return lo && lo == hi; }
+};
+
+struct access_path_t
+{
+	enum path_type_t {
+		FULL_SCAN,
+		INDEX_SCAN,
+		// rids from two indices are intersected before reading the rows
+		INDEX_INTERSECT
+	} type;
+
+	table_manager *table;
+	index_range_t range[2];
+	// estimated number of matched rows and cost of the path
+	double rows, cost;
+	// the bloom filter shows that nothing matches
+	bool empty;
+
+	std::string to_string(bool with_cost = true) const;
+};
+
+// pick the cheapest path to read the rows of table satisfying cond
+access_path_t choose_access_path(table_manager *table, expr_node_t *cond);
+access_path_t choose_access_path(table_manager *table, const std::vector<expr_node_t*> &and_cond);
+// literal as the key of a column, nullptr if the type differs
+const char *literal_key(const expr_node_t *expr, int col_type);
+// read the rows of path in the order of column cid, by the index of cid
+// if it is cheaper than sorting. False if the rows are still to be sorted.
+// limit is the number of rows wanted, or -1 for all of them.
+bool order_by_index(access_path_t &path, int cid, bool desc, double limit = -1);
+// expected number of distinct pages read when fetching k of the rows
+// on the pages in a random order (Cardenas' formula), the pages stay
+// in the page cache once read
+double pages_touched(double pages, double k);
+
+#endif
@@ -5,18 +5,65 @@
 #include "../expression/expression.h"
 #include "../utils/type_cast.h"
 #include "../table/record.h"
+#include "scan_batch.h"
 #include "../../network/field.h"
 #include "../../network/eof.h"
 #include "../../network/ok.h"
+#include "../../network/result_set.h"
 
 #include <vector>
 #include <limits>
 #include <algorithm>
 #include <stdio.h>
 #include <iostream>
-struct __cache_clear_guard
+#include <iterator>
+
+// the programs compiled for the expressions of a statement, which are
+// released along with it
+struct __compiled_exprs
+{
+	std::vector<expr_node_t*> exprs;
+
+	~__compiled_exprs()
+	{
+		for(expr_node_t *expr : exprs)
+			expression::free_program(expr);
+	}
+
+	void add(expr_node_t *expr)
+	{
+		if(expression::compile(expr))
+			exprs.push_back(expr);
+	}
+
+	// a condition is evaluated as a whole and by its AND operands
+	void add_cond(expr_node_t *cond)
+	{
+		std::vector<expr_node_t*> and_cond;
+		dbms::extract_and_cond(cond, and_cond);
+		add(cond);
+		for(expr_node_t *expr : and_cond)
+			add(expr);
+	}
+};
+
+// the tables of a statement that read only some of the columns of their
+// records, all the columns are read again however the statement ends
+struct __cached_columns
 {
-	~__cache_clear_guard() { expression::cache_clear(); }
+	std::vector<table_manager*> tables;
+
+	~__cached_columns()
+	{
+		for(table_manager *tm : tables)
+			tm->set_cached_columns(~0u);
+	}
+
+	void set(table_manager *tm, unsigned mask)
+	{
+		tables.push_back(tm);
+		tm->set_cached_columns(mask);
+	}
 };
 
 dbms::dbms()
@@ -58,10 +105,21 @@ void dbms::iterate(
 		} );
 	} else {
 		iterate_many_tables(required_tables, cond, callback);
-		std::puts("[Info] Join many tables by enumerating.");
 	}
 }
 
+// false if some condition is not satisfied, throws on evaluation error
+static bool eval_and_cond(const std::vector<expr_node_t*> &and_cond)
+{
+	for(expr_node_t *c : and_cond)
+	{
+		if(!typecast::expr_to_bool(expression::eval(c)))
+			return false;
+	}
+
+	return true;
+}
+
 template<typename Callback>
 bool dbms::iterate_one_table_with_index(
 		table_manager* table,
@@ -70,81 +128,178 @@ bool dbms::iterate_one_table_with_index(
 {
 	std::vector<expr_node_t*> and_cond;
 	extract_and_cond(cond, and_cond);
-	expr_node_t *index_cond = nullptr;
-	index_manager *index = nullptr;
-
-	auto get_index = [&](column_ref_t *col) -> index_manager*
+	access_path_t path = choose_access_path(table, and_cond);
+	if(path.type == access_path_t::FULL_SCAN)
 	{
-		int cid = table->lookup_column(col->column);
-		if(cid < 0) return nullptr;
-		return table->get_index(cid);
+		iterate_one_table(table, cond, callback);
+		return false;
+	}
+
+	iterate_access_path(path, and_cond, callback);
+	return true;
+}
+
+template<typename Callback>
+bool dbms::iterate_access_path(
+		const access_path_t &path,
+		const std::vector<expr_node_t*> &and_cond,
+		Callback callback)
+{
+	if(path.empty) return true;
+
+	// conditions used by the path are rechecked with the others
+	table_manager *table = path.table;
+	auto visit = [&](record_manager *rm, int rid) -> bool {
+		table->cache_record(rm);
+		try {
+			if(!eval_and_cond(and_cond))
+				return true;
+		} catch(const char *msg) {
+			std::puts(msg);
+			return false;
+		}
+
+		return callback(table, rm, rid);
+	};
+
+	auto visit_rid = [&](int rid) -> bool {
+		record_manager rm = table->get_record_ptr(rid);
+		if(!rm.valid()) return true;
+		return visit(&rm, rid);
 	};
 
-	for(expr_node_t *expr : and_cond)
+	switch(path.type)
 	{
-		if(expr->op == OPERATOR_EQ)
-		{
-			if(expr->right->term_type == TERM_COLUMN_REF)
-				std::swap(expr->right, expr->left);
+		case access_path_t::FULL_SCAN: {
+			auto it = table->get_record_iterator_lower_bound(0);
+			for(; !it.is_end(); it.next())
+			{
+				int rid;
+				record_manager rm(it.get_pager());
+				rm.open(it.get(), false);
+				rm.read(&rid, 4);
+				if(!visit(&rm, rid))
+					return false;
+			}
 
-			if(expr->left->term_type == TERM_COLUMN_REF && expr->right->term_type != TERM_COLUMN_REF)
+			return true;
+		}
+		case access_path_t::INDEX_SCAN:
+			return iterate_index_range(path.range[0], visit_rid);
+		case access_path_t::INDEX_INTERSECT: {
+			std::vector<int> rids[2];
+			for(int i = 0; i != 2; ++i)
 			{
-				index = get_index(expr->left->column_ref);
-				if(index)
-				{
-					index_cond = expr;
-					break;
-				}
+				iterate_index_range(path.range[i], [&](int rid) -> bool {
+					rids[i].push_back(rid);
+					return true;
+				} );
+				std::sort(rids[i].begin(), rids[i].end());
 			}
+
+			std::vector<int> common;
+			std::set_intersection(rids[0].begin(), rids[0].end(),
+				rids[1].begin(), rids[1].end(), std::back_inserter(common));
+			for(int rid : common)
+				if(!visit_rid(rid)) return false;
+			return true;
 		}
 	}
 
-	if(!index_cond)
+	return true;
+}
+
+template<typename Callback>
+bool dbms::iterate_index_range(const index_range_t &range, Callback callback)
+{
+	if(range.points)
 	{
-		iterate_one_table(table, cond, callback);
-		return false;
+		// each point is read as a range of its own
+		index_range_t point = range;
+		point.points.reset();
+		const std::vector<std::string> &keys = *range.points;
+		for(size_t i = 0; i != keys.size(); ++i)
+		{
+			const std::string &key = range.backward ? keys[keys.size() - 1 - i] : keys[i];
+			point.lo = point.hi = key.data();
+			point.lo_inclusive = point.hi_inclusive = true;
+			if(!iterate_index_range(point, callback))
+				return false;
+		}
+
+		return true;
 	}
 
-	char *key = nullptr;
-	switch(index_cond->right->term_type)
+	index_manager *index = range.index;
+	const char *lo = range.lo, *hi = range.hi;
+	if(range.backward)
 	{
-		case TERM_INT:
-		case TERM_DATE:
-			key = (char*)&index_cond->right->val_i;
-			break;
-		case TERM_FLOAT:
-			key = (char*)&index_cond->right->val_f;
-			break;
-		case TERM_STRING:
-			key = index_cond->right->val_s;
-			break;
-		case TERM_BOOL:
-			key = (char*)&index_cond->right->val_b;
-			break;
-		default:
-			break;
+		// start from the last key not larger than hi
+		auto it = index->get_iterator_last();
+		if(hi)
+		{
+			auto ub = index->get_iterator_lower_bound(hi, std::numeric_limits<int>::max());
+			if(!ub.is_end())
+			{
+				it = ub;
+				it.prev();
+			}
+		}
+
+		for(; !it.is_end(); it.prev())
+		{
+			int rid;
+			const char *key = index->get_entry(it.get(), &rid);
+			if(!key)
+			{
+				// NULL keys are placed first
+				if(!range.with_null) break;
+				if(!callback(rid)) return false;
+				continue;
+			}
+
+			if(hi && !range.hi_inclusive && index->compare(key, hi) == 0)
+				continue;
+			if(lo)
+			{
+				int r = index->compare(key, lo);
+				if(r < 0 || (r == 0 && !range.lo_inclusive))
+					break;
+			}
+
+			if(!callback(rid))
+				return false;
+		}
+
+		return true;
 	}
 
-	auto it = index->get_iterator_lower_bound(key);
+	// NULL keys are placed first and only in a range with_null
+	auto it = lo ? index->get_iterator_lower_bound(lo)
+		: index->get_iterator_lower_bound(nullptr, range.with_null
+			? std::numeric_limits<int>::min() : std::numeric_limits<int>::max());
 	for(; !it.is_end(); it.next())
 	{
 		int rid;
-		record_manager rm = table->open_record_from_index_lower_bound(it.get(), &rid);
-		table->cache_record(&rm);
-
-		bool join_ret = false;
-		try {
-			join_ret = typecast::expr_to_bool(expression::eval(index_cond));
-		} catch(const char *msg) {
-			std::puts(msg);
-			iterate_one_table(table, cond, callback);
-			return false;
+		const char *key = index->get_entry(it.get(), &rid);
+		if(!key)
+		{
+			if(range.with_null && !callback(rid))
+				return false;
+			continue;
 		}
 
-		if(!join_ret) break;
+		if(lo && !range.lo_inclusive && index->compare(key, lo) == 0)
+			continue;
+		if(hi)
+		{
+			int r = index->compare(key, hi);
+			if(r > 0 || (r == 0 && !range.hi_inclusive))
+				break;
+		}
 
-		if(!callback(table, &rm, rid))
-			break;
+		if(!callback(rid))
+			return false;
 	}
 
 	return true;
@@ -156,29 +311,37 @@ void dbms::iterate_one_table(
 		expr_node_t *cond,
 		Callback callback)
 {
+	scan_batch batch(table, cond);
 	auto bit = table->get_record_iterator_lower_bound(0);
-	for(; !bit.is_end(); bit.next())
+	while(!bit.is_end())
 	{
-		int rid;
-		record_manager rm(bit.get_pager());
-		rm.open(bit.get(), false);
-		rm.read(&rid, 4);
-		table->cache_record(&rm);
-		if(cond)
+		batch.clear();
+		for(; !bit.is_end() && !batch.full(); bit.next())
+		{
+			record_manager rm(bit.get_pager());
+			rm.open(bit.get(), false);
+			batch.add(&rm, bit.get());
+		}
+
+		int sel_num = batch.filter();
+		for(int i = 0; i < sel_num; ++i)
 		{
+			table->view_record(batch.selected_record(i));
 			bool result = false;
 			try {
-				result = typecast::expr_to_bool(expression::eval(cond));
+				result = batch.check_cached();
 			} catch(const char *msg) {
 				std::puts(msg);
 				return;
 			}
 
 			if(!result) continue;
-		}
 
-		if(!callback(table, &rm, rid))
-			break;
+			record_manager rm(bit.get_pager());
+			rm.open(batch.selected_pos(i), false);
+			if(!callback(table, &rm, batch.selected_rid(i)))
+				return;
+		}
 	}
 }
 
@@ -194,248 +357,294 @@ void dbms::extract_and_cond(expr_node_t *cond, std::vector<expr_node_t*> &and_co
 	}
 }
 
+void dbms::bind_columns(expr_node_t *expr, const std::vector<table_manager*> &tables)
+{
+	if(!expr) return;
+	if(expr->op != OPERATOR_NONE)
+	{
+		bind_columns(expr->left, tables);
+		bind_columns(expr->right, tables);
+		return;
+	}
+
+	if(expr->term_type != TERM_COLUMN_REF)
+		return;
+
+	column_ref_t *col = expr->column_ref;
+	col->record = nullptr;
+	col->cid = 0;
+	for(table_manager *tb : tables)
+	{
+		if(col->table && std::strcmp(col->table, tb->get_table_name()) != 0)
+			continue;
+		column_ref_t bound = *col;
+		if(!tb->bind_column(&bound))
+			continue;
+		if(col->record)
+		{
+			// a qualified reference takes the first table of the name
+			if(col->table) return;
+			col->record = nullptr;
+			col->cid = -1;
+			return;
+		}
+
+		*col = bound;
+	}
+}
+
 template<typename Callback>
 void dbms::iterate_many_tables(
 	const std::vector<table_manager*> &table_list,
 	expr_node_t *cond, Callback callback)
 {
-	std::vector<record_manager*> record_list(table_list.size());
-	std::vector<int> rid_list(table_list.size());
-	std::vector<expr_node_t*> and_cond;
-	extract_and_cond(cond, and_cond);
-	auto lookup_table = [&](const char *name) {
-		for(int i = 0; i < (int)table_list.size(); ++i)
-			if(std::strcmp(name, table_list[i]->get_table_name()) == 0)
-				return i;
-		return -1;
-	};
+	join_plan_t plan = plan_join(table_list, cond);
+	for(const std::string &line : plan.to_string(table_list))
+		std::printf("[Info] %s\n", line.c_str());
 
-	// edge
-	std::vector<std::vector<int>> E(table_list.size());
-	// join cond
-	std::vector<std::vector<expr_node_t*>> J(table_list.size());
-	for(auto &v : E) v.resize(table_list.size());
-	for(auto &v : J) v.resize(table_list.size());
-
-	// setup join condition graph
-	for(expr_node_t *c : and_cond)
+	// build hash tables before joining
+	std::vector<join_hash_table> hash_tables(plan.steps.size());
+	for(size_t i = 0; i != plan.steps.size(); ++i)
 	{
-		if(c->op == OPERATOR_EQ &&
-				c->left->term_type == TERM_COLUMN_REF &&
-				c->right->term_type == TERM_COLUMN_REF)
-		{
-			int tid1 = lookup_table(c->left->column_ref->table);
-			int tid2 = lookup_table(c->right->column_ref->table);
-			if(tid1 == -1 || tid2 == -1)
-			{
-				std::fprintf(stderr, "[Error] Table not found!\n");
-				return;
-			}
-
-			table_manager *tb1 = table_list[tid1];
-			table_manager *tb2 = table_list[tid2];
+		const join_step_t &step = plan.steps[i];
+		if(step.method != join_step_t::HASH_PROBE)
+			continue;
 
-			int cid1 = tb1->lookup_column(c->left->column_ref->column);
-			int cid2 = tb2->lookup_column(c->right->column_ref->column);
-			if(cid1 == -1 || cid2 == -1)
-			{
-				std::fprintf(stderr, "[Error] Column not found!\n");
-				return;
-			}
+		table_manager *tb = table_list[step.table];
+		auto hasher = tb->get_column_hasher(step.inner_cid);
+		int length = tb->get_column_length(step.inner_cid);
+		hash_tables[i].init(tb->get_record_size());
+		iterate_access_path(step.path, step.local_cond,
+			[&](table_manager *, record_manager *, int rid) -> bool {
+				const char *key = tb->get_cached_column(step.inner_cid);
+				if(key) hash_tables[i].insert(hasher(key, length), rid, tb->get_cached_record());
+				return true;
+			} );
+	}
 
-			index_manager *idx1 = tb1->get_index(cid1);
-			index_manager *idx2 = tb2->get_index(cid2);
-			if(!idx1 && !idx2)
-				continue;
+	std::vector<record_manager*> record_list(table_list.size(), nullptr);
+	std::vector<int> rid_list(table_list.size());
+	bool ok = iterate_join_step(plan, 0, table_list, record_list, rid_list, hash_tables, callback);
 
-			if(idx2)
+	// join the probes deferred by partitioned hash tables, the
+	// later steps may defer more probes while replaying
+	for(size_t i = 0; ok && i != plan.steps.size(); ++i)
+	{
+		ok = hash_tables[i].replay([&](const char *tuple) -> bool {
+			for(size_t j = 0; j != i; ++j)
 			{
-				E[tid2][tid1] = 1;
-				J[tid2][tid1] = c;
+				int t = plan.steps[j].table;
+				std::memcpy(&rid_list[t], tuple, sizeof(int));
+				table_list[t]->cache_record(tuple + sizeof(int));
+				record_list[t] = nullptr;
+				tuple += sizeof(int) + table_list[t]->get_record_size();
 			}
 
-			if(idx1)
-			{
-				E[tid1][tid2] = 1;
-				J[tid1][tid2] = c;
-			}
-		}
+			return iterate_join_step(plan, i, table_list,
+				record_list, rid_list, hash_tables, callback);
+		} );
 	}
+}
 
-	// find the longest path
-	int *mark = new int[table_list.size()];
-	int *path = new int[table_list.size()];
-	int max_depth = 0, start = 0;
-	for(int i = 0; i < (int)table_list.size(); ++i)
-	{
-		int m = 0;
-		std::memset(mark, 0, table_list.size() * sizeof(int));
-		find_longest_path(i, 0, mark, path, E, ~0u >> 1, m);
-		if(m > max_depth)
-		{
-			max_depth = m;
-			start = i;
+template<typename Callback>
+bool dbms::iterate_join_step(
+	const join_plan_t &plan, size_t now,
+	const std::vector<table_manager*> &table_list,
+	std::vector<record_manager*> &record_list,
+	std::vector<int> &rid_list,
+	std::vector<join_hash_table> &hash_tables,
+	Callback callback)
+{
+	if(now == plan.steps.size())
+		return callback(table_list, record_list, rid_list);
+
+	if(now == 0 && plan.steps.size() > 1 && plan.steps[1].method == join_step_t::MERGE_JOIN)
+		return iterate_merge_join(plan, table_list, record_list, rid_list, hash_tables, callback);
+
+	const join_step_t &step = plan.steps[now];
+	table_manager *tb = table_list[step.table];
+	// the record of tb is cached
+	auto next = [&](record_manager *rm, int rid) -> bool {
+		record_list[step.table] = rm;
+		rid_list[step.table] = rid;
+		try {
+			if(!eval_and_cond(step.cond))
+				return true;
+		} catch(const char *msg) {
+			std::puts(msg);
+			return false;
 		}
-	}
-
-	int _;
-	std::memset(mark, 0, table_list.size() * sizeof(int));
-	_ = find_longest_path(start, 0, mark, path, E, max_depth, _);
-	assert(_);
-
-	// generate iteration sequence
-	std::memset(mark, 0, table_list.size() * sizeof(int));
-	for(int i = 0; i <= max_depth; ++i)
-		mark[path[i]] = 1;
-
-	int cur = max_depth, len = table_list.size();
-	for(int i = 0; i < len; ++i)
-		if(!mark[i])
-			path[++cur] = i;
 
-	// setup iteration variable
-	index_manager **index_ref = new index_manager*[len];
-	int *index_cid = new int[len];
-	std::fill(index_ref, index_ref + len, nullptr);
-	std::fill(index_cid, index_cid + len, -1);
+		return iterate_join_step(plan, now + 1, table_list,
+			record_list, rid_list, hash_tables, callback);
+	};
 
-	for(int i = 0; i < max_depth; ++i)
+	switch(step.method)
 	{
-		expr_node_t *join_node = J[path[i]][path[i + 1]];
-		if(std::strcmp(join_node->left->column_ref->table, table_list[path[i]]->get_table_name()) == 0)
-		{
-			index_cid[i] = table_list[path[i + 1]]->lookup_column(
-					join_node->right->column_ref->column);
-			index_ref[i] = table_list[path[i]]->get_index(
-					table_list[path[i]]->lookup_column(
-						join_node->left->column_ref->column)
-					);
-		} else {
-			index_cid[i] = table_list[path[i + 1]]->lookup_column(
-					join_node->left->column_ref->column);
-			index_ref[i] = table_list[path[i]]->get_index(
-					table_list[path[i]]->lookup_column(
-						join_node->right->column_ref->column)
-					);
+		case join_step_t::NESTED_SCAN:
+			return iterate_access_path(step.path, std::vector<expr_node_t*>(),
+				[&](table_manager *, record_manager *rm, int rid) -> bool {
+					return next(rm, rid);
+				} );
+		case join_step_t::INDEX_LOOKUP: {
+			const char *key = table_list[step.outer_table]->get_cached_column(step.outer_cid);
+			index_range_t range;
+			range.index = tb->get_index(step.inner_cid);
+			range.lo = range.hi = key;
+			range.lo_inclusive = range.hi_inclusive = true;
+			range.with_null = range.backward = false;
+			if(!key || !range.index->may_contain(key))
+				return true;
+
+			return iterate_index_range(range, [&](int rid) -> bool {
+				record_manager rm = tb->get_record_ptr(rid);
+				if(!rm.valid()) return true;
+				tb->cache_record(&rm);
+				return next(&rm, rid);
+			} );
 		}
+		case join_step_t::MERGE_JOIN:
+			assert(false);  // joined with the first step
+			return false;
+		case join_step_t::HASH_PROBE: {
+			const char *key = table_list[step.outer_table]->get_cached_column(step.outer_cid);
+			if(!key) return true;
+			uint64_t h = tb->get_column_hasher(step.inner_cid)(
+				key, tb->get_column_length(step.inner_cid));
+			if(hash_tables[now].deferring())
+			{
+				// save the bound rows to be joined with the partition of h
+				std::vector<char> tuple;
+				for(size_t i = 0; i != now; ++i)
+				{
+					table_manager *t = table_list[plan.steps[i].table];
+					const char *rid = (const char*)&rid_list[plan.steps[i].table];
+					tuple.insert(tuple.end(), rid, rid + sizeof(int));
+					tuple.insert(tuple.end(), t->get_cached_record(),
+						t->get_cached_record() + t->get_record_size());
+				}
 
-		assert(index_ref[i]);
-	}
-
-	iterate_many_tables_impl(
-		table_list, record_list, rid_list,
-		J, path, index_cid, index_ref,
-		cond, callback, len - 1);
-
-	// debug info
-	std::printf("[Info] Iteration order: ");
-	for(int i = 0; i < len; ++i)
-	{
-		if(i != 0) std::printf(", ");
-		std::printf("%s", table_list[path[len - i - 1]]->get_table_name());
-	}
+				hash_tables[now].defer_probe(h, tuple.data(), tuple.size());
+				return true;
+			}
 
-	std::printf("\n[Info] Index use: ");
-	for(int i = 0; i < max_depth; ++i)
-	{
-		if(i != 0) std::printf(", ");
-		expr_node_t *node = J[path[i]][path[i + 1]];
-		std::printf("%s.%s-%s.%s",
-			node->left->column_ref->table,
-			node->left->column_ref->column,
-			node->right->column_ref->table,
-			node->right->column_ref->column
-		);
+			// rows are restored from the hash table, no record_manager for them
+			return hash_tables[now].probe(h, [&](int rid, const char *row) -> bool {
+				tb->view_record(row);
+				return next(nullptr, rid);
+			} );
+		}
 	}
 
-	std::puts("");
-
-	delete []mark;
-	delete []path;
-	delete []index_cid;
-	delete []index_ref;
+	return true;
 }
 
 template<typename Callback>
-bool dbms::iterate_many_tables_impl(
+bool dbms::iterate_merge_join(
+	const join_plan_t &plan,
 	const std::vector<table_manager*> &table_list,
 	std::vector<record_manager*> &record_list,
 	std::vector<int> &rid_list,
-	std::vector<std::vector<expr_node_t*>> &index_cond,
-	int *iter_order, int *index_cid, index_manager** index,
-	expr_node_t *cond, Callback callback, int now)
+	std::vector<join_hash_table> &hash_tables,
+	Callback callback)
 {
-	if(now < 0)
-	{
-		if(cond)
+	const join_step_t &outer_step = plan.steps[0], &step = plan.steps[1];
+	table_manager *outer = table_list[outer_step.table];
+	table_manager *inner = table_list[step.table];
+	index_manager *outer_index = outer->get_index(step.outer_cid);
+	index_manager *inner_index = inner->get_index(step.inner_cid);
+	int length = inner->get_column_length(step.inner_cid);
+
+	// NULL keys are placed first and never joined
+	auto outer_it = outer_index->get_iterator_lower_bound(nullptr, std::numeric_limits<int>::max());
+	auto inner_it = inner_index->get_iterator_lower_bound(nullptr, std::numeric_limits<int>::max());
+	auto next_key = [](index_manager *index, btree_iterator<index_btree::leaf_page> &it, int *rid) -> const char* {
+		for(; !it.is_end(); it.next())
 		{
-			bool result = false;
-			try {
-				result = typecast::expr_to_bool(expression::eval(cond));
-			} catch(const char *msg) {
-				std::puts(msg);
-				return false; // stop
-			}
-
-			if(!result)
-				return true; // continue
+			const char *key = index->get_entry(it.get(), rid);
+			if(key) return key;
 		}
 
-		if(!callback(table_list, record_list, rid_list))
-			return false;  // stop
-		return true;  // continue
-	} else {
-		if(!index[now])
+		return nullptr;
+	};
+
+	int outer_rid, inner_rid;
+	const char *outer_key = next_key(outer_index, outer_it, &outer_rid);
+	const char *inner_key = next_key(inner_index, inner_it, &inner_rid);
+	std::vector<char> key(length);
+	std::vector<int> group_rids;
+	std::vector<char> group_rows;
+	int row_size = inner->get_record_size();
+	try {
+		while(outer_key && inner_key)
 		{
-			auto it = table_list[iter_order[now]]->get_record_iterator_lower_bound(0);
-			for(; !it.is_end(); it.next())
+			int c = outer_index->compare(outer_key, inner_key);
+			if(c != 0)
 			{
-				record_manager rm(it.get_pager());
-				rm.open(it.get(), false);
-				rm.read(&rid_list[iter_order[now]], 4);
-				// std::printf("%d\n", rid_list[iter_order[now]]);
-				table_list[iter_order[now]]->cache_record(&rm);
-				record_list[iter_order[now]] = &rm;
-				bool ret = iterate_many_tables_impl(
-					table_list, record_list, rid_list,
-					index_cond, iter_order, index_cid, index,
-					cond, callback, now - 1
-				);
-
-				if(!ret) return false;
+				if(c < 0) {
+					outer_it.next();
+					outer_key = next_key(outer_index, outer_it, &outer_rid);
+				} else {
+					inner_it.next();
+					inner_key = next_key(inner_index, inner_it, &inner_rid);
+				}
+
+				continue;
 			}
-		} else {
-			const char *tb_col = table_list[iter_order[now + 1]]->get_cached_column(index_cid[now]);
-			table_manager *tb2 = table_list[iter_order[now]];
-			auto tb2_it = index[now]->get_iterator_lower_bound(tb_col);
-			for(; !tb2_it.is_end(); tb2_it.next())
+
+			// the inner rows of the key are read once for all outer rows of it
+			inner_index->copy_key(key.data(), inner_key);
+			group_rids.clear();
+			group_rows.clear();
+			while(inner_key && inner_index->compare(inner_key, key.data()) == 0)
 			{
-				int tb2_rid;
-				record_manager tb2_rm = tb2->open_record_from_index_lower_bound(tb2_it.get(), &tb2_rid);
-				tb2->cache_record(&tb2_rm);
-
-				bool join_ret = false;
-				try {
-					expr_node_t *join_cond = index_cond[iter_order[now]][iter_order[now + 1]];
-					join_ret = typecast::expr_to_bool(expression::eval(join_cond));
-				} catch(const char *msg) {
-					std::puts(msg);
-					return false;
+				record_manager rm = inner->get_record_ptr(inner_rid);
+				if(rm.valid())
+				{
+					inner->cache_record(&rm);
+					if(eval_and_cond(step.local_cond))
+					{
+						group_rids.push_back(inner_rid);
+						group_rows.insert(group_rows.end(), inner->get_cached_record(),
+							inner->get_cached_record() + row_size);
+					}
 				}
 
-				if(!join_ret) break;
+				inner_it.next();
+				inner_key = next_key(inner_index, inner_it, &inner_rid);
+			}
 
-				rid_list[iter_order[now]] = tb2_rid;
-				record_list[iter_order[now]] = &tb2_rm;
-				bool ret = iterate_many_tables_impl(
-					table_list, record_list, rid_list,
-					index_cond, iter_order, index_cid, index,
-					cond, callback, now - 1
-				);
+			while(outer_key && outer_index->compare(outer_key, key.data()) == 0)
+			{
+				// the outer rows are not read if no inner row matches
+				record_manager rm = group_rids.empty() ? record_manager(nullptr)
+					: outer->get_record_ptr(outer_rid);
+				if(rm.valid())
+				{
+					outer->cache_record(&rm);
+					record_list[outer_step.table] = &rm;
+					rid_list[outer_step.table] = outer_rid;
+					if(eval_and_cond(outer_step.cond))
+					{
+						for(size_t i = 0; i != group_rids.size(); ++i)
+						{
+							inner->view_record(group_rows.data() + i * row_size);
+							record_list[step.table] = nullptr;
+							rid_list[step.table] = group_rids[i];
+							if(eval_and_cond(step.cond) && !iterate_join_step(plan, 2,
+									table_list, record_list, rid_list, hash_tables, callback))
+								return false;
+						}
+					}
+				}
 
-				if(!ret) return false;
+				outer_it.next();
+				outer_key = next_key(outer_index, outer_it, &outer_rid);
 			}
 		}
+	} catch(const char *msg) {
+		std::puts(msg);
+		return false;
 	}
 
 	return true;
@@ -510,134 +719,24 @@ void dbms::show_database(const char *db_name, Client* cli, const char *pkt)
 	db.open(db_name);
 	db.show_info();
 	auto dbInfo = db.get_db_info();
-	// pack seq
-	uint8_t seq = 1;
-	// 1.field count pack
-	std::vector<uint8_t> out_pack;
-	out_pack.push_back(1);
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.push_back(static_cast<uint8_t>(2));
-	UnboundedBuffer reply_;
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
-	out_pack.clear();
-	// 2.table header
+	// 1.field count, 2.table header, 3.eof
+	ResultSetWriter writer(cli, 0, RESULT_FLUSH_SIZE, RESULT_SEND_BUFFER_LIMIT);
+	writer.WriteColumnCount(2);
 	Protocol::FieldPacket new_field_pack(std::string("Item"), static_cast< uint32_t >(6165), std::string(dbInfo.db_name),
               std::string(dbInfo.db_name), std::string(dbInfo.db_name), std::string(dbInfo.db_name),
               80, 33, 0, 0);
-	seq ++;
-	std::vector< uint8_t > field_pack = new_field_pack.Pack();
-	out_pack.push_back(field_pack.size());
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.insert(
-		out_pack.end(),
-		field_pack.begin(),
-		field_pack.end()
-	);
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
-	out_pack.clear();
-
+	writer.WritePacket(new_field_pack.Pack());
 	Protocol::FieldPacket new_field_pack_1(std::string("Value"), static_cast< uint32_t >(6165), std::string(dbInfo.db_name),
               std::string(dbInfo.db_name), std::string(dbInfo.db_name), std::string(dbInfo.db_name),
               80, 33, 0, 0);
-	seq ++;
-	std::vector< uint8_t > field_pack_1 = new_field_pack_1.Pack();
-	out_pack.push_back(field_pack_1.size());
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.insert(
-		out_pack.end(),
-		field_pack_1.begin(),
-		field_pack_1.end()
-	);
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
-	out_pack.clear();
-	// 3.eof 
-	Protocol::EofPacket eof(0, 2);
-    std::vector< uint8_t > eof_packet = eof.Pack();
-	seq ++; // 254, 0, 0, 2, 0
-	out_pack.push_back(eof_packet.size());
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.insert(
-		out_pack.end(),
-		eof_packet.begin(),
-		eof_packet.end()
-	);
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
-	out_pack.clear();
+	writer.WritePacket(new_field_pack_1.Pack());
+	writer.WriteEof(0, 2);
 	// 4.rows
-	// db name
-	seq ++;
-	auto row_val = std::vector<std::string>{std::string("DATABASE NAME"), std::string(dbInfo.db_name)};
-	Protocol::RowPacket row_pack1(row_val);
-	std::vector< uint8_t > row_packet1 = row_pack1.Pack();
-	out_pack.push_back(row_packet1.size());
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.insert(
-		out_pack.end(),
-		row_packet1.begin(),
-		row_packet1.end()
-	);
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
-	out_pack.clear();
-	// table count
-	seq ++;
-	row_val = std::vector<std::string>{std::string("TABLE COUNT"), std::to_string(db.get_tab_num())};
-	Protocol::RowPacket row_pack2(row_val);
-	std::vector< uint8_t > row_packet2 = row_pack2.Pack();
-	out_pack.push_back(row_packet2.size());
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.insert(
-		out_pack.end(),
-		row_packet2.begin(),
-		row_packet2.end()
-	);
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
-	out_pack.clear();
-
+	writer.WriteRow({ std::string("DATABASE NAME"), std::string(dbInfo.db_name) });
+	writer.WriteRow({ std::string("TABLE COUNT"), std::to_string(db.get_tab_num()) });
 	// 5.eof
-	seq ++; // 254, 0, 0, 2, 0
-	out_pack.push_back(eof_packet.size());
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.insert(
-		out_pack.end(),
-		eof_packet.begin(),
-		eof_packet.end()
-	);
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
+	writer.WriteEof(0, 2);
+	writer.Flush();
 }
 
 void dbms::drop_table(const char *table_name)
@@ -661,6 +760,40 @@ void dbms::show_table(const char* table_name)
 	}
 }
 
+void dbms::analyze_table(const char *table_name, Client* cli, const char *pkt)
+{
+	int row_num = 0;
+	if(assert_db_open())
+	{
+		table_manager *tm = cur_db->get_table(table_name);
+		if(tm == nullptr)
+		{
+			std::fprintf(stderr, "[Error] Table `%s` not found.\n", table_name);
+		} else {
+			row_num = tm->analyze();
+			std::printf("[Info] Table `%s` analyzed, %d row(s), %d sampled.\n",
+				table_name, row_num, tm->get_stats().sampled_rows);
+		}
+	}
+
+	Protocol::OkPacket ok_pack;
+	std::vector<uint8_t> ok_packed = ok_pack.Pack(row_num, 0, 2, 0);
+	std::vector< uint8_t > res;
+	res.push_back(ok_packed.size());
+	res.push_back(0);
+	res.push_back(0);
+	res.push_back(pkt[3] + 1);
+	res.insert(
+		res.end(),
+		ok_packed.begin(),
+		ok_packed.end()
+	);
+	UnboundedBuffer reply_;
+	reply_.PushData(std::string(res.begin(), res.end()).c_str(),
+					res.size());
+	cli->SendPacket(reply_);
+}
+
 void dbms::create_table(const table_header_t *header, Client* cli, const char *pkt)
 {
 	if(assert_db_open())
@@ -678,57 +811,486 @@ void dbms::update_rows(const update_info_t *info, Client* cli, const char *pkt)
 	if(!assert_db_open())
 		return;
 
-	__cache_clear_guard __guard;
-	table_manager *tm = cur_db->get_table(info->table);
-	if(tm == nullptr)
+	table_manager *tm = cur_db->get_table(info->table);
+	if(tm == nullptr)
+	{
+		std::fprintf(stderr, "[Error] table `%s` doesn't exists.\n", info->table);
+		return;
+	}
+
+	int col_id = tm->lookup_column(info->column_ref->column);
+	if(col_id < 0)
+	{
+		std::fprintf(stderr, "[Error] column `%s' not exists.\n", info->column_ref->column);
+		return;
+	}
+
+	std::vector<table_manager*> tables(1, tm);
+	bind_columns(info->where, tables);
+	bind_columns(info->value, tables);
+	__compiled_exprs compiled;
+	compiled.add_cond(info->where);
+	compiled.add(info->value);
+
+	int succ_count = 0, fail_count = 0;
+	try {
+		// modifying a record may move it, the rows are found first
+		std::vector<int> update_list;
+		iterate_one_table(tm, info->where, [&](table_manager *, record_manager *, int rid) -> bool {
+			update_list.push_back(rid);
+			return true;
+		} );
+
+		for(int rid : update_list)
+		{
+			record_manager rm = tm->get_record_ptr(rid);
+			tm->cache_record(&rm);
+			expression val = expression::eval(info->value);
+			int col_type = tm->get_column_type(col_id);
+			if(!typecast::type_compatible(col_type, val))
+				throw "[Error] Incompatible data type.";
+			auto term_type = typecast::column_to_term(col_type);
+			bool ret = tm->modify_record(rid, col_id, typecast::expr_to_db(val, term_type));
+			succ_count += ret;
+			fail_count += 1 - ret;
+		}
+	} catch(const char *msg) {
+		std::puts(msg);
+		return;
+	} catch(...) {
+	}
+	Protocol::OkPacket ok_pack;
+    std::vector<uint8_t> ok_packed = ok_pack.Pack(succ_count, 0, 2, 0);
+	std::vector< uint8_t > res;
+	res.push_back(ok_packed.size());
+	res.push_back(0);
+	res.push_back(0);
+	res.push_back(1);
+	res.insert(
+		res.end(),
+		ok_packed.begin(),
+		ok_packed.end()
+	);
+	UnboundedBuffer reply_;
+	reply_.PushData(std::string(res.begin(), res.end()).c_str(),
+					res.size());
+	cli->SendPacket(reply_);
+	std::printf("[Info] %d row(s) updated, %d row(s) failed.\n",
+			succ_count, fail_count);
+}
+
+// all expressions of the query read the records cached by the tables,
+// and are compiled after being bound
+static void bind_select(const select_info_t *info, const std::vector<table_manager*> &tables,
+	__compiled_exprs &compiled)
+{
+	dbms::bind_columns(info->where, tables);
+	compiled.add_cond(info->where);
+	for(linked_list_t *link_p = info->exprs; link_p; link_p = link_p->next)
+	{
+		expr_node_t *expr = (expr_node_t*)link_p->data;
+		dbms::bind_columns(expr, tables);
+		// the arguments of aggregates are evaluated instead
+		compiled.add(expression::is_aggregate(expr) ? expr->left : expr);
+	}
+
+	for(linked_list_t *link_p = info->groups; link_p; link_p = link_p->next)
+	{
+		dbms::bind_columns((expr_node_t*)link_p->data, tables);
+		compiled.add((expr_node_t*)link_p->data);
+	}
+
+	for(linked_list_t *link_p = info->orders; link_p; link_p = link_p->next)
+	{
+		dbms::bind_columns(((order_by_item_t*)link_p->data)->expr, tables);
+		compiled.add(((order_by_item_t*)link_p->data)->expr);
+	}
+}
+
+static void collect_columns(const expr_node_t *expr, table_manager *table, unsigned &mask)
+{
+	if(!expr) return;
+	if(expr->op != OPERATOR_NONE)
+	{
+		collect_columns(expr->left, table, mask);
+		collect_columns(expr->right, table, mask);
+	} else if(expr->term_type == TERM_COLUMN_REF) {
+		const column_ref_t *col = expr->column_ref;
+		if(col->record && col->record == table->get_cached_record_ref())
+			mask |= 1u << col->cid;
+	}
+}
+
+// the columns of table the bound query reads, all of them for SELECT *
+static unsigned referenced_columns(const select_info_t *info, table_manager *table)
+{
+	if(!info->exprs) return ~0u;
+	unsigned mask = 0;
+	collect_columns(info->where, table, mask);
+	for(linked_list_t *link_p = info->exprs; link_p; link_p = link_p->next)
+		collect_columns((expr_node_t*)link_p->data, table, mask);
+	for(linked_list_t *link_p = info->groups; link_p; link_p = link_p->next)
+		collect_columns((expr_node_t*)link_p->data, table, mask);
+	for(linked_list_t *link_p = info->orders; link_p; link_p = link_p->next)
+		collect_columns(((order_by_item_t*)link_p->data)->expr, table, mask);
+	return mask;
+}
+
+// ORDER BY keys in the order they are written
+static std::string value_to_string(const expression &val)
+{
+	switch(val.type)
+	{
+		case TERM_INT:
+			return std::to_string(val.val_i);
+		case TERM_FLOAT:
+			return std::to_string(val.val_f);
+		case TERM_STRING:
+			return val.val_s;
+		case TERM_BOOL:
+			return val.val_b ? "TRUE" : "FALSE";
+		case TERM_DATE: {
+			char date_buf[32];
+			time_t time = val.val_i;
+			auto tm = std::localtime(&time);
+			std::strftime(date_buf, 32, DATE_TEMPLATE, tm);
+			return date_buf;
+		}
+		case TERM_NULL:
+			return "NULL";
+		default:
+			debug_puts("[Error] Data type not supported!");
+			return "";
+	}
+}
+
+static void get_order_keys(const select_info_t *info,
+	std::vector<expr_node_t*> &order_exprs, std::vector<bool> &order_desc)
+{
+	for(linked_list_t *link_p = info->orders; link_p; link_p = link_p->next)
+	{
+		order_by_item_t *item = (order_by_item_t*)link_p->data;
+		order_exprs.insert(order_exprs.begin(), item->expr);
+		order_desc.insert(order_desc.begin(), item->desc);
+	}
+}
+
+// the path of the only table if it reads rows in the order of ORDER BY,
+// false if the rows are to be sorted
+static bool get_order_path(const std::vector<table_manager*> &tables, expr_node_t *where,
+	const std::vector<expr_node_t*> &order_exprs, const std::vector<bool> &order_desc,
+	double limit, access_path_t &path)
+{
+	if(tables.size() != 1 || order_exprs.size() != 1)
+		return false;
+	const expr_node_t *expr = order_exprs[0];
+	if(expr->op != OPERATOR_NONE || expr->term_type != TERM_COLUMN_REF)
+		return false;
+
+	table_manager *tb = tables[0];
+	const column_ref_t *col = expr->column_ref;
+	if(col->table && std::strcmp(col->table, tb->get_table_name()) != 0)
+		return false;
+	int cid = tb->lookup_column(col->column);
+	if(cid < 0) return false;
+
+	path = choose_access_path(tb, where);
+	return order_by_index(path, cid, order_desc[0], limit);
+}
+
+// rows of GROUP BY or aggregate queries are grouped first, grouped rows and
+// rows not read in the order of ORDER BY through order_path are sorted,
+// returns whether the rows are to be sorted
+static bool plan_select_order(const select_info_t *info, const std::vector<table_manager*> &tables,
+	const std::vector<expr_node_t*> &order_exprs, const std::vector<bool> &order_desc,
+	double limit, bool &grouped, access_path_t &order_path)
+{
+	grouped = info->groups != nullptr;
+	for(linked_list_t *link_p = info->exprs; link_p; link_p = link_p->next)
+		grouped |= expression::is_aggregate((expr_node_t*)link_p->data);
+
+	return !order_exprs.empty() && (grouped
+		|| !get_order_path(tables, info->where, order_exprs, order_desc, limit, order_path));
+}
+
+// rows to be sorted are packed as [length, bytes] of each value
+static std::string pack_row(const std::vector<std::string> &row)
+{
+	std::string ret;
+	for(const std::string &item : row)
+	{
+		uint32_t len = item.size();
+		ret.append((const char*)&len, sizeof(len));
+		ret.append(item);
+	}
+
+	return ret;
+}
+
+static std::vector<std::string> unpack_row(const char *data, uint32_t len)
+{
+	std::vector<std::string> row;
+	for(const char *end = data + len; data != end; )
+	{
+		uint32_t item_len;
+		std::memcpy(&item_len, data, sizeof(item_len));
+		data += sizeof(item_len);
+		row.emplace_back(data, item_len);
+		data += item_len;
+	}
+
+	return row;
+}
+
+static void get_group_keys(const select_info_t *info, std::vector<expr_node_t*> &group_exprs)
+{
+	for(linked_list_t *link_p = info->groups; link_p; link_p = link_p->next)
+		group_exprs.insert(group_exprs.begin(), (expr_node_t*)link_p->data);
+}
+
+// width of the value of a GROUP BY expression in the group key,
+// the value is [type, bytes], and strings are zero-terminated
+static int group_key_width(const std::vector<table_manager*> &tables, const expr_node_t *expr)
+{
+	if(expr->op == OPERATOR_NONE && expr->term_type == TERM_STRING)
+		return 2 + std::strlen(expr->val_s);
+	if(expr->op == OPERATOR_NONE && expr->term_type == TERM_COLUMN_REF)
+	{
+		const column_ref_t *col = expr->column_ref;
+		for(table_manager *tb : tables)
+		{
+			if(col->table && std::strcmp(col->table, tb->get_table_name()) != 0)
+				continue;
+			int cid = tb->lookup_column(col->column);
+			if(cid >= 0 && typecast::column_to_term(tb->get_column_type(cid)) == TERM_STRING)
+				return 2 + tb->get_column_length(cid);
+			if(cid >= 0) break;
+		}
+	}
+
+	return 1 + sizeof(int);
+}
+
+static void encode_group_value(char *dst, int width, const expression &val)
+{
+	std::memset(dst, 0, width);
+	dst[0] = val.type;
+	switch(val.type)
+	{
+		case TERM_INT:
+		case TERM_DATE:
+		case TERM_FLOAT:
+			std::memcpy(dst + 1, &val.val_i, sizeof(int));
+			break;
+		case TERM_BOOL:
+			dst[1] = val.val_b;
+			break;
+		case TERM_STRING:
+			std::strncpy(dst + 1, val.val_s, width - 2);
+			break;
+		case TERM_NULL:
+			break;
+		default:
+			throw "[Error] unsupported type in GROUP BY.";
+	}
+}
+
+static expression decode_group_value(const char *src)
+{
+	expression val;
+	val.type = (term_type_t)src[0];
+	if(val.type == TERM_STRING)
+		val.val_s = (char*)src + 1;
+	else if(val.type == TERM_BOOL)
+		val.val_b = src[1];
+	else std::memcpy(&val.val_i, src + 1, sizeof(int));
+	return val;
+}
+
+template<typename Callback>
+bool dbms::select_groups(
+	const select_info_t *info,
+	const std::vector<table_manager*> &required_tables,
+	const std::vector<expr_node_t*> &exprs,
+	const std::vector<expr_node_t*> &order_exprs,
+	const std::vector<bool> &order_desc,
+	Callback callback)
+{
+	if(exprs.empty())
+	{
+		std::fprintf(stderr, "[Error] SELECT * is not supported with GROUP BY.\n");
+		printf("[Error] SELECT * is not supported with GROUP BY.\n");
+		return false;
+	}
+
+	std::vector<expr_node_t*> group_exprs;
+	get_group_keys(info, group_exprs);
+	std::vector<int> group_offset, group_width;
+	int key_size = 0;
+	for(expr_node_t *expr : group_exprs)
 	{
-		std::fprintf(stderr, "[Error] table `%s` doesn't exists.\n", info->table);
-		return;
+		group_offset.push_back(key_size);
+		group_width.push_back(group_key_width(required_tables, expr));
+		key_size += group_width.back();
 	}
 
-	int col_id = tm->lookup_column(info->column_ref->column);
-	if(col_id < 0)
+	// a select expression is either an aggregate or a GROUP BY expression
+	std::vector<operator_type_t> ops;
+	std::vector<expr_node_t*> agg_args;
+	std::vector<int> expr_source;
+	for(expr_node_t *expr : exprs)
 	{
-		std::fprintf(stderr, "[Error] column `%s' not exists.\n", info->column_ref->column);
-		return;
+		if(expression::is_aggregate(expr))
+		{
+			expr_source.push_back(ops.size());
+			ops.push_back(expr->op);
+			agg_args.push_back(expr->left);
+			continue;
+		}
+
+		std::string name = expression::to_string(expr);
+		size_t g = 0;
+		while(g != group_exprs.size() && expression::to_string(group_exprs[g]) != name)
+			++g;
+		if(g == group_exprs.size())
+		{
+			std::fprintf(stderr, "[Error] `%s` is neither aggregated nor in GROUP BY.\n", name.c_str());
+			printf("[Error] `%s` is neither aggregated nor in GROUP BY.\n", name.c_str());
+			return false;
+		}
+
+		expr_source.push_back(-1 - (int)g);
 	}
 
-	int succ_count = 0, fail_count = 0;
-	try {
-		iterate_one_table(tm, info->where, [&](table_manager *tm, record_manager *, int rid) -> bool {
-			expression val = expression::eval(info->value);
-			int col_type = tm->get_column_type(col_id);
-			if(!typecast::type_compatible(col_type, val))
-				throw "[Error] Incompatible data type.";
-			auto term_type = typecast::column_to_term(col_type);
-			bool ret = tm->modify_record(rid, col_id, typecast::expr_to_db(val, term_type));
-			succ_count += ret;
-			fail_count += 1 - ret;
-			return true;
-		} );
-	} catch(const char *msg) {
-		std::puts(msg);
-		return;
-	} catch(...) {
+	// groups are sorted by the columns of the select list
+	std::vector<int> order_cols;
+	for(expr_node_t *expr : order_exprs)
+	{
+		std::string name = expression::to_string(expr);
+		size_t i = 0;
+		while(i != exprs.size() && expression::to_string(exprs[i]) != name)
+			++i;
+		if(i == exprs.size())
+		{
+			std::fprintf(stderr, "[Error] ORDER BY `%s` is not in the select list.\n", name.c_str());
+			printf("[Error] ORDER BY `%s` is not in the select list.\n", name.c_str());
+			return false;
+		}
+
+		order_cols.push_back(i);
 	}
-	Protocol::OkPacket ok_pack;
-    std::vector<uint8_t> ok_packed = ok_pack.Pack(succ_count, 0, 2, 0);
-	std::vector< uint8_t > res;
-	res.push_back(ok_packed.size());
-	res.push_back(0);
-	res.push_back(0);
-	res.push_back(1);
-	res.insert(
-		res.end(),
-		ok_packed.begin(),
-		ok_packed.end()
+
+	// without GROUP BY, all rows are folded into one vector of states
+	aggregate_hash_table groups;
+	groups.init(key_size, ops);
+	std::vector<aggregate_state_t> only_group(ops.size());
+	for(aggregate_state_t &st : only_group)
+		init_aggregate_state(st);
+	std::vector<char> key(key_size);
+	std::vector<expression> vals(ops.size());
+	bool ok = true;
+	iterate(required_tables, info->where,
+		[&](const std::vector<table_manager*> &,
+			const std::vector<record_manager*> &,
+			const std::vector<int>& ) -> bool
+		{
+			try {
+				for(size_t i = 0; i != group_exprs.size(); ++i)
+				{
+					encode_group_value(key.data() + group_offset[i],
+						group_width[i], expression::eval(group_exprs[i]));
+				}
+
+				for(size_t i = 0; i != ops.size(); ++i)
+				{
+					if(agg_args[i]) vals[i] = expression::eval(agg_args[i]);
+					else vals[i].type = TERM_INT;  // COUNT(*)
+				}
+
+				if(group_exprs.empty())
+				{
+					for(size_t i = 0; i != ops.size(); ++i)
+						update_aggregate_state(ops[i], only_group[i], vals[i]);
+				} else {
+					groups.update(key.data(), vals.data());
+				}
+			} catch (const char *e) {
+				std::fprintf(stderr, "%s\n", e);
+				printf("%s\n", e);
+				ok = false;
+			}
+
+			return ok;
+		}
 	);
-	UnboundedBuffer reply_;
-	reply_.PushData(std::string(res.begin(), res.end()).c_str(),
-					res.size());
-	cli->SendPacket(reply_);
-	std::printf("[Info] %d row(s) updated, %d row(s) failed.\n",
-			succ_count, fail_count);
+
+	if(!ok) return false;
+
+	std::vector<expression> cols(exprs.size());
+	auto output_group = [&](const char *group_key, const aggregate_state_t *states) -> bool {
+		std::vector<std::string> row(exprs.size());
+		std::string sort_key;
+		for(size_t i = 0; i != exprs.size(); ++i)
+		{
+			// the row is in reverse order of exprs
+			std::string &cell = row[exprs.size() - 1 - i];
+			if(expr_source[i] < 0)
+			{
+				cols[i] = decode_group_value(group_key + group_offset[-1 - expr_source[i]]);
+				cell = value_to_string(cols[i]);
+				continue;
+			}
+
+			const aggregate_state_t &st = states[expr_source[i]];
+			operator_type_t op = ops[expr_source[i]];
+			cols[i].type = TERM_NONE;
+			if(op == OPERATOR_COUNT)
+			{
+				cell = std::to_string(st.count);
+			} else if(st.count == 0) {
+				cols[i].type = TERM_NULL;
+				cell = "NULL";
+			} else if(op == OPERATOR_AVG) {
+				double avg = (st.type == TERM_FLOAT ? st.val_f : st.val_i) / st.count;
+				cell = std::to_string(avg);
+			} else if(st.type == TERM_FLOAT) {
+				cell = std::to_string(st.val_f);
+			} else if(st.type == TERM_DATE) {
+				cols[i].type = TERM_DATE;
+				cols[i].val_i = st.val_i;
+				cell = value_to_string(cols[i]);
+			} else {
+				cell = std::to_string(st.val_i);
+			}
+		}
+
+		for(size_t i = 0; i != order_cols.size(); ++i)
+		{
+			int c = order_cols[i];
+			if(expr_source[c] < 0 || cols[c].type != TERM_NONE)
+			{
+				append_sort_key(sort_key, cols[c], order_desc[i]);
+				continue;
+			}
+
+			const aggregate_state_t &st = states[expr_source[c]];
+			operator_type_t op = ops[expr_source[c]];
+			if(op == OPERATOR_COUNT)
+				append_sort_key(sort_key, st.count, order_desc[i]);
+			else if(op == OPERATOR_AVG)
+				append_sort_key(sort_key, (st.type == TERM_FLOAT ? st.val_f : st.val_i) / st.count, order_desc[i]);
+			else if(st.type == TERM_FLOAT)
+				append_sort_key(sort_key, st.val_f, order_desc[i]);
+			else append_sort_key(sort_key, st.val_i, order_desc[i]);
+		}
+
+		return callback(row, sort_key);
+	};
+
+	if(group_exprs.empty())
+		output_group(nullptr, only_group.data());
+	else groups.output(output_group);
+	return true;
 }
 
 void dbms::select_rows(const select_info_t *info, Client* cli, const char *pkt)
@@ -736,7 +1298,6 @@ void dbms::select_rows(const select_info_t *info, Client* cli, const char *pkt)
 	if(!assert_db_open())
 		return;
 
-	__cache_clear_guard __guard;
 
 	// get required tables
 	std::vector<std::shared_ptr<table_manager>> alias_tables;
@@ -761,20 +1322,24 @@ void dbms::select_rows(const select_info_t *info, Client* cli, const char *pkt)
 		}
 	}
 
+	__compiled_exprs compiled;
+	bind_select(info, required_tables, compiled);
+	// only the columns referenced are read from the rows
+	__cached_columns cached_columns;
+	for(table_manager *tm : required_tables)
+		cached_columns.set(tm, referenced_columns(info, tm));
+
 	// get select expression name
 	std::vector<expr_node_t*> exprs;
 	std::vector<std::string> expr_names;
-	bool is_aggregate = false;
 	for(linked_list_t *link_p = info->exprs; link_p; link_p = link_p->next)
 	{
 		expr_node_t *expr = (expr_node_t*)link_p->data;
-		is_aggregate |= expression::is_aggregate(expr);
 		exprs.push_back(expr);
 		expr_names.push_back(expression::to_string(expr));
 	}
 
 	std::vector<std::string> headers;
-	std::vector< std::vector<std::string> > rows;
 	// output header info
 	for(size_t i = 0; i < exprs.size(); ++i)
 	{
@@ -803,389 +1368,254 @@ void dbms::select_rows(const select_info_t *info, Client* cli, const char *pkt)
 	std::fprintf(output_file, "\n");
 	printf("\n");
 
-	// pack seq
-	uint8_t seq = 1;
-	// 1.field count pack
-	std::vector<uint8_t> out_pack;
-	out_pack.push_back(1);
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.push_back(static_cast<uint8_t>(headers.size()));
-	UnboundedBuffer reply_;
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
-	out_pack.clear();
-
-	// 2.table header
+	// 1.field count, 2.table header, 3.eof
+	ResultSetWriter writer(cli, 0, RESULT_FLUSH_SIZE, RESULT_SEND_BUFFER_LIMIT);
+	writer.WriteColumnCount(headers.size());
+	linked_list_t *table_l = info->tables;
+	table_join_info_t *table_info = (table_join_info_t*)table_l->data;
 	for(auto h : headers) {
-		seq ++;
-		linked_list_t *table_l = info->tables;
-		table_join_info_t *table_info = (table_join_info_t*)table_l->data;
 		std::cout << h << ",h ";
-
 		Protocol::FieldPacket new_field_pack(h, static_cast< uint32_t >(6165), std::string(table_info->table), 
         std::string(table_info->table), std::string(cur_db->get_name()), h, 80,
         33, 0, 0);
-		std::vector< uint8_t > field_pack = new_field_pack.Pack();
-		out_pack.push_back(field_pack.size());
-		out_pack.push_back(0);
-		out_pack.push_back(0);
-		out_pack.push_back(seq);
-		out_pack.insert(
-			out_pack.end(),
-			field_pack.begin(),
-			field_pack.end()
-		);
-		reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-						out_pack.size());
-		cli->SendPacket(reply_);
-		reply_.Clear();
-		out_pack.clear();
+		writer.WritePacket(new_field_pack.Pack());
 	}
+	writer.WriteEof(0, 2);
+
+	// print a row and write it to the client, values in row are in
+	// reverse order of printing. Rows before OFFSET are skipped, and
+	// false is returned once LIMIT rows are output or the client is gone.
+	// The writer parks the statement while the client is behind, so no
+	// more than about RESULT_SEND_BUFFER_LIMIT bytes of rows are queued.
+	int counter = 0, skipped = 0;
+	auto output_row = [&](std::vector<std::string> &row) -> bool {
+		if(info->limit >= 0 && counter >= info->limit)
+			return false;
+		if(skipped < info->offset)
+		{
+			++skipped;
+			return true;
+		}
 
-	// 3.eof 
-	Protocol::EofPacket eof(0, 2);
-    std::vector< uint8_t > eof_packet = eof.Pack();
-	seq ++; // 254, 0, 0, 2, 0
-	out_pack.push_back(eof_packet.size());
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.insert(
-		out_pack.end(),
-		eof_packet.begin(),
-		eof_packet.end()
-	);
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
-	out_pack.clear();
+		for(size_t i = 0; i != row.size(); ++i)
+		{
+			if(i != 0) {
+				std::fprintf(output_file, ",");
+				printf(",");
+			}
+			const std::string &item = row[row.size() - 1 - i];
+			std::fprintf(output_file, "%s", item.c_str());
+			printf("%s", item.c_str());
+		}
 
-	if(is_aggregate)
-	{
-		select_rows_aggregate(
-			info,
-			required_tables,
-			exprs,
-			expr_names,
-			cli,
-			seq
-		);
+		std::fprintf(output_file, "\n");
+		printf("\n");
 
-		return;
-	}
+		std::cout << std::endl;
+		for(const std::string &item : row)
+			std::cout << item << "  | ";
+		std::cout << std::endl;
 
-	// iterate records
-	int counter = 0;
+		if(!writer.WriteRow(row))
+			return false;
 
-	iterate(required_tables, info->where,
-		[&](const std::vector<table_manager*> &tables,
-			const std::vector<record_manager*> &records,
-			const std::vector<int>& )
-		{
-			std::vector<std::string> row;
+		++counter;
+		return info->limit < 0 || counter < info->limit;
+	};
+
+	std::vector<expr_node_t*> order_exprs;
+	std::vector<bool> order_desc;
+	get_order_keys(info, order_exprs, order_desc);
+
+	// rows to be sorted are output after all of them are read, only
+	// the first OFFSET + LIMIT of them are kept by the sorter
+	double limit = info->limit >= 0 ? (double)info->offset + info->limit : -1;
+	access_path_t order_path;
+	bool grouped;
+	bool sort_rows = plan_select_order(info, required_tables,
+		order_exprs, order_desc, limit, grouped, order_path);
+	external_sorter sorter;
+	if(limit >= 0) sorter.set_limit(limit);
+
+	auto visit = [&](const std::vector<table_manager*> &tables,
+		const std::vector<record_manager*> &,
+		const std::vector<int>& ) -> bool
+	{
+		std::vector<std::string> row;
+		std::string sort_key;
+		try {
 			for(size_t i = 0; i < exprs.size(); ++i)
+				row.push_back(value_to_string(expression::eval(exprs[i])));
+
+			if(sort_rows)
 			{
-				expression ret;
-				try {
-					ret = expression::eval(exprs[i]);
-				} catch (const char *e) {
-					std::fprintf(stderr, "%s\n", e);
-					printf("%s\n", e);
-					return false;
-				}
-				// std::printf("%s\t = ", expr_names[i].c_str());
-				if(i != 0) {
-					std::fprintf(output_file, ",");
-					printf(",");
-				}
-        switch(ret.type)
-				{
-					case TERM_INT:
-						std::fprintf(output_file, "%d", ret.val_i);
-						printf("%d", ret.val_i);
-						row.insert(row.begin(), std::to_string(ret.val_i));
-            break;
-					case TERM_FLOAT:
-						std::fprintf(output_file, "%f", ret.val_f);
-						printf("%f", ret.val_f);
-						row.insert(row.begin(), std::to_string(ret.val_f));
-            break;
-					case TERM_STRING:
-						std::fprintf(output_file, "%s", ret.val_s);
-					    row.insert(row.begin(), ret.val_s);
-					    printf("%s", ret.val_s);
-						break;
-					case TERM_BOOL:
-						std::fprintf(output_file, "%s", ret.val_b ? "TRUE" : "FALSE");
-						printf("%s", (ret.val_b ? "TRUE" : "FALSE"));
-						row.insert(row.begin(), ret.val_b ? "TRUE" : "FALSE");
-            break;
-					case TERM_DATE: {
-						char date_buf[32];
-						time_t time = ret.val_i;
-						auto tm = std::localtime(&time);
-						std::strftime(date_buf, 32, DATE_TEMPLATE, tm);
-						printf("%s", date_buf);
-						std::fprintf(output_file, "%s", date_buf);
-						row.insert(row.begin(), date_buf);
-						break; 
-					}
-					case TERM_NULL:
-						std::fprintf(output_file, "NULL");
-						row.insert(row.begin(), "NULL");
-						printf("NULL");
-            break;
-					default:
-						debug_puts("[Error] Data type not supported!");
-				}
-			}
-		
-			if(exprs.size() == 0)
-			{
-				for(size_t i = 0; i < tables.size(); ++i)
-				{
-					if(i != 0) {
-						std::fprintf(output_file, ",");
-						printf(",");
-					}
-					tables[i]->dump_record(output_file, records[i], row);
-				}
-				rows.push_back(row);
-			} else {
-				rows.push_back(row);
+				for(size_t i = 0; i != order_exprs.size(); ++i)
+					append_sort_key(sort_key, expression::eval(order_exprs[i]), order_desc[i]);
 			}
-			std::fprintf(output_file, "\n");
-			printf("\n");
-			++counter;
-			
-			return true;
+		} catch (const char *e) {
+			std::fprintf(stderr, "%s\n", e);
+			printf("%s\n", e);
+			return false;
 		}
-	);
 
-	std::printf("[Info] %d row(s) selected.\n", counter);
-
-	for(auto r : rows) {
-		seq ++;
-		std::cout << std::endl;
-		for(auto item : r) {
-			std::cout  << item << "  | ";
+		if(exprs.size() == 0)
+		{
+			for(size_t i = 0; i < tables.size(); ++i)
+				tables[i]->dump_cached_record(nullptr, row);
 		}
-		std::cout << std::endl;
-		Protocol::RowPacket row_pack(r);
-		std::vector< uint8_t > row_packed = row_pack.Pack();
-		std::vector< uint8_t > out_pack;
-		out_pack.push_back(row_packed.size());
-		out_pack.push_back(0);
-		out_pack.push_back(0);
-		out_pack.push_back(seq);
-		out_pack.insert(
-			out_pack.end(),
-			row_packed.begin(),
-			row_packed.end()
-		);
-		reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-						out_pack.size());
-		cli->SendPacket(reply_);
-		reply_.Clear();
-		out_pack.clear();
+
+		// the values are sent in reverse order of the columns
+		std::reverse(row.begin(), row.end());
+
+		if(!sort_rows)
+			return output_row(row);
+
+		std::string payload = pack_row(row);
+		sorter.add(sort_key, payload.data(), payload.size());
+		return true;
+	};
+
+	if(grouped)
+	{
+		select_groups(info, required_tables, exprs, order_exprs, order_desc,
+			[&](std::vector<std::string> &row, const std::string &sort_key) -> bool {
+				if(!sort_rows)
+					return output_row(row);
+
+				std::string payload = pack_row(row);
+				sorter.add(sort_key, payload.data(), payload.size());
+				return true;
+			} );
+	} else if(!order_exprs.empty() && !sort_rows) {
+		// the index gives the order
+		std::vector<expr_node_t*> and_cond;
+		extract_and_cond(info->where, and_cond);
+		iterate_access_path(order_path, and_cond,
+			[&](table_manager *, record_manager *rm, int rid) -> bool {
+				return visit(required_tables,
+					std::vector<record_manager*>(1, rm), std::vector<int>(1, rid));
+			} );
+	} else {
+		iterate(required_tables, info->where, visit);
 	}
-	// 5.eof
-	seq ++;
-	out_pack.push_back(eof_packet.size());
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.insert(
-		out_pack.end(),
-		eof_packet.begin(),
-		eof_packet.end()
-	);
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
+
+	if(sort_rows)
+	{
+		sorter.output([&](const char *payload, uint32_t len) -> bool {
+			std::vector<std::string> row = unpack_row(payload, len);
+			return output_row(row);
+		} );
+	}
+
+	std::printf("[Info] %d row(s) selected.\n", counter);
+
+	// 5.eof, sent along with the rows not flushed yet
+	writer.WriteEof(0, 2);
+	writer.Flush();
     std::fprintf(output_file, "\n");
 	std::fflush(output_file);
 }
 
-void dbms::select_rows_aggregate(
-	const select_info_t *info,
-	const std::vector<table_manager*> &required_tables,
-	const std::vector<expr_node_t*> &exprs,
-	const std::vector<std::string> &, 
-	Client* cli,
-	uint8_t seq)
+void dbms::explain_select(const select_info_t *info, Client* cli, const char *pkt)
 {
-	if(exprs.size() != 1)
-	{
-		std::fprintf(stderr, "[Error] Support only for one select expression for aggregate select.");
-		printf("[Error] Support only for one select expression for aggregate select.");
+	if(!assert_db_open())
 		return;
-	}
 
-	// check aggregate type
-	expr_node_t *expr = exprs[0];
-	int val_i = 0;
-	float val_f = 0;
-	if(expr->op == OPERATOR_MIN)
+	std::vector<std::shared_ptr<table_manager>> alias_tables;
+	std::vector<table_manager*> required_tables;
+	for(linked_list_t *table_l = info->tables; table_l; table_l = table_l->next)
 	{
-		val_i = std::numeric_limits<int>::max();
-		val_f = std::numeric_limits<float>::max();
-	} else if(expr->op == OPERATOR_MAX) {
-		val_i = std::numeric_limits<int>::min();
-		val_f = std::numeric_limits<float>::min();
+		table_join_info_t *table_info = (table_join_info_t*)table_l->data;
+		table_manager *tm = cur_db->get_table(table_info->table);
+		if(tm == nullptr)
+		{
+			std::fprintf(stderr, "[Error] table `%s` doesn't exists.\n", table_info->table);
+			return;
+		} else if(table_info->alias == nullptr) {
+			required_tables.push_back(tm);
+		} else {
+			auto alias = tm->mirror(table_info->alias);
+			alias_tables.push_back(alias);
+			required_tables.push_back(alias.get());
+		}
 	}
 
-	term_type_t agg_type = TERM_NONE;
+	std::vector<expr_node_t*> order_exprs;
+	std::vector<bool> order_desc;
+	get_order_keys(info, order_exprs, order_desc);
 
-	int counter = 0;
-	iterate(required_tables, info->where,
-		[&](const std::vector<table_manager*> &,
-			const std::vector<record_manager*> &,
-			const std::vector<int>& )
+	std::vector<expr_node_t*> group_exprs;
+	get_group_keys(info, group_exprs);
+
+	std::vector<std::string> plan;
+	double limit = info->limit >= 0 ? (double)info->offset + info->limit : -1;
+	access_path_t order_path;
+	bool grouped;
+	bool sort_rows = plan_select_order(info, required_tables,
+		order_exprs, order_desc, limit, grouped, order_path);
+	if(!grouped && !order_exprs.empty() && !sort_rows)
+	{
+		plan.push_back(order_path.to_string());
+	} else {
+		if(required_tables.size() == 1)
 		{
-			if(expr->op != OPERATOR_COUNT)
-			{
-				expression ret;
-				try {
-					ret = expression::eval(expr->left);
-				} catch (const char *e) {
-					std::fprintf(stderr, "%s\n", e);
-					return false;
-				}
+			plan.push_back(choose_access_path(required_tables[0], info->where).to_string());
+		} else {
+			plan = plan_join(required_tables, info->where).to_string(required_tables);
+		}
 
-				agg_type = ret.type;
-				if(ret.type == TERM_FLOAT)
-				{
-					switch(expr->op)
-					{
-						case OPERATOR_SUM:
-						case OPERATOR_AVG:
-							val_f += ret.val_f;
-							break;
-						case OPERATOR_MIN:
-							if(ret.val_f < val_f)
-								val_f = ret.val_f;
-							break;
-						case OPERATOR_MAX:
-							if(ret.val_f > val_f)
-								val_f = ret.val_f;
-							break;
-						default: break;
-					}
-				} else {
-					switch(expr->op)
-					{
-						case OPERATOR_SUM:
-						case OPERATOR_AVG:
-							val_i += ret.val_i;
-							break;
-						case OPERATOR_MIN:
-							if(ret.val_i < val_i)
-								val_i = ret.val_i;
-							break;
-						case OPERATOR_MAX:
-							if(ret.val_i > val_i)
-								val_i = ret.val_i;
-							break;
-						default: break;
-					}
-				}
+		if(!group_exprs.empty())
+		{
+			std::string line = "HASH GROUP BY ";
+			for(size_t i = 0; i != group_exprs.size(); ++i)
+			{
+				if(i != 0) line += ", ";
+				line += expression::to_string(group_exprs[i]);
 			}
 
-			++counter;
-			return true;
+			plan.push_back(line);
+		} else if(grouped) {
+			plan.push_back("AGGREGATE");
 		}
-	);
-
-	std::string result;
 
-	if(expr->op == OPERATOR_COUNT)
-	{
-		std::fprintf(output_file, "%d\n", counter);
-		result = std::to_string(counter);
-	} else {
-		if(agg_type != TERM_FLOAT && agg_type != TERM_INT)
+		if(sort_rows)
 		{
-			std::fprintf(stderr, "[Error] Aggregate only support for int and float type.\n");
-			return;
-		}
+			std::string line = limit >= 0 ? "TOP-N SORT BY " : "SORT BY ";
+			for(size_t i = 0; i != order_exprs.size(); ++i)
+			{
+				if(i != 0) line += ", ";
+				line += expression::to_string(order_exprs[i]) + (order_desc[i] ? " DESC" : "");
+			}
 
-		if(expr->op == OPERATOR_AVG)
-		{
-			if(agg_type == TERM_INT)
-				val_f = double(val_i) / counter;
-			else val_f /= counter;
-			std::fprintf(output_file, "%f\n", val_f);
-			printf("%f\n", val_f);
-			result = std::to_string(val_f);
-		} else if(agg_type == TERM_FLOAT) {
-			std::fprintf(output_file, "%f\n", val_f);
-			printf("%f\n", val_f);
-			result = std::to_string(val_f);
-		} else if(agg_type == TERM_INT) {
-			std::fprintf(output_file, "%d\n", val_i);
-			printf("%d\n", val_i);
-			result = std::to_string(val_i);
+			plan.push_back(line);
 		}
 	}
 
-	seq++;
-	std::vector<std::string> row;
-	row.push_back(result);
-	Protocol::RowPacket row_pack(row);
-	std::vector< uint8_t > row_packed = row_pack.Pack();
-	std::vector< uint8_t > out_pack;
-	out_pack.push_back(row_packed.size());
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.insert(
-		out_pack.end(),
-		row_packed.begin(),
-		row_packed.end()
-	);
-	UnboundedBuffer reply_;
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
-	out_pack.clear();
-
-	// eof
-	seq ++;
-	Protocol::EofPacket eof(0, 2);
-    std::vector< uint8_t > eof_packet = eof.Pack();
-	out_pack.push_back(eof_packet.size());
-	out_pack.push_back(0);
-	out_pack.push_back(0);
-	out_pack.push_back(seq);
-	out_pack.insert(
-		out_pack.end(),
-		eof_packet.begin(),
-		eof_packet.end()
-	);
-	reply_.PushData(std::string(out_pack.begin(), out_pack.end()).c_str(),
-					out_pack.size());
-	cli->SendPacket(reply_);
-	reply_.Clear();
+	if(info->limit >= 0)
+	{
+		plan.push_back("LIMIT " + std::to_string(info->limit)
+			+ (info->offset ? " OFFSET " + std::to_string(info->offset) : ""));
+	}
 
-	std::printf("[Info] %d row(s) selected.\n", counter);
-	std::fprintf(output_file, "\n");
-	printf("\n");
-	std::fflush(output_file);
+	ResultSetWriter writer(cli, pkt[3], RESULT_FLUSH_SIZE, RESULT_SEND_BUFFER_LIMIT);
+	writer.WriteColumnCount(1);
+	Protocol::FieldPacket field_pack("plan", static_cast< uint32_t >(6165), "", "",
+		std::string(cur_db->get_name()), "plan", 80, 33, 0, 0);
+	writer.WritePacket(field_pack.Pack());
+	writer.WriteEof(0, 2);
+	for(std::string &line : plan)
+	{
+		std::puts(line.c_str());
+		writer.WriteRow({ line });
+	}
+	writer.WriteEof(0, 2);
+	writer.Flush();
 }
 
 void dbms::delete_rows(const delete_info_t *info, Client* cli, const char *pkt)
 {
 	if(!assert_db_open())
 		return;
-	__cache_clear_guard __guard;
 
 	std::vector<int> delete_list;
 	table_manager *tm = cur_db->get_table(info->table);
@@ -1195,6 +1625,9 @@ void dbms::delete_rows(const delete_info_t *info, Client* cli, const char *pkt)
 		return;
 	}
 
+	bind_columns(info->where, std::vector<table_manager*>(1, tm));
+	__compiled_exprs compiled;
+	compiled.add_cond(info->where);
 	iterate_one_table_with_index(tm, info->where,
 		[&delete_list](table_manager*, record_manager*, int rid) -> bool {
 			delete_list.push_back(rid);
@@ -1228,7 +1661,6 @@ void dbms::insert_rows(const insert_info_t *info, Client* cli, const char *pkt)
 {
 	if(!assert_db_open())
 		return;
-	__cache_clear_guard __guard;
 
 	table_manager *tb = cur_db->get_table(info->table);
 	if(tb == nullptr)
@@ -1358,25 +1790,6 @@ expr_node_t *dbms::get_join_cond(expr_node_t *cond)
 	}
 }
 
-bool dbms::find_longest_path(int now, int depth, int *mark, int *path, std::vector<std::vector<int>> &E, int excepted_len, int &max_depth)
-{
-	mark[now] = 1;
-	path[depth] = now;
-	if(depth > max_depth)
-		max_depth = depth;
-	if(depth == excepted_len)
-		return true;
-	for(int i = 0; i != (int)E.size(); ++i)
-	{
-		if(!E[now][i] || mark[i]) continue;
-		if(find_longest_path(i, depth + 1, mark, path, E, excepted_len, max_depth))
-			return true;
-	}
-
-	mark[now] = 0;
-	return false;
-}
-
 bool dbms::value_exists(const char *table, const char *column, const char *data)
 {
 	if(!assert_db_open())
@@ -1390,3 +1803,44 @@ bool dbms::value_exists(const char *table, const char *column, const char *data)
 
 	return tm->value_exists(column, data);
 }
+
+bool dbms::get_statement_tables(const parser_result_t *result, std::vector<std::string> &tables)
+{
+	const char *table = nullptr;
+	switch(result->type)
+	{
+		case SQL_SELECT:
+		case SQL_EXPLAIN: {
+			const select_info_t *info = (const select_info_t*)result->param;
+			for(linked_list_t *l = info->tables; l; l = l->next)
+				tables.push_back(((table_join_info_t*)l->data)->table);
+			return true;
+		}
+		case SQL_INSERT:
+			table = ((const insert_info_t*)result->param)->table;
+			break;
+		case SQL_UPDATE:
+			table = ((const update_info_t*)result->param)->table;
+			break;
+		case SQL_DELETE:
+			tables.push_back(((const delete_info_t*)result->param)->table);
+			return true;
+		case SQL_ANALYZE_TABLE:
+			tables.push_back((const char*)result->param);
+			return true;
+		default:
+			return false;
+	}
+
+	// the foreign keys of the rows written are looked up in the tables
+	// they refer to
+	tables.push_back(table);
+	table_manager *tm = cur_db ? cur_db->get_table(table) : nullptr;
+	if(tm != nullptr)
+	{
+		for(int i = 0; i < tm->get_foreign_key_num(); ++i)
+			tables.push_back(tm->get_foreign_key_ref_table(i));
+	}
+
+	return true;
+}
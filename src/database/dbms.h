@@ -2,6 +2,10 @@
 #define __TRIVIALDB_DBMS__
 #include "database.h"
 #include "../table/table.h"
+#include "access_path.h"
+#include "join_plan.h"
+#include "external_sort.h"
+#include "hash_aggregate.h"
 #include "../parser/defs.h"
 #include "../expression/expression.h"
 #include <cstdio>
@@ -50,6 +54,7 @@ public:
 
 	void create_table(const table_header_t *header, Client* cli, const char *pkt);
 	void show_table(const char *table_name);
+	void analyze_table(const char *table_name, Client* cli, const char *pkt);
 	void drop_table(const char *table_name);
 
 	void create_index(const char *tb_name, const char *col_name);
@@ -58,17 +63,25 @@ public:
 	void insert_rows(const insert_info_t *info, Client* cli, const char *pkt);
 	void delete_rows(const delete_info_t *info, Client* cli, const char *pkt);
 	void select_rows(const select_info_t *info, Client* cli, const char *pkt);
+	void explain_select(const select_info_t *info, Client* cli, const char *pkt);
 	void update_rows(const update_info_t *info, Client* cli, const char *pkt);
 
 	void switch_select_output(const char *filename);
 
-	void select_rows_aggregate(
+	// add the tables a statement reads or writes to tables, false if it
+	// works on the database as a whole
+	bool get_statement_tables(const parser_result_t *result, std::vector<std::string> &tables);
+
+	// callback(row, sort_key) for each group of GROUP BY, or for the
+	// only group of an aggregate select without GROUP BY, false if stopped
+	template<typename Callback>
+	bool select_groups(
 		const select_info_t *info,
 		const std::vector<table_manager*> &required_tables,
 		const std::vector<expr_node_t*> &exprs,
-		const std::vector<std::string> &expr_names, 
-		Client* cli,
-		uint8_t seq);
+		const std::vector<expr_node_t*> &order_exprs,
+		const std::vector<bool> &order_desc,
+		Callback callback);
 
 	bool value_exists(const char *table, const char *column, const char *data);
 
@@ -86,13 +99,26 @@ public:
 	bool iterate_one_table_with_index(table_manager* table,
 			expr_node_t *cond, Callback callback);
 	template<typename Callback>
-	bool iterate_many_tables_impl(
+	static bool iterate_index_range(const index_range_t &range, Callback callback);
+	template<typename Callback>
+	bool iterate_access_path(const access_path_t &path,
+			const std::vector<expr_node_t*> &and_cond, Callback callback);
+	template<typename Callback>
+	bool iterate_join_step(
+		const join_plan_t &plan, size_t now,
+		const std::vector<table_manager*> &table_list,
+		std::vector<record_manager*> &record_list,
+		std::vector<int> &rid_list,
+		std::vector<join_hash_table> &hash_tables,
+		Callback callback);
+	template<typename Callback>
+	bool iterate_merge_join(
+		const join_plan_t &plan,
 		const std::vector<table_manager*> &table_list,
 		std::vector<record_manager*> &record_list,
 		std::vector<int> &rid_list,
-		std::vector<std::vector<expr_node_t*>> &index_cond,
-		int *iter_order, int *index_cid, index_manager** index,
-		expr_node_t *cond, Callback callback, int now);
+		std::vector<join_hash_table> &hash_tables,
+		Callback callback);
 	template<typename Callback>
 	void iterate_many_tables(
 		const std::vector<table_manager*> &table_list,
@@ -100,7 +126,9 @@ public:
 
 	static expr_node_t *get_join_cond(expr_node_t *cond);
 	static void extract_and_cond(expr_node_t *cond, std::vector<expr_node_t*> &and_cond);
-	static bool find_longest_path(int now, int depth, int *mark, int *path, std::vector<std::vector<int>> &E, int excepted_len, int &max_depth);
+	// bind the column references in expr to the cached records of tables,
+	// the references not found are left unbound and fail when evaluated
+	static void bind_columns(expr_node_t *expr, const std::vector<table_manager*> &tables);
 
 public:
 	static dbms* get_instance()
@@ -0,0 +1,298 @@
+#include "external_sort.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+static void append_big_endian(std::string &key, uint64_t x, int bytes)
+{
+	for(int i = bytes - 1; i >= 0; --i)
+		key.push_back((char)((x >> (i * 8)) & 0xff));
+}
+
+static void invert_key(std::string &key, size_t begin)
+{
+	for(size_t i = begin; i != key.size(); ++i)
+		key[i] = ~key[i];
+}
+
+void append_sort_key(std::string &key, const expression &val, bool desc)
+{
+	size_t begin = key.size();
+	if(val.type == TERM_NULL)
+	{
+		key.push_back(0);
+	} else {
+		key.push_back(1);
+		switch(val.type)
+		{
+			case TERM_INT:
+			case TERM_DATE:
+				append_big_endian(key, (uint32_t)val.val_i ^ 0x80000000u, 4);
+				break;
+			case TERM_FLOAT: {
+				uint32_t bits;
+				std::memcpy(&bits, &val.val_f, sizeof(bits));
+				// negative values are flipped entirely
+				append_big_endian(key, (bits & 0x80000000u) ? ~bits : bits | 0x80000000u, 4);
+				break;
+			}
+			case TERM_STRING:
+				// the terminator makes a string less than its extensions
+				key.append(val.val_s);
+				key.push_back(0);
+				break;
+			case TERM_BOOL:
+				key.push_back(val.val_b ? 1 : 0);
+				break;
+			default:
+				throw "[Error] unsupported type in ORDER BY.";
+		}
+	}
+
+	if(desc) invert_key(key, begin);
+}
+
+void append_sort_key(std::string &key, int64_t val, bool desc)
+{
+	size_t begin = key.size();
+	key.push_back(1);
+	append_big_endian(key, (uint64_t)val ^ 0x8000000000000000ull, 8);
+	if(desc) invert_key(key, begin);
+}
+
+void append_sort_key(std::string &key, double val, bool desc)
+{
+	size_t begin = key.size();
+	uint64_t bits;
+	std::memcpy(&bits, &val, sizeof(bits));
+	key.push_back(1);
+	append_big_endian(key, (bits & 0x8000000000000000ull) ? ~bits : bits | 0x8000000000000000ull, 8);
+	if(desc) invert_key(key, begin);
+}
+
+external_sorter::external_sorter(size_t memory_budget)
+	: memory_budget(memory_budget), limit(SIZE_MAX), garbage(0),
+	  spill(nullptr), next_entry(0), last_run(-1)
+{
+}
+
+external_sorter::~external_sorter()
+{
+	delete spill;
+}
+
+double external_sorter::estimate_cost(double rows, double record_size, double limit)
+{
+	if(limit >= 0 && limit < rows)
+	{
+		// each record is compared with the heap of limit records
+		return rows * std::log2(std::max(limit, 2.0)) * COST_SORT_COMPARE;
+	}
+
+	double cost = rows * std::log2(std::max(rows, 2.0)) * COST_SORT_COMPARE;
+	double bytes = rows * (record_size + sizeof(entry_t));
+	if(bytes > SORT_MEMORY_BUDGET)
+	{
+		// every record is written to a run and read back once
+		cost += 2 * bytes / PAGE_SIZE * COST_SEQ_PAGE;
+	}
+
+	return cost;
+}
+
+int external_sorter::compare_keys(const char *a, uint32_t a_len, const char *b, uint32_t b_len)
+{
+	int r = std::memcmp(a, b, std::min(a_len, b_len));
+	if(r != 0) return r;
+	return a_len < b_len ? -1 : (a_len > b_len ? 1 : 0);
+}
+
+bool external_sorter::entry_less(const entry_t &a, const entry_t &b) const
+{
+	int r = std::memcmp(a.prefix, b.prefix, SORT_KEY_PREFIX);
+	if(r != 0) return r < 0;
+
+	const char *ra = arena.data() + a.offset, *rb = arena.data() + b.offset;
+	uint32_t a_len = *(const uint32_t*)ra, b_len = *(const uint32_t*)rb;
+	if(a_len <= SORT_KEY_PREFIX && b_len <= SORT_KEY_PREFIX)
+		return a_len < b_len;
+	return compare_keys(ra + 8, a_len, rb + 8, b_len) < 0;
+}
+
+void external_sorter::add(const std::string &key, const char *payload, uint32_t payload_len)
+{
+	entry_t e;
+	std::memset(e.prefix, 0, SORT_KEY_PREFIX);
+	std::memcpy(e.prefix, key.data(), std::min<size_t>(key.size(), SORT_KEY_PREFIX));
+	e.offset = arena.size();
+
+	uint32_t key_len = key.size();
+	arena.insert(arena.end(), (const char*)&key_len, (const char*)&key_len + 4);
+	arena.insert(arena.end(), (const char*)&payload_len, (const char*)&payload_len + 4);
+	arena.insert(arena.end(), key.begin(), key.end());
+	arena.insert(arena.end(), payload, payload + payload_len);
+	if(limit != SIZE_MAX)
+	{
+		add_to_heap(e);
+		return;
+	}
+
+	entries.push_back(e);
+	if(entries.size() * sizeof(entry_t) + arena.size() > memory_budget)
+		write_run();
+}
+
+void external_sorter::add_to_heap(const entry_t &e)
+{
+	auto less = [this](const entry_t &a, const entry_t &b) { return entry_less(a, b); };
+	if(entries.size() < limit)
+	{
+		entries.push_back(e);
+		std::push_heap(entries.begin(), entries.end(), less);
+		return;
+	}
+
+	if(limit == 0 || !entry_less(e, entries.front()))
+	{
+		// the record is the last one of the arena
+		arena.resize(e.offset);
+		return;
+	}
+
+	std::pop_heap(entries.begin(), entries.end(), less);
+	const uint32_t *dropped = (const uint32_t*)(arena.data() + entries.back().offset);
+	garbage += 8 + dropped[0] + dropped[1];
+	entries.back() = e;
+	std::push_heap(entries.begin(), entries.end(), less);
+
+	if(garbage > arena.size() / 2)
+		compact_arena();
+}
+
+void external_sorter::compact_arena()
+{
+	std::vector<char> live;
+	live.reserve(arena.size() - garbage);
+	for(entry_t &e : entries)
+	{
+		const char *rec = arena.data() + e.offset;
+		uint32_t len = 8 + ((const uint32_t*)rec)[0] + ((const uint32_t*)rec)[1];
+		e.offset = live.size();
+		live.insert(live.end(), rec, rec + len);
+	}
+
+	arena.swap(live);
+	garbage = 0;
+}
+
+void external_sorter::write_run()
+{
+	if(!spill)
+	{
+		spill = new spill_file("__sort");
+		std::printf("[Info] Sort exceeds %zu bytes of memory, write sorted runs to %s.\n",
+				memory_budget, spill->get_filename());
+	}
+
+	std::sort(entries.begin(), entries.end(),
+		[this](const entry_t &a, const entry_t &b) { return entry_less(a, b); } );
+
+	runs.emplace_back();
+	spill_file::stream_t &s = runs.back();
+	for(const entry_t &e : entries)
+	{
+		const char *rec = arena.data() + e.offset;
+		uint32_t key_len = ((const uint32_t*)rec)[0], payload_len = ((const uint32_t*)rec)[1];
+		spill->append(s, rec, 8 + key_len + payload_len);
+	}
+
+	entries.clear();
+	arena.clear();
+}
+
+bool external_sorter::read_run(int r)
+{
+	run_cursor_t &c = cursors[r];
+	const spill_file::stream_t &s = runs[r];
+	if(c.pos == s.length)
+		return false;
+
+	uint32_t len[2];
+	spill->read(s, c.pos, len, sizeof(len));
+	c.key_len = len[0];
+	c.payload_len = len[1];
+	c.buf.resize(c.key_len + c.payload_len);
+	spill->read(s, c.pos + sizeof(len), c.buf.data(), c.buf.size());
+	c.pos += sizeof(len) + c.buf.size();
+	return true;
+}
+
+bool external_sorter::run_greater(int a, int b) const
+{
+	const run_cursor_t &x = cursors[a], &y = cursors[b];
+	return compare_keys(x.buf.data(), x.key_len, y.buf.data(), y.key_len) > 0;
+}
+
+void external_sorter::finish()
+{
+	if(!spill)
+	{
+		std::sort(entries.begin(), entries.end(),
+			[this](const entry_t &a, const entry_t &b) { return entry_less(a, b); } );
+		next_entry = 0;
+		return;
+	}
+
+	if(!entries.empty())
+		write_run();
+
+	auto greater = [this](int a, int b) { return run_greater(a, b); };
+	cursors.resize(runs.size());
+	heap.clear();
+	for(int i = 0; i != (int)runs.size(); ++i)
+	{
+		cursors[i].pos = 0;
+		if(read_run(i))
+		{
+			heap.push_back(i);
+			std::push_heap(heap.begin(), heap.end(), greater);
+		}
+	}
+
+	last_run = -1;
+}
+
+bool external_sorter::next(const char **payload, uint32_t *payload_len)
+{
+	if(!spill)
+	{
+		if(next_entry == entries.size())
+			return false;
+		const char *rec = arena.data() + entries[next_entry++].offset;
+		*payload_len = ((const uint32_t*)rec)[1];
+		*payload = rec + 8 + ((const uint32_t*)rec)[0];
+		return true;
+	}
+
+	// the record returned last time is kept until now
+	auto greater = [this](int a, int b) { return run_greater(a, b); };
+	if(last_run >= 0 && read_run(last_run))
+	{
+		heap.push_back(last_run);
+		std::push_heap(heap.begin(), heap.end(), greater);
+	}
+
+	last_run = -1;
+	if(heap.empty())
+		return false;
+
+	std::pop_heap(heap.begin(), heap.end(), greater);
+	last_run = heap.back();
+	heap.pop_back();
+
+	const run_cursor_t &c = cursors[last_run];
+	*payload = c.buf.data() + c.key_len;
+	*payload_len = c.payload_len;
+	return true;
+}
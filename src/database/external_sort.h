@@ -0,0 +1,104 @@
+#ifndef __TRIVIALDB_EXTERNAL_SORT__
+#define __TRIVIALDB_EXTERNAL_SORT__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "../defs.h"
+#include "../fs/spill_file.h"
+#include "../expression/expression.h"
+
+/* Sort records of (key, payload) in the byte order of the keys, where
+ * keys are normalized by append_sort_key().
+ *
+ * The entries sorted in memory hold a fixed-width prefix of the key,
+ * so most comparisons are a memcmp of SORT_KEY_PREFIX bytes, and the
+ * full keys are only compared if the prefixes are equal. Once the
+ * records exceed the memory budget, they are sorted and written to a
+ * temporary page file as a run, and the runs are k-way merged at last.
+ *
+ * If only the first records are wanted, the entries are kept as a
+ * max-heap of at most limit records instead, and never spilled. */
+class external_sorter
+{
+	struct entry_t
+	{
+		char prefix[SORT_KEY_PREFIX];
+		// record in arena: [key_len, payload_len, key, payload]
+		size_t offset;
+	};
+
+	// a sorted run being merged
+	struct run_cursor_t
+	{
+		size_t pos;
+		uint32_t key_len, payload_len;
+		std::vector<char> buf;
+	};
+
+	size_t memory_budget;
+	std::vector<entry_t> entries;
+	std::vector<char> arena;
+	// limit is SIZE_MAX if all records are sorted, garbage is the
+	// bytes of the arena dropped from the heap
+	size_t limit, garbage;
+
+	spill_file *spill;
+	std::vector<spill_file::stream_t> runs;
+	std::vector<run_cursor_t> cursors;
+	// cursors ordered as a heap, the smallest key first
+	std::vector<int> heap;
+	size_t next_entry;
+	int last_run;
+
+private:
+	static int compare_keys(const char *a, uint32_t a_len, const char *b, uint32_t b_len);
+	bool entry_less(const entry_t &a, const entry_t &b) const;
+	bool run_greater(int a, int b) const;
+	bool read_run(int r);
+	void write_run();
+	void add_to_heap(const entry_t &e);
+	void compact_arena();
+
+public:
+	external_sorter(size_t memory_budget = SORT_MEMORY_BUDGET);
+	~external_sorter();
+	external_sorter(const external_sorter&) = delete;
+	external_sorter& operator = (const external_sorter&) = delete;
+
+	// keep only the first n records in order
+	void set_limit(size_t n) { limit = n; }
+	void add(const std::string &key, const char *payload, uint32_t payload_len);
+	// sort after all records are added
+	void finish();
+	// the next payload in order, false if no more
+	bool next(const char **payload, uint32_t *payload_len);
+
+	// callback(payload, payload_len) in the order of keys, false if stopped
+	template<typename Callback>
+	bool output(Callback callback)
+	{
+		finish();
+		const char *payload;
+		uint32_t payload_len;
+		while(next(&payload, &payload_len))
+		{
+			if(!callback(payload, payload_len))
+				return false;
+		}
+
+		return true;
+	}
+
+	// limit < 0 if all records are sorted
+	static double estimate_cost(double rows, double record_size, double limit = -1);
+};
+
+// append the value to a key in which memcmp gives the order of values,
+// NULL is the smallest value
+void append_sort_key(std::string &key, const expression &val, bool desc);
+// the same for the 64-bit results of aggregates
+void append_sort_key(std::string &key, int64_t val, bool desc);
+void append_sort_key(std::string &key, double val, bool desc);
+
+#endif
@@ -0,0 +1,244 @@
+#include "hash_aggregate.h"
+#include "../utils/hasher.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+void init_aggregate_state(aggregate_state_t &st)
+{
+	st.val_i = 0;
+	st.val_f = 0;
+	st.count = 0;
+	st.type  = TERM_NONE;
+}
+
+void update_aggregate_state(operator_type_t op, aggregate_state_t &st, const expression &val)
+{
+	if(val.type == TERM_NULL)
+		return;
+	if(op == OPERATOR_COUNT)
+	{
+		++st.count;
+		return;
+	}
+
+	if(val.type != TERM_INT && val.type != TERM_FLOAT
+		&& !(val.type == TERM_DATE && (op == OPERATOR_MIN || op == OPERATOR_MAX)))
+		throw "[Error] Aggregate only support for int and float type.";
+
+	bool first = st.count++ == 0;
+	st.type = val.type;
+	if(val.type == TERM_FLOAT)
+	{
+		switch(op)
+		{
+			case OPERATOR_SUM:
+			case OPERATOR_AVG:
+				st.val_f += val.val_f;
+				break;
+			case OPERATOR_MIN:
+				if(first || val.val_f < st.val_f)
+					st.val_f = val.val_f;
+				break;
+			case OPERATOR_MAX:
+				if(first || val.val_f > st.val_f)
+					st.val_f = val.val_f;
+				break;
+			default: break;
+		}
+	} else {
+		switch(op)
+		{
+			case OPERATOR_SUM:
+			case OPERATOR_AVG:
+				st.val_i += val.val_i;
+				break;
+			case OPERATOR_MIN:
+				if(first || val.val_i < st.val_i)
+					st.val_i = val.val_i;
+				break;
+			case OPERATOR_MAX:
+				if(first || val.val_i > st.val_i)
+					st.val_i = val.val_i;
+				break;
+			default: break;
+		}
+	}
+}
+
+static void merge_state(operator_type_t op, aggregate_state_t &st, const aggregate_state_t &other)
+{
+	if(other.count == 0)
+		return;
+	if(st.count == 0)
+	{
+		st = other;
+		return;
+	}
+
+	st.count += other.count;
+	switch(op)
+	{
+		case OPERATOR_SUM:
+		case OPERATOR_AVG:
+			st.val_i += other.val_i;
+			st.val_f += other.val_f;
+			break;
+		case OPERATOR_MIN:
+			st.val_i = std::min(st.val_i, other.val_i);
+			st.val_f = std::min(st.val_f, other.val_f);
+			break;
+		case OPERATOR_MAX:
+			st.val_i = std::max(st.val_i, other.val_i);
+			st.val_f = std::max(st.val_f, other.val_f);
+			break;
+		default: break;
+	}
+}
+
+aggregate_hash_table::aggregate_hash_table()
+	: key_size(0), state_offset(0), entry_size(0), level(0), memory_budget(AGGREGATE_MEMORY_BUDGET),
+	  group_num(0), spill(nullptr)
+{
+}
+
+aggregate_hash_table::~aggregate_hash_table()
+{
+	delete spill;
+}
+
+void aggregate_hash_table::init(int key_size, const std::vector<operator_type_t> &ops,
+	size_t memory_budget, int level)
+{
+	this->key_size = key_size;
+	this->ops = ops;
+	this->memory_budget = memory_budget;
+	this->level = level;
+	state_offset = (key_size + sizeof(int64_t) - 1) / sizeof(int64_t) * sizeof(int64_t);
+	entry_size = state_offset + ops.size() * sizeof(aggregate_state_t);
+}
+
+uint64_t aggregate_hash_table::hash_key(const char *key) const
+{
+	// partitions of a level are split again by the next one
+	return hash_mix(hash_bytes(key, key_size) + level);
+}
+
+size_t aggregate_hash_table::memory_usage(size_t slot_num) const
+{
+	return entries.size() + slot_num * sizeof(slot_t);
+}
+
+void aggregate_hash_table::grow()
+{
+	std::vector<slot_t> old;
+	old.swap(slots);
+	slots.assign(old.empty() ? 16 : old.size() * 2, slot_t{ 0, 0 });
+	size_t mask = slots.size() - 1;
+	for(const slot_t &s : old)
+	{
+		if(!s.entry) continue;
+		size_t pos = s.hash & mask;
+		while(slots[pos].entry)
+			pos = (pos + 1) & mask;
+		slots[pos] = s;
+	}
+}
+
+aggregate_state_t *aggregate_hash_table::find_or_insert(const char *key, uint64_t h)
+{
+	if(!slots.empty())
+	{
+		size_t mask = slots.size() - 1;
+		for(size_t pos = h & mask; slots[pos].entry; pos = (pos + 1) & mask)
+		{
+			size_t entry = slots[pos].entry - 1;
+			if(slots[pos].hash == h && std::memcmp(entries.data() + entry * entry_size, key, key_size) == 0)
+				return states_of(entry);
+		}
+	}
+
+	// keep the load factor under 1/2
+	bool full = (group_num + 1) * 2 > slots.size();
+	size_t slot_num = full ? std::max<size_t>(16, slots.size() * 2) : slots.size();
+	if(group_num != 0 && memory_usage(slot_num) + entry_size > memory_budget)
+		return nullptr;
+	if(full) grow();
+
+	size_t mask = slots.size() - 1;
+	size_t pos = h & mask;
+	while(slots[pos].entry)
+		pos = (pos + 1) & mask;
+	slots[pos].hash = h;
+	slots[pos].entry = ++group_num;
+
+	entries.insert(entries.end(), key, key + key_size);
+	entries.resize(group_num * entry_size);
+	aggregate_state_t *states = states_of(group_num - 1);
+	for(size_t i = 0; i != ops.size(); ++i)
+		init_aggregate_state(states[i]);
+	return states;
+}
+
+void aggregate_hash_table::spill_entry(const char *key, uint64_t h, const aggregate_state_t *states)
+{
+	if(!spill)
+	{
+		spill = new spill_file("__aggregate");
+		std::printf("[Info] Aggregation exceeds %zu bytes of memory, spill new groups to %s.\n",
+				memory_budget, spill->get_filename());
+	}
+
+	// entries are spilled in the same layout as in memory
+	static const char padding[sizeof(int64_t)] = { 0 };
+	spill_file::stream_t &s = parts[partition_of(h)];
+	spill->append(s, key, key_size);
+	spill->append(s, padding, state_offset - key_size);
+	spill->append(s, states, ops.size() * sizeof(aggregate_state_t));
+}
+
+void aggregate_hash_table::update(const char *key, const expression *vals)
+{
+	uint64_t h = hash_key(key);
+	aggregate_state_t *states = find_or_insert(key, h);
+	if(states)
+	{
+		for(size_t i = 0; i != ops.size(); ++i)
+			update_aggregate_state(ops[i], states[i], vals[i]);
+		return;
+	}
+
+	std::vector<aggregate_state_t> row_states(ops.size());
+	for(size_t i = 0; i != ops.size(); ++i)
+	{
+		init_aggregate_state(row_states[i]);
+		update_aggregate_state(ops[i], row_states[i], vals[i]);
+	}
+
+	spill_entry(key, h, row_states.data());
+}
+
+void aggregate_hash_table::merge(const char *key, const aggregate_state_t *states)
+{
+	uint64_t h = hash_key(key);
+	aggregate_state_t *dst = find_or_insert(key, h);
+	if(!dst)
+	{
+		spill_entry(key, h, states);
+		return;
+	}
+
+	for(size_t i = 0; i != ops.size(); ++i)
+		merge_state(ops[i], dst[i], states[i]);
+}
+
+void aggregate_hash_table::load_partition(int p, aggregate_hash_table &table)
+{
+	const spill_file::stream_t &s = parts[p];
+	std::vector<char> buf(entry_size);
+	for(size_t pos = 0; pos < s.length; pos += entry_size)
+	{
+		spill->read(s, pos, buf.data(), entry_size);
+		table.merge(buf.data(), (const aggregate_state_t*)(buf.data() + state_offset));
+	}
+}
@@ -0,0 +1,112 @@
+#ifndef __TRIVIALDB_HASH_AGGREGATE__
+#define __TRIVIALDB_HASH_AGGREGATE__
+
+#include <stdint.h>
+#include <vector>
+#include "../defs.h"
+#include "../fs/spill_file.h"
+#include "../expression/expression.h"
+
+struct aggregate_state_t
+{
+	int64_t val_i;
+	double val_f;
+	// values folded in, NULLs are not counted except for COUNT(*)
+	int64_t count;
+	// the type of values, TERM_NONE before the first one
+	term_type_t type;
+};
+
+void init_aggregate_state(aggregate_state_t &st);
+// fold a value into the state of op, NULL is skipped
+void update_aggregate_state(operator_type_t op, aggregate_state_t &st, const expression &val);
+
+/* Aggregate states of groups keyed by fixed-width group keys.
+ *
+ * The entries of [key, padding, states] are stored one after another,
+ * and the slots of an open addressing table with linear probing hold
+ * the hash and the index of an entry. Once the entries reach the memory budget,
+ * the groups already in memory are still updated, but the rows of new
+ * groups are written as single-row entries into AGGREGATE_PARTITIONS
+ * partitions of a temporary page file. Each partition is aggregated
+ * by another table of the next level after the groups in memory are
+ * output. */
+class aggregate_hash_table
+{
+	struct slot_t
+	{
+		uint64_t hash;
+		// index of the entry + 1, 0 if the slot is empty
+		uint32_t entry;
+	};
+
+	// the states of an entry are aligned at state_offset
+	int key_size, state_offset, entry_size, level;
+	size_t memory_budget;
+	std::vector<operator_type_t> ops;
+	std::vector<char> entries;
+	std::vector<slot_t> slots;
+	size_t group_num;
+
+	spill_file *spill;
+	spill_file::stream_t parts[AGGREGATE_PARTITIONS];
+
+private:
+	uint64_t hash_key(const char *key) const;
+	static int partition_of(uint64_t h) { return (h >> 32) % AGGREGATE_PARTITIONS; }
+	aggregate_state_t *states_of(size_t entry)
+	{
+		return (aggregate_state_t*)(entries.data() + entry * entry_size + state_offset);
+	}
+
+	size_t memory_usage(size_t slot_num) const;
+	void grow();
+	// the states of the group, nullptr if it is new and memory is full
+	aggregate_state_t *find_or_insert(const char *key, uint64_t h);
+	void spill_entry(const char *key, uint64_t h, const aggregate_state_t *states);
+	void merge(const char *key, const aggregate_state_t *states);
+	void load_partition(int p, aggregate_hash_table &table);
+
+public:
+	aggregate_hash_table();
+	~aggregate_hash_table();
+	aggregate_hash_table(const aggregate_hash_table&) = delete;
+	aggregate_hash_table& operator = (const aggregate_hash_table&) = delete;
+
+	// ops are the aggregate operators, key_size may be 0 for one group
+	void init(int key_size, const std::vector<operator_type_t> &ops,
+		size_t memory_budget = AGGREGATE_MEMORY_BUDGET, int level = 0);
+	// fold the values of a row into the states of its group,
+	// vals[i] is the argument of ops[i]
+	void update(const char *key, const expression *vals);
+
+	// callback(key, states) for each group, false if stopped
+	template<typename Callback>
+	bool output(Callback callback)
+	{
+		for(size_t i = 0; i != group_num; ++i)
+		{
+			if(!callback((const char*)entries.data() + i * entry_size, (const aggregate_state_t*)states_of(i)))
+				return false;
+		}
+
+		entries.clear();
+		slots.clear();
+		group_num = 0;
+		if(!spill) return true;
+
+		for(int p = 0; p != AGGREGATE_PARTITIONS; ++p)
+		{
+			if(!parts[p].length) continue;
+			aggregate_hash_table table;
+			table.init(key_size, ops, memory_budget, level + 1);
+			load_partition(p, table);
+			if(!table.output(callback))
+				return false;
+		}
+
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "hash_join.h"
+#include <cstdio>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+join_hash_table::join_hash_table()
+	: row_size(0), tuple_size(0), memory_budget(HASH_JOIN_MEMORY_BUDGET),
+	  spill(nullptr), replaying(false)
+{
+}
+
+join_hash_table::~join_hash_table()
+{
+	delete spill;
+}
+
+void join_hash_table::init(int row_size, size_t memory_budget)
+{
+	this->row_size = row_size;
+	this->memory_budget = memory_budget;
+}
+
+double join_hash_table::estimate_memory(double row_num, int row_size)
+{
+	// a node of the multimap is about the size of two pointers and the entry
+	return row_num * (row_size + sizeof(int)
+		+ sizeof(std::pair<uint64_t, int>) + 2 * sizeof(void*));
+}
+
+size_t join_hash_table::memory_usage() const
+{
+	return (size_t)estimate_memory(rids.size(), row_size);
+}
+
+void join_hash_table::insert_in_memory(uint64_t h, int rid, const char *row)
+{
+	slots.emplace(h, (int)rids.size());
+	rids.push_back(rid);
+	rows.insert(rows.end(), row, row + row_size);
+}
+
+void join_hash_table::clear_in_memory()
+{
+	slots.clear();
+	rids.clear();
+	rows.clear();
+}
+
+void join_hash_table::insert(uint64_t h, int rid, const char *row)
+{
+	if(!spill)
+	{
+		insert_in_memory(h, rid, row);
+		if(memory_usage() > memory_budget)
+			spill_rows();
+		return;
+	}
+
+	spill_file::stream_t &s = build_part[partition_of(h, 0)];
+	spill->append(s, &h, sizeof(h));
+	spill->append(s, &rid, sizeof(rid));
+	spill->append(s, row, row_size);
+}
+
+void join_hash_table::spill_rows()
+{
+	spill = new spill_file("__hash_join");
+	std::printf("[Info] Hash join exceeds %zu bytes of memory, partition to %s.\n",
+			memory_budget, spill->get_filename());
+
+	for(auto &slot : slots)
+	{
+		spill_file::stream_t &s = build_part[partition_of(slot.first, 0)];
+		spill->append(s, &slot.first, sizeof(slot.first));
+		spill->append(s, &rids[slot.second], sizeof(int));
+		spill->append(s, rows.data() + (size_t)slot.second * row_size, row_size);
+	}
+
+	clear_in_memory();
+	rids.shrink_to_fit();
+	rows.shrink_to_fit();
+}
+
+void join_hash_table::defer_probe(uint64_t h, const char *tuple, int size)
+{
+	assert(deferring());
+	tuple_size = size;
+	spill_file::stream_t &s = probe_part[partition_of(h, 0)];
+	spill->append(s, &h, sizeof(h));
+	spill->append(s, tuple, size);
+}
+
+bool join_hash_table::exceeds_budget(const spill_file::stream_t &build) const
+{
+	return estimate_memory(build.length / build_entry_size(), row_size) > memory_budget;
+}
+
+bool join_hash_table::split_partition(
+	const spill_file::stream_t &build, const spill_file::stream_t &probe,
+	int level, spill_file::stream_t *sub_build, spill_file::stream_t *sub_probe)
+{
+	int entry_size = build_entry_size();
+	std::vector<char> buf(std::max(entry_size, probe_entry_size()));
+	for(size_t pos = 0; pos < build.length; pos += entry_size)
+	{
+		spill->read(build, pos, buf.data(), entry_size);
+		uint64_t h;
+		std::memcpy(&h, buf.data(), sizeof(h));
+		spill->append(sub_build[partition_of(h, level)], buf.data(), entry_size);
+	}
+
+	for(int p = 0; p != HASH_JOIN_PARTITIONS; ++p)
+	{
+		if(sub_build[p].length == build.length)
+			return false;
+	}
+
+	entry_size = probe_entry_size();
+	for(size_t pos = 0; pos < probe.length; pos += entry_size)
+	{
+		spill->read(probe, pos, buf.data(), entry_size);
+		uint64_t h;
+		std::memcpy(&h, buf.data(), sizeof(h));
+		spill->append(sub_probe[partition_of(h, level)], buf.data(), entry_size);
+	}
+
+	return true;
+}
+
+size_t join_hash_table::load_rows(const spill_file::stream_t &build, size_t pos)
+{
+	clear_in_memory();
+	int entry_size = build_entry_size();
+	std::vector<char> buf(entry_size);
+	for(; pos < build.length && memory_usage() <= memory_budget; pos += entry_size)
+	{
+		spill->read(build, pos, buf.data(), entry_size);
+		uint64_t h;
+		int rid;
+		std::memcpy(&h, buf.data(), sizeof(h));
+		std::memcpy(&rid, buf.data() + sizeof(h), sizeof(rid));
+		insert_in_memory(h, rid, buf.data() + sizeof(h) + sizeof(rid));
+	}
+
+	return pos;
+}
@@ -0,0 +1,145 @@
+#ifndef __TRIVIALDB_HASH_JOIN__
+#define __TRIVIALDB_HASH_JOIN__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../defs.h"
+#include "../fs/spill_file.h"
+#include "../utils/hasher.h"
+
+/* Rows of the inner table of a hash join keyed by the join column.
+ *
+ * Once the rows exceed the memory budget, all of them are moved into
+ * HASH_JOIN_PARTITIONS partitions of a temporary page file (grace hash
+ * join). The probes are then deferred into the partitions of the same
+ * hash, and replay() joins them partition by partition, so that only
+ * one partition of rows is kept in memory. A partition over the budget
+ * is split again by the hash salted with the next level, and one that
+ * cannot be split, as its rows are of the same hash, is loaded a budget
+ * of rows at a time and all of its probes are joined with each part. */
+class join_hash_table
+{
+	int row_size, tuple_size;
+	size_t memory_budget;
+	std::unordered_multimap<uint64_t, int> slots;
+	std::vector<int> rids;
+	std::vector<char> rows;
+
+	spill_file *spill;
+	bool replaying;
+	spill_file::stream_t build_part[HASH_JOIN_PARTITIONS];
+	spill_file::stream_t probe_part[HASH_JOIN_PARTITIONS];
+
+private:
+	// partitions of a level are split again by the next one
+	static int partition_of(uint64_t h, int level)
+	{
+		return (hash_mix(h + level) >> 32) % HASH_JOIN_PARTITIONS;
+	}
+
+	// the entries of build partitions are [hash, rid, row], and those of
+	// probe partitions [hash, tuple]
+	int build_entry_size() const { return sizeof(uint64_t) + sizeof(int) + row_size; }
+	int probe_entry_size() const { return sizeof(uint64_t) + tuple_size; }
+	void insert_in_memory(uint64_t h, int rid, const char *row);
+	void clear_in_memory();
+	void spill_rows();
+	bool exceeds_budget(const spill_file::stream_t &build) const;
+	// false if all rows fall into one partition of the level
+	bool split_partition(const spill_file::stream_t &build, const spill_file::stream_t &probe,
+		int level, spill_file::stream_t *sub_build, spill_file::stream_t *sub_probe);
+	// load the rows from pos until the budget is reached, return where it stops
+	size_t load_rows(const spill_file::stream_t &build, size_t pos);
+	size_t memory_usage() const;
+
+	template<typename Callback>
+	bool replay_partition(const spill_file::stream_t &build,
+		const spill_file::stream_t &probe, int level, Callback &callback)
+	{
+		if(!build.length || !probe.length)
+			return true;
+
+		if(exceeds_budget(build))
+		{
+			spill_file::stream_t sub_build[HASH_JOIN_PARTITIONS];
+			spill_file::stream_t sub_probe[HASH_JOIN_PARTITIONS];
+			if(split_partition(build, probe, level, sub_build, sub_probe))
+			{
+				for(int p = 0; p != HASH_JOIN_PARTITIONS; ++p)
+				{
+					if(!replay_partition(sub_build[p], sub_probe[p], level + 1, callback))
+						return false;
+				}
+
+				return true;
+			}
+		}
+
+		int entry_size = probe_entry_size();
+		std::vector<char> buf(entry_size);
+		for(size_t row_pos = 0; row_pos < build.length; )
+		{
+			row_pos = load_rows(build, row_pos);
+			for(size_t pos = 0; pos < probe.length; pos += entry_size)
+			{
+				spill->read(probe, pos, buf.data(), entry_size);
+				if(!callback((const char*)buf.data() + sizeof(uint64_t)))
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+public:
+	join_hash_table();
+	~join_hash_table();
+	join_hash_table(const join_hash_table&) = delete;
+	join_hash_table& operator = (const join_hash_table&) = delete;
+
+	void init(int row_size, size_t memory_budget = HASH_JOIN_MEMORY_BUDGET);
+	void insert(uint64_t h, int rid, const char *row);
+
+	// the rows are partitioned, probes must be saved by defer_probe()
+	bool deferring() const { return spill && !replaying; }
+	// tuple is the bound rows of the outer tables, all of the same size
+	void defer_probe(uint64_t h, const char *tuple, int size);
+
+	// estimated memory of rows in the table
+	static double estimate_memory(double row_num, int row_size);
+
+	// callback(rid, row) for the rows of hash h, false if stopped
+	template<typename Callback>
+	bool probe(uint64_t h, Callback callback)
+	{
+		auto range = slots.equal_range(h);
+		for(auto it = range.first; it != range.second; ++it)
+		{
+			if(!callback(rids[it->second], rows.data() + (size_t)it->second * row_size))
+				return false;
+		}
+
+		return true;
+	}
+
+	// load the partitions one by one and callback(tuple) for the
+	// probes deferred to it, false if stopped
+	template<typename Callback>
+	bool replay(Callback callback)
+	{
+		if(!spill) return true;
+
+		bool ok = true;
+		replaying = true;
+		for(int p = 0; ok && p != HASH_JOIN_PARTITIONS; ++p)
+			ok = replay_partition(build_part[p], probe_part[p], 1, callback);
+
+		replaying = false;
+		clear_in_memory();
+		return ok;
+	}
+};
+
+#endif
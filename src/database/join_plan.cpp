@@ -0,0 +1,398 @@
+#include "join_plan.h"
+#include "dbms.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+struct join_edge_t
+{
+	int table[2], cid[2];
+	expr_node_t *expr;
+	double selectivity;
+};
+
+struct join_option_t
+{
+	join_step_t::method_t method;
+	int edge, table;
+	double rows, cost;
+	bool spill;
+};
+
+struct join_context_t
+{
+	const std::vector<table_manager*> &tables;
+	std::vector<join_edge_t> edges;
+	std::vector<access_path_t> paths;
+	std::vector<double> row_num;
+
+	join_context_t(const std::vector<table_manager*> &tables) : tables(tables) {}
+
+	bool connected(uint32_t mask, int j) const
+	{
+		for(const join_edge_t &e : edges)
+		{
+			if((e.table[0] == j && ((mask >> e.table[1]) & 1))
+				|| (e.table[1] == j && ((mask >> e.table[0]) & 1)))
+				return true;
+		}
+
+		return false;
+	}
+
+	// cost of building a hash table on table j and probing it,
+	// the smaller side is expected to be the build side
+	double hash_join_cost(uint32_t mask, double outer_rows, double rows, int j, bool &spill) const
+	{
+		double cost = paths[j].cost + paths[j].rows * COST_HASH_BUILD
+			+ outer_rows * COST_HASH_PROBE + rows * COST_TUPLE;
+		int row_size = tables[j]->get_record_size();
+		spill = join_hash_table::estimate_memory(paths[j].rows, row_size) > HASH_JOIN_MEMORY_BUDGET;
+		if(spill)
+		{
+			// both sides are written to and read from the partitions
+			int tuple_size = 0;
+			for(int i = 0; i != (int)tables.size(); ++i)
+				if((mask >> i) & 1) tuple_size += tables[i]->get_record_size() + sizeof(int);
+			double bytes = paths[j].rows * (row_size + sizeof(int) + sizeof(uint64_t))
+				+ outer_rows * tuple_size;
+			cost += 2 * bytes / PAGE_SIZE * COST_SEQ_PAGE;
+		}
+
+		return cost;
+	}
+
+	// cost of reading both tables in the order of the indices of an edge,
+	// only the rows whose key appears on the other side are read
+	double merge_join_cost(int i, int j, const join_edge_t &e, double rows) const
+	{
+		int si = e.table[0] == i ? 0 : 1;
+		double ndv_i = tables[i]->estimate_ndv(e.cid[si]);
+		double ndv_j = tables[j]->estimate_ndv(e.cid[si ^ 1]);
+		double fetch_i = row_num[i] * std::min(1.0, ndv_j / ndv_i);
+		double fetch_j = row_num[j] * std::min(1.0, ndv_i / ndv_j);
+		return 2 * COST_INDEX_DESCENT
+			+ (row_num[i] + row_num[j]) * COST_INDEX_ENTRY
+			+ pages_touched(tables[i]->estimate_page_num(), fetch_i) * COST_RANDOM_PAGE
+			+ pages_touched(tables[j]->estimate_page_num(), fetch_j) * COST_RANDOM_PAGE
+			+ (fetch_i + fetch_j + rows) * COST_TUPLE;
+	}
+
+	// the cheapest way to join table j to the tables in mask
+	join_option_t best_option(uint32_t mask, double outer_rows, int j) const
+	{
+		double rows = outer_rows * paths[j].rows;
+		for(const join_edge_t &e : edges)
+		{
+			if((e.table[0] == j && ((mask >> e.table[1]) & 1))
+				|| (e.table[1] == j && ((mask >> e.table[0]) & 1)))
+				rows *= e.selectivity;
+		}
+
+		join_option_t opt;
+		opt.method = join_step_t::NESTED_SCAN;
+		opt.edge   = -1;
+		opt.table  = j;
+		opt.rows   = rows;
+		opt.cost   = outer_rows * paths[j].cost;
+		opt.spill  = false;
+
+		for(int i = 0; i != (int)edges.size(); ++i)
+		{
+			const join_edge_t &e = edges[i];
+			int side = e.table[0] == j ? 0 : 1;
+			if(e.table[side] != j || !((mask >> e.table[side ^ 1]) & 1))
+				continue;
+
+			if(tables[j]->get_index(e.cid[side]))
+			{
+				double per_probe = COST_INDEX_DESCENT + row_num[j] * e.selectivity
+					* (COST_INDEX_ENTRY + COST_RANDOM_PAGE + COST_TUPLE);
+				if(outer_rows * per_probe < opt.cost)
+				{
+					opt.method = join_step_t::INDEX_LOOKUP;
+					opt.edge   = i;
+					opt.cost   = outer_rows * per_probe;
+				}
+			}
+
+			int outer = e.table[side ^ 1];
+			if(mask == (1u << outer) && tables[j]->get_index(e.cid[side])
+				&& tables[outer]->get_index(e.cid[side ^ 1]))
+			{
+				// the merge reads the outer table itself instead of its access path
+				double merge_cost = merge_join_cost(outer, j, e, rows) - paths[outer].cost;
+				if(merge_cost < opt.cost)
+				{
+					opt.method = join_step_t::MERGE_JOIN;
+					opt.edge   = i;
+					opt.cost   = merge_cost;
+				}
+			}
+
+			bool spill;
+			double hash_cost = hash_join_cost(mask, outer_rows, rows, j, spill);
+			if(hash_cost < opt.cost)
+			{
+				opt.method = join_step_t::HASH_PROBE;
+				opt.edge   = i;
+				opt.cost   = hash_cost;
+				opt.spill  = spill;
+			}
+		}
+
+		return opt;
+	}
+};
+
+}
+
+static uint32_t tables_of(const expr_node_t *expr, const std::vector<table_manager*> &tables)
+{
+	if(!expr) return 0;
+	if(expr->op == OPERATOR_NONE)
+	{
+		if(expr->term_type != TERM_COLUMN_REF)
+			return 0;
+
+		// an unqualified column belongs to every table having it
+		uint32_t mask = 0;
+		const column_ref_t *col = expr->column_ref;
+		for(size_t i = 0; i != tables.size(); ++i)
+		{
+			if(col->table && std::strcmp(col->table, tables[i]->get_table_name()) != 0)
+				continue;
+			if(tables[i]->lookup_column(col->column) >= 0)
+				mask |= 1u << i;
+		}
+
+		return mask;
+	}
+
+	uint32_t mask = tables_of(expr->left, tables);
+	if(!(expr->op & OPERATOR_UNARY))
+		mask |= tables_of(expr->right, tables);
+	return mask;
+}
+
+join_plan_t plan_join(const std::vector<table_manager*> &tables, expr_node_t *cond)
+{
+	int n = tables.size();
+	assert(n <= 32);
+	uint32_t full = n == 32 ? ~0u : (1u << n) - 1;
+
+	std::vector<expr_node_t*> and_cond;
+	dbms::extract_and_cond(cond, and_cond);
+	std::vector<uint32_t> cond_mask;
+	for(expr_node_t *c : and_cond)
+		cond_mask.push_back(tables_of(c, tables));
+
+	join_context_t ctx(tables);
+	std::vector<std::vector<expr_node_t*>> local_cond(n);
+	for(size_t i = 0; i != and_cond.size(); ++i)
+	{
+		uint32_t m = cond_mask[i];
+		if(m && !(m & (m - 1)))
+			local_cond[__builtin_ctz(m)].push_back(and_cond[i]);
+
+		expr_node_t *c = and_cond[i];
+		if(c->op != OPERATOR_EQ || c->left->term_type != TERM_COLUMN_REF
+			|| c->right->term_type != TERM_COLUMN_REF)
+			continue;
+
+		uint32_t lm = tables_of(c->left, tables), rm = tables_of(c->right, tables);
+		if(!lm || !rm || (lm & (lm - 1)) || (rm & (rm - 1)) || lm == rm)
+			continue;
+
+		join_edge_t e;
+		e.expr = c;
+		e.table[0] = __builtin_ctz(lm);
+		e.table[1] = __builtin_ctz(rm);
+		e.cid[0] = tables[e.table[0]]->lookup_column(c->left->column_ref->column);
+		e.cid[1] = tables[e.table[1]]->lookup_column(c->right->column_ref->column);
+		// keys are compared and hashed as raw bytes
+		if(tables[e.table[0]]->get_column_type(e.cid[0]) != tables[e.table[1]]->get_column_type(e.cid[1]))
+			continue;
+
+		e.selectivity = 1 / std::max(
+			tables[e.table[0]]->estimate_ndv(e.cid[0]),
+			tables[e.table[1]]->estimate_ndv(e.cid[1])
+		);
+		ctx.edges.push_back(e);
+	}
+
+	for(int i = 0; i != n; ++i)
+	{
+		ctx.paths.push_back(choose_access_path(tables[i], local_cond[i]));
+		ctx.row_num.push_back(tables[i]->estimate_row_num());
+	}
+
+	// join order, with the cost and rows after each step
+	std::vector<join_option_t> order;
+	if(n <= JOIN_DP_MAX_TABLES)
+	{
+		struct state_t
+		{
+			bool valid;
+			double cost, rows;
+			uint32_t prev;
+			join_option_t opt;
+		};
+
+		std::vector<state_t> dp(full + 1);
+		for(auto &s : dp) s.valid = false;
+		dp[0].valid = true;
+		dp[0].cost  = 0;
+		dp[0].rows  = 1;
+		for(uint32_t mask = 0; mask != full; ++mask)
+		{
+			if(!dp[mask].valid) continue;
+			for(int j = 0; j != n; ++j)
+			{
+				if((mask >> j) & 1) continue;
+				join_option_t opt = ctx.best_option(mask, dp[mask].rows, j);
+				state_t &next = dp[mask | (1u << j)];
+				double cost = dp[mask].cost + opt.cost;
+				if(!next.valid || cost < next.cost)
+				{
+					next.valid = true;
+					next.cost  = cost;
+					next.rows  = opt.rows;
+					next.prev  = mask;
+					next.opt   = opt;
+				}
+			}
+		}
+
+		for(uint32_t mask = full; mask; mask = dp[mask].prev)
+		{
+			join_option_t opt = dp[mask].opt;
+			opt.cost = dp[mask].cost;
+			order.push_back(opt);
+		}
+
+		std::reverse(order.begin(), order.end());
+	} else {
+		// add the cheapest table in each step, avoiding cross products
+		uint32_t mask = 0;
+		double rows = 1, cost = 0;
+		while(mask != full)
+		{
+			bool has_connected = false;
+			for(int j = 0; j != n; ++j)
+				if(!((mask >> j) & 1) && ctx.connected(mask, j))
+					has_connected = true;
+
+			join_option_t best;
+			best.table = -1;
+			for(int j = 0; j != n; ++j)
+			{
+				if(((mask >> j) & 1) || (has_connected && !ctx.connected(mask, j)))
+					continue;
+				join_option_t opt = ctx.best_option(mask, rows, j);
+				if(best.table == -1 || opt.cost < best.cost
+					|| (opt.cost == best.cost && opt.rows < best.rows))
+					best = opt;
+			}
+
+			mask |= 1u << best.table;
+			rows = best.rows;
+			cost += best.cost;
+			best.cost = cost;
+			order.push_back(best);
+		}
+	}
+
+	join_plan_t plan;
+	plan.rows = order.back().rows;
+	plan.cost = order.back().cost;
+
+	uint32_t bound = 0;
+	std::vector<bool> assigned(and_cond.size(), false);
+	for(const join_option_t &opt : order)
+	{
+		join_step_t step;
+		step.method = opt.method;
+		step.table  = opt.table;
+		step.path   = ctx.paths[opt.table];
+		step.local_cond = local_cond[opt.table];
+		step.rows   = opt.rows;
+		step.cost   = opt.cost;
+		step.spill  = opt.spill;
+		step.edge   = nullptr;
+		step.inner_cid = step.outer_table = step.outer_cid = -1;
+		if(opt.edge >= 0)
+		{
+			const join_edge_t &e = ctx.edges[opt.edge];
+			int side = e.table[0] == opt.table ? 0 : 1;
+			step.edge        = e.expr;
+			step.inner_cid   = e.cid[side];
+			step.outer_table = e.table[side ^ 1];
+			step.outer_cid   = e.cid[side ^ 1];
+		}
+
+		// check every conjunct as soon as its tables are bound
+		bound |= 1u << opt.table;
+		for(size_t i = 0; i != and_cond.size(); ++i)
+		{
+			if(!assigned[i] && !(cond_mask[i] & ~bound))
+			{
+				assigned[i] = true;
+				step.cond.push_back(and_cond[i]);
+			}
+		}
+
+		plan.steps.push_back(step);
+	}
+
+	return plan;
+}
+
+std::vector<std::string> join_plan_t::to_string(const std::vector<table_manager*> &tables) const
+{
+	std::vector<std::string> ret;
+	for(size_t i = 0; i != steps.size(); ++i)
+	{
+		const join_step_t &step = steps[i];
+		std::string line = std::to_string(i + 1) + ". ";
+		std::string join_col;
+		if(step.edge)
+		{
+			table_manager *inner = tables[step.table], *outer = tables[step.outer_table];
+			join_col = std::string(inner->get_table_name()) + "." + inner->get_column_name(step.inner_cid)
+				+ " = " + outer->get_table_name() + "." + outer->get_column_name(step.outer_cid);
+		}
+
+		switch(step.method)
+		{
+			case join_step_t::NESTED_SCAN:
+				if(i == 0 && steps.size() > 1 && steps[1].method == join_step_t::MERGE_JOIN)
+				{
+					table_manager *tb = tables[step.table];
+					line += std::string("INDEX ORDER ") + tb->get_table_name()
+						+ "." + tb->get_column_name(steps[1].outer_cid);
+				} else {
+					line += (i == 0 ? "" : "NESTED LOOP ") + step.path.to_string(false);
+				}
+				break;
+			case join_step_t::INDEX_LOOKUP:
+				line += "INDEX LOOKUP " + join_col;
+				break;
+			case join_step_t::HASH_PROBE:
+				line += "HASH JOIN " + join_col + ", BUILD " + step.path.to_string(false);
+				if(step.spill) line += ", PARTITIONED";
+				break;
+			case join_step_t::MERGE_JOIN:
+				line += "MERGE JOIN " + join_col;
+				break;
+		}
+
+		char buf[64];
+		std::snprintf(buf, sizeof(buf), " (rows=%.1f, cost=%.1f)", step.rows, step.cost);
+		ret.push_back(line + buf);
+	}
+
+	return ret;
+}
@@ -0,0 +1,54 @@
+#ifndef __TRIVIALDB_JOIN_PLAN__
+#define __TRIVIALDB_JOIN_PLAN__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "access_path.h"
+#include "hash_join.h"
+
+/* Left-deep join plan. Tables are bound in the order of steps,
+ * each step reads the rows of one table for every combination of
+ * rows bound by the previous steps. */
+struct join_step_t
+{
+	enum method_t {
+		// run the access path of the table for every outer row
+		NESTED_SCAN,
+		// look up the index of inner_cid with the outer column
+		INDEX_LOOKUP,
+		// probe a hash table built from the access path before joining
+		HASH_PROBE,
+		// only for the second step: merge the indices of inner_cid and
+		// outer_cid, so that the first table is read in the index order
+		MERGE_JOIN
+	} method;
+
+	int table;
+	access_path_t path;
+	// conjuncts only on this table
+	std::vector<expr_node_t*> local_cond;
+	// join column: table.inner_cid = outer_table.outer_cid
+	int inner_cid, outer_table, outer_cid;
+	expr_node_t *edge;
+	// conjuncts to check once this table is bound
+	std::vector<expr_node_t*> cond;
+	// estimated rows after this step and cost up to this step
+	double rows, cost;
+	// the hash table is expected to exceed the memory budget
+	bool spill;
+};
+
+struct join_plan_t
+{
+	std::vector<join_step_t> steps;
+	double rows, cost;
+
+	std::vector<std::string> to_string(const std::vector<table_manager*> &tables) const;
+};
+
+// enumerate join orders by dynamic programming over subsets of tables,
+// or greedily if there are more than JOIN_DP_MAX_TABLES tables
+join_plan_t plan_join(const std::vector<table_manager*> &tables, expr_node_t *cond);
+
+#endif
@@ -0,0 +1,296 @@
+#include "scan_batch.h"
+#include "dbms.h"
+#include "../expression/expression.h"
+#include "../utils/type_cast.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <functional>
+
+static operator_type_t flip_compare(operator_type_t op)
+{
+	switch(op)
+	{
+		case OPERATOR_GT:  return OPERATOR_LT;
+		case OPERATOR_LT:  return OPERATOR_GT;
+		case OPERATOR_GEQ: return OPERATOR_LEQ;
+		case OPERATOR_LEQ: return OPERATOR_GEQ;
+		default: return op;
+	}
+}
+
+static bool is_constant(const expr_node_t *expr)
+{
+	if(!expr) return true;
+	if(expr->op == OPERATOR_NONE)
+		return expr->term_type != TERM_COLUMN_REF;
+	return is_constant(expr->left) && is_constant(expr->right);
+}
+
+template<typename T, typename Compare>
+static void mask_compare(uint8_t *mask, const T *vals, const unsigned *null_marks,
+	unsigned null_bit, T c, int n, Compare cmp)
+{
+	for(int i = 0; i < n; ++i)
+		mask[i] &= ((null_marks[i] & null_bit) == 0) & cmp(vals[i], c);
+}
+
+template<typename T>
+static void mask_compare(operator_type_t op, uint8_t *mask, const T *vals,
+	const unsigned *null_marks, unsigned null_bit, T c, int n)
+{
+	switch(op)
+	{
+		case OPERATOR_EQ:
+			mask_compare(mask, vals, null_marks, null_bit, c, n, std::equal_to<T>());
+			break;
+		case OPERATOR_NEQ:
+			mask_compare(mask, vals, null_marks, null_bit, c, n, std::not_equal_to<T>());
+			break;
+		case OPERATOR_LT:
+			mask_compare(mask, vals, null_marks, null_bit, c, n, std::less<T>());
+			break;
+		case OPERATOR_LEQ:
+			mask_compare(mask, vals, null_marks, null_bit, c, n, std::less_equal<T>());
+			break;
+		case OPERATOR_GT:
+			mask_compare(mask, vals, null_marks, null_bit, c, n, std::greater<T>());
+			break;
+		case OPERATOR_GEQ:
+			mask_compare(mask, vals, null_marks, null_bit, c, n, std::greater_equal<T>());
+			break;
+		default:
+			assert(false);
+	}
+}
+
+template<typename T>
+static void mask_in(uint8_t *mask, const T *vals, const unsigned *null_marks,
+	unsigned null_bit, const std::vector<T> &set, int n)
+{
+	for(int i = 0; i < n; ++i)
+	{
+		if(mask[i])
+			mask[i] = (null_marks[i] & null_bit) == 0
+				&& std::binary_search(set.begin(), set.end(), vals[i]);
+	}
+}
+
+scan_batch::scan_batch(table_manager *table, expr_node_t *cond)
+	: table(table), record_size(table->get_record_size()), row_num(0), sel_num(0)
+{
+	rows.resize((size_t)record_size * SCAN_BATCH_SIZE);
+	if(!cond) return;
+	if(!cond->program)
+	{
+		residual.push_back(cond);
+		return;
+	}
+
+	std::vector<expr_node_t*> and_cond;
+	dbms::extract_and_cond(cond, and_cond);
+	for(expr_node_t *expr : and_cond)
+	{
+		if(!add_pred(expr))
+			residual.push_back(expr);
+	}
+}
+
+bool scan_batch::add_pred(const expr_node_t *expr)
+{
+	const expr_node_t *col = expr->left, *val = expr->right;
+	operator_type_t op = expr->op;
+	pred_t p;
+	switch(op)
+	{
+		case OPERATOR_ISNULL:
+		case OPERATOR_NOTNULL:
+			val = nullptr;
+			break;
+		case OPERATOR_LIKE:
+		case OPERATOR_IN:
+			break;
+		case OPERATOR_EQ:
+		case OPERATOR_NEQ:
+		case OPERATOR_LT:
+		case OPERATOR_LEQ:
+		case OPERATOR_GT:
+		case OPERATOR_GEQ:
+			if(val->term_type == TERM_COLUMN_REF)
+			{
+				std::swap(col, val);
+				op = flip_compare(op);
+			}
+			break;
+		default:
+			return false;
+	}
+
+	if(col->op != OPERATOR_NONE || col->term_type != TERM_COLUMN_REF)
+		return false;
+	const column_ref_t *ref = col->column_ref;
+	if(ref->record != table->get_cached_record_ref())
+		return false;
+
+	p.op = op;
+	p.offset = ref->offset;
+	p.null_bit = 1u << ref->cid;
+	p.type = typecast::column_to_term(ref->type);
+	if(op == OPERATOR_IN)
+		return add_in_pred(p, val);
+	if(val)
+	{
+		if(op == OPERATOR_LIKE ? p.type != TERM_STRING
+			: p.type != TERM_INT && p.type != TERM_DATE && p.type != TERM_FLOAT)
+			return false;
+		if(!is_constant(val))
+			return false;
+
+		expression c;
+		try {
+			c = expression::eval(val);
+		} catch(const char *) {
+			return false;
+		}
+
+		if(c.type != p.type)
+			return false;
+		if(p.type == TERM_STRING)
+		{
+			p.val_i = matchers.size();
+			matchers.emplace_back(c.val_s);
+		} else if(p.type == TERM_FLOAT) {
+			p.val_f = c.val_f;
+		} else {
+			p.val_i = c.val_i;
+		}
+	}
+
+	preds.push_back(p);
+	return true;
+}
+
+bool scan_batch::add_in_pred(pred_t &p, const expr_node_t *list)
+{
+	if(p.type != TERM_INT && p.type != TERM_DATE && p.type != TERM_FLOAT)
+		return false;
+	if(list->op != OPERATOR_NONE || list->term_type != TERM_LITERAL_LIST)
+		return false;
+
+	std::vector<int> ints;
+	std::vector<float> floats;
+	for(linked_list_t *l_ptr = list->literal_list; l_ptr; l_ptr = l_ptr->next)
+	{
+		expression c;
+		try {
+			c = expression::eval((const expr_node_t*)l_ptr->data);
+		} catch(const char *) {
+			return false;
+		}
+
+		if(c.type != p.type)
+			return false;
+		if(p.type == TERM_FLOAT)
+			floats.push_back(c.val_f);
+		else ints.push_back(c.val_i);
+	}
+
+	if(p.type == TERM_FLOAT)
+	{
+		std::sort(floats.begin(), floats.end());
+		p.val_i = float_sets.size();
+		float_sets.push_back(std::move(floats));
+	} else {
+		std::sort(ints.begin(), ints.end());
+		p.val_i = int_sets.size();
+		int_sets.push_back(std::move(ints));
+	}
+
+	preds.push_back(p);
+	return true;
+}
+
+void scan_batch::add(record_manager *rm, std::pair<int, int> p)
+{
+	pos[row_num] = p;
+	table->read_record(rm, rows.data() + row_num * record_size);
+	++row_num;
+}
+
+void scan_batch::apply(const pred_t &p)
+{
+	const char *rec = rows.data() + p.offset;
+	if(p.op == OPERATOR_ISNULL || p.op == OPERATOR_NOTNULL)
+	{
+		unsigned expected = p.op == OPERATOR_ISNULL ? p.null_bit : 0;
+		for(int i = 0; i < row_num; ++i)
+			mask[i] &= (null_marks[i] & p.null_bit) == expected;
+		return;
+	}
+
+	if(p.op == OPERATOR_LIKE)
+	{
+		const like_matcher &m = matchers[p.val_i];
+		for(int i = 0; i < row_num; ++i)
+		{
+			if(mask[i])
+				mask[i] = (null_marks[i] & p.null_bit) == 0 && m.match(rec + i * record_size);
+		}
+
+		return;
+	}
+
+	// ints, dates and floats are all 4 bytes
+	for(int i = 0; i < row_num; ++i)
+		std::memcpy(&column.ints[i], rec + i * record_size, 4);
+	if(p.op == OPERATOR_IN)
+	{
+		if(p.type == TERM_FLOAT)
+			mask_in(mask, column.floats, null_marks, p.null_bit, float_sets[p.val_i], row_num);
+		else mask_in(mask, column.ints, null_marks, p.null_bit, int_sets[p.val_i], row_num);
+		return;
+	}
+
+	if(p.type == TERM_FLOAT)
+		mask_compare(p.op, mask, column.floats, null_marks, p.null_bit, p.val_f, row_num);
+	else mask_compare(p.op, mask, column.ints, null_marks, p.null_bit, p.val_i, row_num);
+}
+
+int scan_batch::filter()
+{
+	std::memset(mask, 1, row_num);
+	if(!preds.empty())
+	{
+		for(int i = 0; i < row_num; ++i)
+			std::memcpy(&null_marks[i], rows.data() + i * record_size + 4, 4);
+		for(const pred_t &p : preds)
+			apply(p);
+	}
+
+	sel_num = 0;
+	for(int i = 0; i < row_num; ++i)
+	{
+		sel[sel_num] = i;
+		sel_num += mask[i];
+	}
+
+	return sel_num;
+}
+
+int scan_batch::selected_rid(int i) const
+{
+	int rid;
+	std::memcpy(&rid, selected_record(i), 4);
+	return rid;
+}
+
+bool scan_batch::check_cached() const
+{
+	for(expr_node_t *expr : residual)
+	{
+		if(!typecast::expr_to_bool(expression::eval(expr)))
+			return false;
+	}
+
+	return true;
+}
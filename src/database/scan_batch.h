@@ -0,0 +1,86 @@
+#ifndef __TRIVIALDB_SCAN_BATCH__
+#define __TRIVIALDB_SCAN_BATCH__
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include "../defs.h"
+#include "../table/table.h"
+#include "../parser/defs.h"
+#include "../utils/like_matcher.h"
+
+/* Rows of a full scan filtered a batch at a time.
+ *
+ * Up to SCAN_BATCH_SIZE records are copied out of the data pages with
+ * their positions. Conditions comparing an int, date or float column
+ * of the table with a constant, and null checks of a column, are
+ * evaluated over the whole batch: the column is gathered into an array,
+ * and each condition clears the rows it rejects from a mask in a loop
+ * without branches. A VARCHAR column LIKE a constant pattern, and a
+ * column IN a list of constants, are matched for the rows still in the
+ * mask, the latter by binary search in the sorted list. The rows left
+ * form the selection vector, and the other conditions are evaluated
+ * only for the selected rows, one by one after the row is cached by
+ * the table.
+ *
+ * Conditions are reordered this way only if the whole condition is
+ * compiled, i.e. it never fails, so that no error of a rejected row
+ * is hidden. Otherwise every row is checked by the whole condition. */
+class scan_batch
+{
+	struct pred_t
+	{
+		operator_type_t op;
+		term_type_t type;
+		int offset;
+		unsigned null_bit;
+		union {
+			int val_i;
+			float val_f;
+		};
+	};
+
+	table_manager *table;
+	int record_size;
+	std::vector<pred_t> preds;
+	// the patterns of LIKE predicates and the sorted values of IN
+	// predicates, val_i of which is the index
+	std::vector<like_matcher> matchers;
+	std::vector<std::vector<int>> int_sets;
+	std::vector<std::vector<float>> float_sets;
+	std::vector<expr_node_t*> residual;
+
+	int row_num, sel_num;
+	std::vector<char> rows;
+	std::pair<int, int> pos[SCAN_BATCH_SIZE];
+	uint16_t sel[SCAN_BATCH_SIZE];
+	uint8_t mask[SCAN_BATCH_SIZE];
+	unsigned null_marks[SCAN_BATCH_SIZE];
+	union {
+		int ints[SCAN_BATCH_SIZE];
+		float floats[SCAN_BATCH_SIZE];
+	} column;
+
+	bool add_pred(const expr_node_t *expr);
+	bool add_in_pred(pred_t &p, const expr_node_t *list);
+	void apply(const pred_t &p);
+
+public:
+	// cond is bound to the table, and may be nullptr
+	scan_batch(table_manager *table, expr_node_t *cond);
+
+	void clear() { row_num = 0; }
+	bool full() const { return row_num == SCAN_BATCH_SIZE; }
+	// read the record at p into the batch
+	void add(record_manager *rm, std::pair<int, int> p);
+	// evaluate the predicates, return the number of rows selected
+	int filter();
+
+	const char *selected_record(int i) const { return rows.data() + sel[i] * record_size; }
+	std::pair<int, int> selected_pos(int i) const { return pos[sel[i]]; }
+	int selected_rid(int i) const;
+	// whether the cached record satisfies the other conditions, throws on errors
+	bool check_cached() const;
+};
+
+#endif
@@ -18,10 +18,64 @@
 #define PAGE_FREE_SPACE_MAX  (PAGE_SIZE / 4 * 3)
 
 /* page type (2 bytes) */
-#define PAGE_FIXED      0x4946
-#define PAGE_INDEX_LEAF 0x4947
-#define PAGE_VARIANT    0x4156
-#define PAGE_OVERFLOW   0x564f
+#define PAGE_FIXED       0x4946
+#define PAGE_INDEX_LEAF  0x4947
+#define PAGE_VARIANT     0x4156
+#define PAGE_OVERFLOW    0x564f
+#define PAGE_VARKEY      0x4b56
+#define PAGE_VARKEY_LEAF 0x4b57
+
+/* bloom filter of index */
+#define BLOOM_BITS_PER_KEY   10
+#define BLOOM_MIN_CAPACITY   1024
+
+/* statistics */
+#define STATS_HISTOGRAM_BUCKETS  16
+#define STATS_SAMPLE_PAGES       64
+#define STATS_DEFAULT_EQ_SEL     0.005
+#define STATS_DEFAULT_RANGE_SEL  (1.0 / 3)
+#define STATS_LIKE_CHAR_SEL      0.2
+
+/* cost model, in units of one sequential page read */
+#define COST_SEQ_PAGE       1.0
+#define COST_RANDOM_PAGE    4.0
+#define COST_INDEX_ENTRY    0.01
+#define COST_TUPLE          0.01
+#define COST_INDEX_DESCENT  (3 * COST_RANDOM_PAGE)
+
+/* join planning, more tables are ordered greedily */
+#define JOIN_DP_MAX_TABLES  10
+#define COST_HASH_BUILD     0.02
+#define COST_HASH_PROBE     0.01
+
+/* hash join, the build side is partitioned to a temporary file
+ * if its rows take more memory than the budget */
+#define HASH_JOIN_MEMORY_BUDGET  (16 << 20)
+#define HASH_JOIN_PARTITIONS     16
+
+/* ORDER BY, sorted runs are written to a temporary file
+ * if the rows take more memory than the budget */
+#define SORT_MEMORY_BUDGET  (16 << 20)
+#define SORT_KEY_PREFIX     16
+#define COST_SORT_COMPARE   0.002
+
+/* GROUP BY, the rows of new groups are spilled to a temporary file
+ * once the groups take more memory than the budget */
+#define AGGREGATE_MEMORY_BUDGET  (16 << 20)
+#define AGGREGATE_PARTITIONS     16
+
+/* full scans, rows are filtered in batches of this many */
+#define SCAN_BATCH_SIZE          1024
+
+/* rows, columns not referenced by a query are skipped, unless they
+ * lie between referenced ones closer than this many bytes */
+#define RECORD_SKIP_MIN_GAP      64
+
+/* result sets, rows are sent in chunks, and a statement is parked while
+ * its client is behind by more than the limit, as is the next statement
+ * of the connection */
+#define RESULT_FLUSH_SIZE        (64 << 10)
+#define RESULT_SEND_BUFFER_LIMIT (4 << 20)
 
 /* table info */
 #define MAX_COL_NUM     32
@@ -42,6 +96,13 @@
 // Note the actual data has one more zero byte
 #define COL_TYPE_VARCHAR   5
 
+/* table header with the fields after table_name */
+#define TABLE_HEADER_MAGIC 0x31485454
+
+/* how records are saved in data pages, see row_layout */
+#define ROW_FORMAT_FIXED   0
+#define ROW_FORMAT_VARLEN  1
+
 /* debug */
 #ifndef NDEBUG
 #include <cstdio>
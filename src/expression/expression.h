@@ -20,10 +20,9 @@ struct expression
 	static expression eval(const expr_node_t *expr);
 	static std::string to_string(const expr_node_t *expr);
 	static bool is_aggregate(const expr_node_t *expr);
-	static void cache_clear();
-	static void cache_clear(const char *table);
-	static void cache_replace(const char *table, const char* col, expression expr);
-	static void cache_column(const char *table, const char *col, const expression &expr);
+	// compile expr into a program for eval, false if it is not compiled
+	static bool compile(expr_node_t *expr);
+	static void free_program(expr_node_t *expr);
 
 	static void dump_exprnode(std::ostream &os, const expr_node_t *expr);
 	static expr_node_t* load_exprnode(std::istream &is);
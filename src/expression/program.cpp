@@ -0,0 +1,411 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include "program.h"
+#include "../utils/comparer.h"
+#include "../utils/type_cast.h"
+
+int expr_program::add_const(const expression &val)
+{
+	regs.push_back(val);
+	is_const.push_back(true);
+	return regs.size() - 1;
+}
+
+int expr_program::add_insn(uint8_t op, term_type_t type, int a, int b)
+{
+	insn_t in;
+	std::memset(&in, 0, sizeof(in));
+	in.op   = op;
+	in.type = type;
+	in.dst  = regs.size();
+	in.a    = a;
+	in.b    = b;
+	code.push_back(in);
+
+	expression val;
+	val.type = TERM_NULL;
+	regs.push_back(val);
+	is_const.push_back(false);
+	return in.dst;
+}
+
+int expr_program::fold(const expr_node_t *expr, term_type_t &type)
+{
+	expression val;
+	try {
+		val = expression::eval(expr);
+	} catch(const char *) {
+		// fails for every row
+		return -1;
+	}
+
+	type = val.type;
+	return add_const(val);
+}
+
+static bool str_less(const char *a, const char *b)
+{
+	return std::strcmp(a, b) < 0;
+}
+
+// sort list[from, end) and remove the duplicates, return the number left
+template<typename T, typename Compare>
+static int sort_unique(std::vector<T> &list, int from, Compare less)
+{
+	std::sort(list.begin() + from, list.end(), less);
+	auto last = std::unique(list.begin() + from, list.end(),
+		[&](const T &a, const T &b) { return !less(a, b) && !less(b, a); } );
+	list.erase(last, list.end());
+	return list.size() - from;
+}
+
+int expr_program::compile_in(const expr_node_t *expr, int left, term_type_t left_type)
+{
+	const expr_node_t *right = expr->right;
+	if(right->op != OPERATOR_NONE || right->term_type != TERM_LITERAL_LIST)
+		return -1;
+	if(is_const[left])
+		return fold(expr, left_type);
+
+	uint8_t op;
+	int list;
+	switch(left_type)
+	{
+		case TERM_INT:
+		case TERM_DATE:
+			op = OP_IN_I;
+			list = int_list.size();
+			break;
+		case TERM_FLOAT:
+			op = OP_IN_F;
+			list = float_list.size();
+			break;
+		case TERM_STRING:
+			op = OP_IN_S;
+			list = string_list.size();
+			break;
+		default:
+			return -1;
+	}
+
+	// the values must all be comparable with the operand
+	int len = 0;
+	for(linked_list_t *l_ptr = right->literal_list; l_ptr; l_ptr = l_ptr->next, ++len)
+	{
+		const expr_node_t *val = (const expr_node_t*)l_ptr->data;
+		if(val->op != OPERATOR_NONE)
+			return -1;
+		switch(left_type)
+		{
+			case TERM_INT:
+				if(val->term_type != TERM_INT)
+					return -1;
+				int_list.push_back(val->val_i);
+				break;
+			case TERM_DATE: {
+				if(val->term_type != TERM_DATE)
+					return -1;
+				expression date = expression::eval(val);
+				if(date.type != TERM_DATE)
+					return -1;
+				int_list.push_back(date.val_i);
+				break;
+			}
+			case TERM_FLOAT:
+				if(val->term_type != TERM_FLOAT)
+					return -1;
+				float_list.push_back(val->val_f);
+				break;
+			default:
+				if(val->term_type != TERM_STRING && val->term_type != TERM_DATE)
+					return -1;
+				string_list.push_back(val->val_s);
+				break;
+		}
+	}
+
+	// the values are searched by binary search when the program runs
+	switch(op)
+	{
+		case OP_IN_I:
+			len = sort_unique(int_list, list, std::less<int>());
+			break;
+		case OP_IN_F:
+			len = sort_unique(float_list, list, std::less<float>());
+			break;
+		default:
+			len = sort_unique(string_list, list, str_less);
+			break;
+	}
+
+	int r = add_insn(op, TERM_BOOL, left, left);
+	code.back().list = list;
+	code.back().list_len = len;
+	return r;
+}
+
+int expr_program::compile_node(const expr_node_t *expr, term_type_t &type)
+{
+	if(expr->op == OPERATOR_NONE)
+	{
+		if(expr->term_type == TERM_LITERAL_LIST)
+			return -1;
+		if(expr->term_type != TERM_COLUMN_REF)
+			return fold(expr, type);
+
+		const column_ref_t *col = expr->column_ref;
+		if(!col->record)
+			return -1;
+		type = typecast::column_to_term(col->type);
+		int r = add_insn(OP_LOAD, type, 0, 0);
+		code.back().record = col->record;
+		code.back().cid    = col->cid;
+		code.back().offset = col->offset;
+		return r;
+	}
+
+	// aggregates are accumulated by the caller
+	if(expression::is_aggregate(expr))
+		return -1;
+
+	size_t code_size = code.size();
+	term_type_t left_type, right_type;
+	int left = compile_node(expr->left, left_type);
+	if(left < 0) return -1;
+	if(expr->op == OPERATOR_IN)
+	{
+		type = TERM_BOOL;
+		return compile_in(expr, left, left_type);
+	}
+
+	bool is_unary = expr->op & OPERATOR_UNARY;
+	int right = left;
+	right_type = left_type;
+	if(!is_unary)
+	{
+		right = compile_node(expr->right, right_type);
+		if(right < 0) return -1;
+	}
+
+	if(is_const[left] && is_const[right])
+	{
+		// the division by zero is left to the row
+		if(expr->op == OPERATOR_DIV && left_type == TERM_INT && right_type == TERM_INT
+			&& (regs[right].val_i == 0 || (regs[right].val_i == -1 && regs[left].val_i == INT_MIN)))
+			return -1;
+		return fold(expr, type);
+	}
+
+	if(!is_unary && (left_type == TERM_NULL || right_type == TERM_NULL))
+	{
+		// a NULL operand gives NULL whatever the other one is
+		code.resize(code_size);
+		expression null;
+		null.type = TERM_NULL;
+		type = TERM_NULL;
+		return add_const(null);
+	}
+
+	if(left_type != right_type)
+		return -1;
+
+	int op = -1;
+	type = TERM_BOOL;
+	switch(expr->op)
+	{
+		case OPERATOR_ISNULL:
+			op = OP_ISNULL;
+			break;
+		case OPERATOR_NOTNULL:
+			op = OP_NOTNULL;
+			break;
+		case OPERATOR_NEGATE:
+		case OPERATOR_ADD:
+		case OPERATOR_MINUS:
+		case OPERATOR_MUL:
+		case OPERATOR_DIV: {
+			static const uint8_t int_ops[]   = { OP_NEG_I, OP_ADD_I, OP_SUB_I, OP_MUL_I, OP_DIV_I };
+			static const uint8_t float_ops[] = { OP_NEG_F, OP_ADD_F, OP_SUB_F, OP_MUL_F, OP_DIV_F };
+			int k = expr->op == OPERATOR_NEGATE ? 0 : expr->op == OPERATOR_ADD ? 1
+				: expr->op == OPERATOR_MINUS ? 2 : expr->op == OPERATOR_MUL ? 3 : 4;
+			type = left_type;
+			if(left_type == TERM_INT)
+				op = int_ops[k];
+			else if(left_type == TERM_FLOAT)
+				op = float_ops[k];
+			break;
+		}
+		case OPERATOR_EQ:
+		case OPERATOR_NEQ:
+		case OPERATOR_LT:
+		case OPERATOR_LEQ:
+		case OPERATOR_GT:
+		case OPERATOR_GEQ: {
+			static const uint8_t int_ops[]   = { OP_EQ_I, OP_NEQ_I, OP_LT_I, OP_LEQ_I, OP_GT_I, OP_GEQ_I };
+			static const uint8_t float_ops[] = { OP_EQ_F, OP_NEQ_F, OP_LT_F, OP_LEQ_F, OP_GT_F, OP_GEQ_F };
+			int k = expr->op == OPERATOR_EQ ? 0 : expr->op == OPERATOR_NEQ ? 1
+				: expr->op == OPERATOR_LT ? 2 : expr->op == OPERATOR_LEQ ? 3
+				: expr->op == OPERATOR_GT ? 4 : 5;
+			if(left_type == TERM_INT || left_type == TERM_DATE)
+				op = int_ops[k];
+			else if(left_type == TERM_FLOAT)
+				op = float_ops[k];
+			else if(left_type == TERM_STRING && k < 2)
+				op = k == 0 ? OP_EQ_S : OP_NEQ_S;
+			else if(left_type == TERM_BOOL && k < 2)
+				op = k == 0 ? OP_EQ_B : OP_NEQ_B;
+			break;
+		}
+		case OPERATOR_LIKE:
+			if(left_type == TERM_STRING)
+				op = OP_LIKE_S;
+			break;
+		case OPERATOR_AND:
+		case OPERATOR_OR:
+			if(left_type == TERM_BOOL)
+				op = expr->op == OPERATOR_AND ? OP_AND : OP_OR;
+			break;
+		default:
+			break;
+	}
+
+	if(op < 0) return -1;
+	if(op == OP_LIKE_S && is_const[right])
+	{
+		// the pattern is parsed once for all rows
+		int r = add_insn(OP_LIKE_P, type, left, left);
+		code.back().list = like_list.size();
+		like_list.emplace_back(regs[right].val_s);
+		return r;
+	}
+
+	return add_insn(op, type, left, right);
+}
+
+expr_program *expr_program::compile(const expr_node_t *expr)
+{
+	expr_program *prog = new expr_program;
+	term_type_t type;
+	prog->result = prog->compile_node(expr, type);
+	if(prog->result < 0 || prog->regs.size() > UINT16_MAX)
+	{
+		delete prog;
+		return nullptr;
+	}
+
+	return prog;
+}
+
+#define BINARY_OP(field, value) \
+	if(a.type == TERM_NULL || b.type == TERM_NULL) { \
+		d.type = TERM_NULL; \
+	} else { \
+		d.field = (value); \
+		d.type = (term_type_t)in.type; \
+	} \
+	break;
+
+
+expression expr_program::run()
+{
+	expression *r = regs.data();
+	for(const insn_t &in : code)
+	{
+		expression &d = r[in.dst];
+		const expression &a = r[in.a], &b = r[in.b];
+		switch(in.op)
+		{
+			case OP_LOAD:
+			{
+				const char *rec = *in.record;
+				if((((const int*)rec)[1] >> in.cid) & 1)
+				{
+					d.type = TERM_NULL;
+					break;
+				}
+
+				if(in.type == TERM_STRING)
+					d.val_s = (char*)rec + in.offset;
+				else std::memcpy(&d.val_i, rec + in.offset, sizeof(int));
+				d.type = (term_type_t)in.type;
+				break;
+			}
+			case OP_ADD_I:    BINARY_OP(val_i, a.val_i + b.val_i)
+			case OP_SUB_I:    BINARY_OP(val_i, a.val_i - b.val_i)
+			case OP_MUL_I:    BINARY_OP(val_i, a.val_i * b.val_i)
+			case OP_DIV_I:    BINARY_OP(val_i, a.val_i / b.val_i)
+			case OP_NEG_I:    BINARY_OP(val_i, -a.val_i)
+			case OP_ADD_F:    BINARY_OP(val_f, a.val_f + b.val_f)
+			case OP_SUB_F:    BINARY_OP(val_f, a.val_f - b.val_f)
+			case OP_MUL_F:    BINARY_OP(val_f, a.val_f * b.val_f)
+			case OP_DIV_F:    BINARY_OP(val_f, a.val_f / b.val_f)
+			case OP_NEG_F:    BINARY_OP(val_f, -a.val_f)
+			case OP_EQ_I:     BINARY_OP(val_b, a.val_i == b.val_i)
+			case OP_NEQ_I:    BINARY_OP(val_b, a.val_i != b.val_i)
+			case OP_LT_I:     BINARY_OP(val_b, a.val_i < b.val_i)
+			case OP_LEQ_I:    BINARY_OP(val_b, a.val_i <= b.val_i)
+			case OP_GT_I:     BINARY_OP(val_b, a.val_i > b.val_i)
+			case OP_GEQ_I:    BINARY_OP(val_b, a.val_i >= b.val_i)
+			case OP_EQ_F:     BINARY_OP(val_b, a.val_f == b.val_f)
+			case OP_NEQ_F:    BINARY_OP(val_b, a.val_f != b.val_f)
+			case OP_LT_F:     BINARY_OP(val_b, a.val_f < b.val_f)
+			case OP_LEQ_F:    BINARY_OP(val_b, a.val_f <= b.val_f)
+			case OP_GT_F:     BINARY_OP(val_b, a.val_f > b.val_f)
+			case OP_GEQ_F:    BINARY_OP(val_b, a.val_f >= b.val_f)
+			case OP_EQ_S:     BINARY_OP(val_b, strcasecmp(a.val_s, b.val_s) == 0)
+			case OP_NEQ_S:    BINARY_OP(val_b, strcasecmp(a.val_s, b.val_s) != 0)
+			case OP_LIKE_S:   BINARY_OP(val_b, strlike(a.val_s, b.val_s))
+			case OP_LIKE_P:   BINARY_OP(val_b, like_list[in.list].match(a.val_s))
+			case OP_EQ_B:     BINARY_OP(val_b, a.val_b == b.val_b)
+			case OP_NEQ_B:    BINARY_OP(val_b, a.val_b != b.val_b)
+			case OP_AND:      BINARY_OP(val_b, a.val_b & b.val_b)
+			case OP_OR:       BINARY_OP(val_b, a.val_b | b.val_b)
+			case OP_ISNULL:
+				d.val_b = a.type == TERM_NULL;
+				d.type  = TERM_BOOL;
+				break;
+			case OP_NOTNULL:
+				d.val_b = a.type != TERM_NULL;
+				d.type  = TERM_BOOL;
+				break;
+			case OP_IN_I: {
+				const int *list = int_list.data() + in.list;
+				d.val_b = a.type != TERM_NULL && std::binary_search(list, list + in.list_len, a.val_i);
+				d.type  = TERM_BOOL;
+				break;
+			}
+			case OP_IN_F: {
+				const float *list = float_list.data() + in.list;
+				d.val_b = a.type != TERM_NULL && std::binary_search(list, list + in.list_len, a.val_f);
+				d.type  = TERM_BOOL;
+				break;
+			}
+			case OP_IN_S: {
+				const char *const *list = string_list.data() + in.list;
+				d.val_b = a.type != TERM_NULL
+					&& std::binary_search(list, list + in.list_len, a.val_s, str_less);
+				d.type  = TERM_BOOL;
+				break;
+			}
+		}
+	}
+
+	return r[result];
+}
+
+bool expression::compile(expr_node_t *expr)
+{
+	if(!expr || expr->program)
+		return false;
+	expr->program = expr_program::compile(expr);
+	return expr->program != nullptr;
+}
+
+void expression::free_program(expr_node_t *expr)
+{
+	if(!expr) return;
+	delete expr->program;
+	expr->program = nullptr;
+}
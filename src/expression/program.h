@@ -0,0 +1,74 @@
+#ifndef __TRIVIALDB_EXPR_PROGRAM__
+#define __TRIVIALDB_EXPR_PROGRAM__
+
+#include <stdint.h>
+#include <vector>
+#include "expression.h"
+#include "../utils/like_matcher.h"
+
+/* An expression compiled into a linear program over registers.
+ *
+ * The types of operands are checked once when compiling, so each
+ * instruction is specialized for the types of its operands, and the
+ * subexpressions of constants are folded. Column references must be
+ * bound to the cached records of their tables before compiling, and
+ * are read from the records when the program runs. The registers of
+ * constants are filled when compiling and never written by the program.
+ *
+ * Expressions which may fail when evaluated, such as operands of
+ * mismatched types, or unbound column references, are not compiled
+ * and are left to expression::eval, which reports the errors. */
+struct expr_program
+{
+	enum opcode_t
+	{
+		OP_LOAD,
+		OP_ADD_I, OP_SUB_I, OP_MUL_I, OP_DIV_I, OP_NEG_I,
+		OP_ADD_F, OP_SUB_F, OP_MUL_F, OP_DIV_F, OP_NEG_F,
+		OP_EQ_I, OP_NEQ_I, OP_LT_I, OP_LEQ_I, OP_GT_I, OP_GEQ_I,
+		OP_EQ_F, OP_NEQ_F, OP_LT_F, OP_LEQ_F, OP_GT_F, OP_GEQ_F,
+		OP_EQ_S, OP_NEQ_S, OP_LIKE_S, OP_LIKE_P,
+		OP_EQ_B, OP_NEQ_B, OP_AND, OP_OR,
+		OP_ISNULL, OP_NOTNULL,
+		OP_IN_I, OP_IN_F, OP_IN_S,
+	};
+
+	struct insn_t
+	{
+		uint8_t op;
+		// the type of the column loaded, or of the result
+		uint8_t type;
+		uint16_t dst, a, b;
+		// the column of OP_LOAD in the record cached by a table
+		const char *const *record;
+		int cid, offset;
+		// the sorted values of OP_IN_* in the list of their type,
+		// or the pattern of OP_LIKE_P in like_list
+		int list, list_len;
+	};
+
+private:
+	std::vector<insn_t> code;
+	std::vector<expression> regs;
+	std::vector<bool> is_const;
+	int result;
+
+	std::vector<int> int_list;
+	std::vector<float> float_list;
+	std::vector<const char*> string_list;
+	std::vector<like_matcher> like_list;
+
+	int add_const(const expression &val);
+	int add_insn(uint8_t op, term_type_t type, int a, int b);
+	int fold(const expr_node_t *expr, term_type_t &type);
+	int compile_in(const expr_node_t *expr, int left, term_type_t left_type);
+	// the register of the value of expr, -1 if it is not compiled
+	int compile_node(const expr_node_t *expr, term_type_t &type);
+
+public:
+	// nullptr if expr is left to expression::eval
+	static expr_program *compile(const expr_node_t *expr);
+	expression run();
+};
+
+#endif
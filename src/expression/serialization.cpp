@@ -92,7 +92,7 @@ expr_node_t* expression::load_exprnode(std::istream &is)
 				break;
 			case TERM_COLUMN_REF:
 				is >> tmp;
-				expr->column_ref = (column_ref_t*)malloc(sizeof(column_ref_t));
+				expr->column_ref = (column_ref_t*)calloc(1, sizeof(column_ref_t));
 				if(tmp == 2)
 				{
 					expr->column_ref->table = load_string(is);
@@ -55,6 +55,16 @@ public:
 	{
 		page_fs::get_instance()->mark_dirty(fid, page_id);
 	}
+
+	void pin(const char *buf)
+	{
+		page_fs::get_instance()->pin(buf);
+	}
+
+	void unpin(const char *buf)
+	{
+		page_fs::get_instance()->unpin(buf);
+	}
 };
 
 #endif
@@ -6,6 +6,7 @@
 page_fs::page_fs()
 {
 	std::memset(dirty, 0, sizeof(dirty));
+	std::memset(pins, 0, sizeof(pins));
 	std::memset(index2page, 0, sizeof(index2page));
 }
 
@@ -49,6 +50,17 @@ void page_fs::close(int file_id)
 	assert(fm.is_used(file_id));
 
 	writeback(file_id);
+
+	// the file id will be reused, clean pages must not stay in the cache
+	for(int i = 0; i != PAGE_CACHE_CAPACITY; ++i)
+	{
+		if(index2page[i].first == file_id)
+		{
+			page2index.erase(index2page[i]);
+			index2page[i] = { 0, 0 };
+		}
+	}
+
 	fm.deallocate(file_id);
 	std::fclose(files[file_id]);
 }
@@ -118,8 +130,8 @@ char* page_fs::read(int file_id, int page_id, int& index)
 	if(it == page2index.end())
 	{
 		// not in cache
-		free_last_cache();
-		index = cm.last();
+		index = victim();
+		free_cache(index);
 		cm.access(index);
 		dirty[index] = 0;
 		page2index[key] = index;
@@ -148,20 +160,32 @@ void page_fs::write_page_to_file(int file_id, int page_id, const char* data)
 	std::fwrite(data, PAGE_SIZE, 1, files[file_id]);
 }
 
-void page_fs::free_last_cache()
+int page_fs::victim()
 {
+	// pinned pages are moved to the front, there are only a few of them
 	int last = cm.last();
-	file_page_t key = index2page[last];
+	while(pins[last])
+	{
+		cm.access(last);
+		last = cm.last();
+	}
+
+	return last;
+}
+
+void page_fs::free_cache(int index)
+{
+	file_page_t key = index2page[index];
 	if(key.first != 0)
 	{
-		if(dirty[last])
+		if(dirty[index])
 		{
 			debug_printf("Free cache and writeback: fid = %d, pid = %d\n", key.first, key.second);
-			write_page_to_file(key.first, key.second, buffer + last * PAGE_SIZE);
+			write_page_to_file(key.first, key.second, buffer + index * PAGE_SIZE);
 		}
 
 		page2index.erase(page2index.find(key));
-		index2page[last] = { 0, 0 };
+		index2page[index] = { 0, 0 };
 	}
 }
 
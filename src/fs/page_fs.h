@@ -30,6 +30,8 @@ class page_fs
 private:
 	/* cache */
 	char dirty[PAGE_CACHE_CAPACITY];
+	// pinned pages are never chosen to be freed
+	int pins[PAGE_CACHE_CAPACITY];
 	char buffer[PAGE_CACHE_CAPACITY * PAGE_SIZE];
 	char tmp_buffer[PAGE_SIZE];
 	cache_manager cm;
@@ -47,7 +49,8 @@ private:
 
 private:
 	char* read(int file_id, int page_id, int& index);
-	void free_last_cache();
+	int victim();
+	void free_cache(int index);
 	void write_page_to_file(int file_id, int page_id, const char* data);
 
 private:
@@ -79,6 +82,17 @@ public:
 		return buf;
 	}
 
+	/* keep the cached page containing buf in memory, so that pointers
+	 * into it stay valid until it is unpinned */
+	void pin(const char *buf) {
+		++pins[(buf - buffer) / PAGE_SIZE];
+	}
+
+	void unpin(const char *buf) {
+		assert(pins[(buf - buffer) / PAGE_SIZE] > 0);
+		--pins[(buf - buffer) / PAGE_SIZE];
+	}
+
 public:
 	static page_fs* get_instance()
 	{
@@ -0,0 +1,52 @@
+#include "spill_file.h"
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+
+spill_file::spill_file(const char *prefix)
+{
+	// spills of statements on different threads never share a file
+	static std::atomic<int> spill_counter(0);
+	filename = std::string("data/") + prefix + "_" + std::to_string(spill_counter++) + ".tmp";
+	std::remove(filename.c_str());
+	pf = new page_file(filename.c_str());
+}
+
+spill_file::~spill_file()
+{
+	delete pf;
+	std::remove(filename.c_str());
+}
+
+void spill_file::append(stream_t &s, const void *data, int len)
+{
+	const char *src = (const char*)data;
+	while(len > 0)
+	{
+		int offset = s.length % PAGE_SIZE;
+		if(offset == 0)
+			s.pages.push_back(pf->new_page());
+		int n = std::min(len, PAGE_SIZE - offset);
+		char *page = pf->read_for_write(s.pages.back());
+		std::memcpy(page + offset, src, n);
+		src += n;
+		len -= n;
+		s.length += n;
+	}
+}
+
+void spill_file::read(const stream_t &s, size_t pos, void *buf, int len)
+{
+	char *dst = (char*)buf;
+	while(len > 0)
+	{
+		int offset = pos % PAGE_SIZE;
+		int n = std::min(len, PAGE_SIZE - offset);
+		const char *page = pf->read(s.pages[pos / PAGE_SIZE]);
+		std::memcpy(dst, page + offset, n);
+		dst += n;
+		len -= n;
+		pos += n;
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef __TRIVIALDB_SPILL_FILE__
+#define __TRIVIALDB_SPILL_FILE__
+
+#include <string>
+#include <vector>
+#include "page_file.h"
+
+/* Temporary page file for the data that do not fit in memory,
+ * it is removed when closed. Data are appended to streams, each of
+ * which is a chain of pages of the file. */
+class spill_file
+{
+	page_file *pf;
+	std::string filename;
+
+public:
+	struct stream_t
+	{
+		std::vector<int> pages;
+		size_t length;
+
+		stream_t() : length(0) {}
+	};
+
+public:
+	// prefix is the name of the file under data/
+	spill_file(const char *prefix);
+	~spill_file();
+	spill_file(const spill_file&) = delete;
+	spill_file& operator = (const spill_file&) = delete;
+
+	const char *get_filename() const { return filename.c_str(); }
+	void append(stream_t &s, const void *data, int len);
+	void read(const stream_t &s, size_t pos, void *buf, int len);
+};
+
+#endif
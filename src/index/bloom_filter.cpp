@@ -0,0 +1,96 @@
+#include "bloom_filter.h"
+#include "../page/overflow_page.h"
+#include <algorithm>
+#include <cstring>
+
+void bloom_filter::reset(int capacity)
+{
+	this->capacity = std::max(capacity, BLOOM_MIN_CAPACITY);
+	bit_num = (this->capacity * BLOOM_BITS_PER_KEY + 63) / 64 * 64;
+	// k = ln 2 * (m / n)
+	hash_num = std::max(1, BLOOM_BITS_PER_KEY * 69 / 100);
+	key_num = 0;
+	bits.assign(bit_num / 64, 0);
+}
+
+void bloom_filter::add(uint64_t h)
+{
+	uint64_t delta = (h >> 33) | (h << 31);
+	for(uint32_t i = 0; i != hash_num; ++i, h += delta)
+	{
+		uint64_t pos = h % bit_num;
+		bits[pos >> 6] |= 1ull << (pos & 63);
+	}
+
+	++key_num;
+}
+
+bool bloom_filter::may_contain(uint64_t h) const
+{
+	uint64_t delta = (h >> 33) | (h << 31);
+	for(uint32_t i = 0; i != hash_num; ++i, h += delta)
+	{
+		uint64_t pos = h % bit_num;
+		if(!(bits[pos >> 6] & (1ull << (pos & 63))))
+			return false;
+	}
+
+	return true;
+}
+
+void bloom_filter::load(pager *pg, int pid)
+{
+	std::vector<char> data;
+	for(; pid; )
+	{
+		overflow_page page { pg->read(pid), pg };
+		assert(page.magic() == PAGE_OVERFLOW);
+		data.insert(data.end(), page.block(), page.block() + page.size());
+		pid = page.next();
+	}
+
+	uint32_t info[4];
+	if(data.size() < sizeof(info))
+	{
+		reset(BLOOM_MIN_CAPACITY);
+		return;
+	}
+
+	std::memcpy(info, data.data(), sizeof(info));
+	bit_num  = info[0];
+	hash_num = info[1];
+	key_num  = info[2];
+	capacity = info[3];
+	bits.assign(bit_num / 64, 0);
+	assert(data.size() == sizeof(info) + bits.size() * sizeof(uint64_t));
+	std::memcpy(bits.data(), data.data() + sizeof(info), bits.size() * sizeof(uint64_t));
+}
+
+int bloom_filter::save(pager *pg, int old_pid)
+{
+	if(old_pid) pg->free_overflow_page(old_pid);
+
+	uint32_t info[4] = { bit_num, hash_num, key_num, capacity };
+	std::vector<char> data(sizeof(info) + bits.size() * sizeof(uint64_t));
+	std::memcpy(data.data(), info, sizeof(info));
+	std::memcpy(data.data() + sizeof(info), bits.data(), bits.size() * sizeof(uint64_t));
+
+	int first_pid = 0;
+	overflow_page prev { nullptr, pg };
+	for(size_t offset = 0; offset < data.size(); )
+	{
+		int pid = pg->new_page();
+		overflow_page page { pg->read_for_write(pid), pg };
+		page.init();
+		int to_copy = std::min<size_t>(overflow_page::block_size(), data.size() - offset);
+		page.size_ref() = to_copy;
+		std::memcpy(page.block(), data.data() + offset, to_copy);
+		offset += to_copy;
+
+		if(prev.buf) prev.next_ref() = pid;
+		else first_pid = pid;
+		prev = page;
+	}
+
+	return first_pid;
+}
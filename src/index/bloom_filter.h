@@ -0,0 +1,33 @@
+#ifndef __TRIVIALDB_BLOOM_FILTER__
+#define __TRIVIALDB_BLOOM_FILTER__
+
+#include <stdint.h>
+#include <vector>
+#include "../defs.h"
+#include "../page/pager.h"
+
+/* Bloom filter over the keys of a secondary index.
+ * It is stored in a chain of overflow pages of the table file:
+ *   | bit_num | hash_num | key_num | capacity | bits ... |
+ * Erased keys stay in the filter, so it only gives false positives. */
+class bloom_filter
+{
+	uint32_t bit_num, hash_num, key_num, capacity;
+	std::vector<uint64_t> bits;
+
+public:
+	explicit bloom_filter(int capacity = BLOOM_MIN_CAPACITY) { reset(capacity); }
+
+	void reset(int capacity);
+	void add(uint64_t h);
+	bool may_contain(uint64_t h) const;
+	// more keys than the filter is sized for, false positive rate grows
+	bool saturated() const { return key_num > capacity; }
+	int get_capacity() const { return capacity; }
+
+	void load(pager *pg, int pid);
+	// write the filter into a new page chain, release the old one
+	int save(pager *pg, int old_pid);
+};
+
+#endif
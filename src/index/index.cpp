@@ -2,38 +2,59 @@
 #include "../utils/comparer.h"
 #include <cstring>
 
-index_manager::index_manager(pager *pg, int size, int root_pid, comparer_t comparer)
+index_manager::index_manager(pager *pg, int size, int root_pid, comparer_t comparer, bool varkey)
 {
 	this->pg = pg;
 	this->size = size;
+	this->bloom = nullptr;
+	this->hasher = nullptr;
+	this->comparer = comparer;
 	// [rid, nullmark, data]
-	buf = new char[size + sizeof(int) + 1];
-	btr = new index_btree(pg, root_pid, size + sizeof(int) + 1,
-		[comparer](const char *a, const char *b) -> int {
-			if(a[4] != b[4])
-			{
-				// one of A and B is NULL
-				return a[4] ? -1 : 1;
-			} else if(!a[4]) {
-				// A and B are not NULL
-				int r = comparer(a + sizeof(int) + 1, b + sizeof(int) + 1);
-				if(r != 0) return r;
-			}
-
-			return integer_comparer(*(int*)a, *(int*)b);
-		} );
+	int field_size = size + sizeof(int) + 1;
+	buf = new char[field_size];
+	auto entry_comparer = [comparer](const char *a, const char *b) -> int {
+		if(a[4] != b[4])
+		{
+			// one of A and B is NULL
+			return a[4] ? -1 : 1;
+		} else if(!a[4]) {
+			// A and B are not NULL
+			int r = comparer(a + sizeof(int) + 1, b + sizeof(int) + 1);
+			if(r != 0) return r;
+		}
+
+		return integer_comparer(*(int*)a, *(int*)b);
+	};
+
+	if(root_pid)
+	{
+		uint16_t magic = general_page::get_magic_number(pg->read(root_pid));
+		varkey = magic == PAGE_VARKEY || magic == PAGE_VARKEY_LEAF;
+	} else if(field_size > varkey_page::max_field_size()) {
+		varkey = false;
+	}
+
+	btr = nullptr;
+	varkey_btr = nullptr;
+	if(varkey) varkey_btr = new varkey_btree(pg, root_pid, field_size, entry_comparer);
+	else btr = new index_btree(pg, root_pid, field_size, entry_comparer);
 }
 
 index_manager::~index_manager()
 {
 	delete []buf;
 	delete btr;
+	delete varkey_btr;
+	delete bloom;
 	buf = nullptr;
 	btr = nullptr;
+	varkey_btr = nullptr;
+	bloom = nullptr;
 }
 
 int index_manager::get_root_pid()
 {
+	if(varkey_btr) return varkey_btr->get_root_page_id();
 	return btr->get_root_page_id();
 }
 
@@ -50,16 +71,60 @@ void index_manager::fill_buf(const char *key, int rid)
 	}
 }
 
+void index_manager::enable_bloom_filter(hasher_t hasher, int bloom_pid)
+{
+	assert(!bloom);
+	this->hasher = hasher;
+	bloom = new bloom_filter;
+	// a filter not saved yet is built from the keys already in the index
+	if(bloom_pid) bloom->load(pg, bloom_pid);
+	else rebuild_bloom_filter(BLOOM_MIN_CAPACITY);
+}
+
+int index_manager::save_bloom_filter(int old_pid)
+{
+	if(!bloom) return 0;
+	return bloom->save(pg, old_pid);
+}
+
+bool index_manager::may_contain(const char *key)
+{
+	if(!bloom || !key) return true;
+	return bloom->may_contain(hasher(key, size));
+}
+
+void index_manager::rebuild_bloom_filter(int capacity)
+{
+	do {
+		bloom->reset(capacity);
+		auto it = get_iterator_lower_bound(nullptr, 0);
+		for(; !it.is_end(); it.next())
+		{
+			const char *key = get_entry(it.get(), nullptr);
+			if(key) bloom->add(hasher(key, size));
+		}
+
+		capacity *= 2;
+	} while(bloom->saturated());
+}
+
 void index_manager::insert(const char *key, int rid)
 {
 	fill_buf(key, rid);
-	btr->insert(buf, rid);
+	if(varkey_btr) varkey_btr->insert(buf, rid);
+	else btr->insert(buf, rid);
+	if(bloom && key)
+	{
+		bloom->add(hasher(key, size));
+		if(bloom->saturated())
+			rebuild_bloom_filter(bloom->get_capacity() * 2);
+	}
 }
 
 void index_manager::erase(const char *key, int rid)
 {
 	fill_buf(key, rid);
-	bool ret = btr->erase(buf);
+	bool ret = varkey_btr ? varkey_btr->erase(buf) : btr->erase(buf);
 	assert(ret);
 	UNUSED(ret);
 }
@@ -67,6 +132,7 @@ void index_manager::erase(const char *key, int rid)
 index_btree::search_result index_manager::lower_bound(const char *key, int rid)
 {
 	fill_buf(key, rid);
+	if(varkey_btr) return varkey_btr->lower_bound(buf);
 	return btr->lower_bound(buf);
 }
 
@@ -75,3 +141,31 @@ btree_iterator<index_btree::leaf_page> index_manager::get_iterator_lower_bound(c
 	auto ret = lower_bound(key, rid);
 	return { pg, ret.first, ret.second };
 }
+
+btree_iterator<index_btree::leaf_page> index_manager::get_iterator_last()
+{
+	auto ret = varkey_btr ? varkey_btr->last() : btr->last();
+	return { pg, ret.first, ret.second };
+}
+
+template<typename Page>
+static const char *read_entry(pager *pg, std::pair<int, int> pos, int *rid)
+{
+	Page page { pg->read(pos.first), pg };
+	const char *key = page.get_key(pos.second);
+	// [rid, nullmark, data]
+	if(rid) *rid = *(int*)key;
+	return key[4] ? nullptr : key + sizeof(int) + 1;
+}
+
+const char *index_manager::get_entry(std::pair<int, int> pos, int *rid)
+{
+	if(varkey_btr) return read_entry<varkey_leaf_page>(pg, pos, rid);
+	return read_entry<index_btree::leaf_page>(pg, pos, rid);
+}
+
+void index_manager::copy_key(char *dest, const char *key)
+{
+	if(varkey_btr) std::strncpy(dest, key, size);
+	else std::memcpy(dest, key, size);
+}
@@ -3,27 +3,53 @@
 #include <functional>
 #include "../btree/btree.h"
 #include "../btree/iterator.h"
+#include "bloom_filter.h"
 
 class index_manager
 {
 	char *buf;
+	// one of them is used, varkey_btr for an index keeping the keys with
+	// their actual lengths
 	index_btree *btr;
+	varkey_btree *varkey_btr;
 	int size;
 	pager *pg;
+	bloom_filter *bloom;
+	uint64_t(*hasher)(const char*, int);
+	int(*comparer)(const char*, const char*);
 
 	void fill_buf(const char *key, int rid);
+	// add all keys of the index to a filter sized for at least capacity keys
+	void rebuild_bloom_filter(int capacity);
 
 public:
 	typedef int(*comparer_t)(const char*, const char*);
+	typedef uint64_t(*hasher_t)(const char*, int);
 
-	index_manager(pager *pg, int size, int root_pid, comparer_t comparer);
+	/* A new index keeps the keys with their actual lengths if varkey is
+	 * set and the keys are small enough. An existing index is read in the
+	 * format of its pages. */
+	index_manager(pager *pg, int size, int root_pid, comparer_t comparer, bool varkey = false);
 	~index_manager();
 
 	int get_root_pid();
+	void enable_bloom_filter(hasher_t hasher, int bloom_pid);
+	// persist the bloom filter and return its page id, 0 if disabled
+	int save_bloom_filter(int old_pid);
+	// false if the key is definitely not in the index
+	bool may_contain(const char *key);
 	void insert(const char *key, int rid);
 	void erase(const char *key, int rid);
 	index_btree::search_result lower_bound(const char *key, int rid = 0);
 	btree_iterator<index_btree::leaf_page> get_iterator_lower_bound(const char *key, int rid = 0);
+	// iterator of the largest entry, used to iterate backward
+	btree_iterator<index_btree::leaf_page> get_iterator_last();
+	// read the entry at pos without touching the record, nullptr for NULL key
+	// the key of a varkey index ends at the zero of the string
+	const char *get_entry(std::pair<int, int> pos, int *rid);
+	// copy a key read by get_entry
+	void copy_key(char *dest, const char *key);
+	int compare(const char *a, const char *b) { return comparer(a, b); }
 
 };
 
@@ -33,8 +33,6 @@
 #include "parser/defs.h"
 #include "parser/parser.h"
 
-extern "C" char run_parser(const char *input);
-
 Uhpsqld::Uhpsqld() : port_(0) {}
 
 Uhpsqld::~Uhpsqld() {}
@@ -65,7 +63,9 @@ bool Uhpsqld::_Recycle() {
 int main(int argc, char *argv[]) {
   Uhpsqld svr;
   std::cout << "WELCOME TO TINY DB!" << std::endl;
-  run_parser("USE db;");
+  parser_result_t result;
+  run_parser("USE db;", &result);
+  parser_free_result(&result);
   svr.MainLoop(false);
 
   return 0;
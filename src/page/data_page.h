@@ -17,6 +17,7 @@ public:
 	using variant_page::variant_page;
 
 	PAGE_FIELD_ACCESSER(Key, key, get_block(id).second);
+	static Key separator(const Key& lower, const Key&, char*) { return lower; }
 
 	std::pair<int, data_page> split(int cur_id)
 	{
@@ -37,6 +37,8 @@ public:
 	char* begin() { return end() - size() * field_size(); }
 	char* end() { return buf + PAGE_SIZE; }
 
+	// keys are of the same size, so they always fit
+	bool replace_key(int pos, const T& key) { set_key(pos, key); return true; }
 	bool insert(int pos, const T& key, int child);
 	void erase(int pos);
 	std::pair<int, fixed_page> split(int cur_id);
@@ -164,7 +166,7 @@ bool fixed_page<T>::merge(fixed_page page, int cur_id)
 	}
 
 	std::memcpy(children() + size(), page.children(), 4 * page.size());
-	std::memmove(begin() - page.size() * field_size(), begin(), field_size() * page.size());
+	std::memmove(begin() - page.size() * field_size(), begin(), field_size() * size());
 	std::memcpy(end() - page.size() * field_size(), page.begin(), field_size() * page.size());
 	size_ref() += page.size();
 
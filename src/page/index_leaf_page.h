@@ -14,6 +14,9 @@ public:
 		this->magic_ref() = PAGE_INDEX_LEAF;
 	}
 
+	// the keys are not shortened
+	static T separator(const T& lower, const T&, char*) { return lower; }
+
 	std::pair<int, index_leaf_page> split(int cur_id)
 	{
 		auto pw = fixed_page<T>::split(cur_id);
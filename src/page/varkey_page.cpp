@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <vector>
+#include "varkey_page.h"
+
+// [rid, nullmark, data]
+static const int KEY_PREFIX_SIZE = sizeof(int) + 1;
+
+void varkey_page::init(int field_size)
+{
+	magic_ref() = PAGE_VARKEY;
+	field_size_ref() = field_size;
+	size_ref() = 0;
+	next_page_ref() = prev_page_ref() = 0;
+	free_size_ref() = PAGE_SIZE - header_size();
+	bottom_used_ref() = 0;
+}
+
+int varkey_page::key_length(const char *key)
+{
+	return KEY_PREFIX_SIZE + strnlen(key + KEY_PREFIX_SIZE,
+		field_size() - KEY_PREFIX_SIZE - 1) + 1;
+}
+
+void varkey_page::write_key(slot_t &slot, const char *key, int len)
+{
+	if(gap() < len) defragment();
+	bottom_used_ref() += len;
+	free_size_ref() -= len;
+	slot.offset = PAGE_SIZE - bottom_used();
+	slot.length = len;
+	std::memcpy(buf + slot.offset, key, len - 1);
+	buf[slot.offset + len - 1] = 0;
+}
+
+bool varkey_page::replace_key(int pos, const char *key)
+{
+	assert(0 <= pos && pos < size());
+	assert(key < buf || key >= buf + PAGE_SIZE);
+	slot_t &slot = slots()[pos];
+	int len = key_length(key);
+	if(len <= slot.length)
+	{
+		// the rest of the old key is left as a hole
+		free_size_ref() += slot.length - len;
+		slot.length = len;
+		std::memcpy(buf + slot.offset, key, len - 1);
+		buf[slot.offset + len - 1] = 0;
+		return true;
+	}
+
+	if(free_size() + slot.length < len)
+		return false;
+
+	if(slot.offset == PAGE_SIZE - bottom_used())
+		bottom_used_ref() -= slot.length;
+	free_size_ref() += slot.length;
+	slot.length = 0;
+	write_key(slot, key, len);
+	return true;
+}
+
+bool varkey_page::insert(int pos, const char *key, int child)
+{
+	assert(0 <= pos && pos <= size());
+	assert(key < buf || key >= buf + PAGE_SIZE);
+	int len = key_length(key);
+	if(free_size() < len + (int)sizeof(slot_t))
+		return false;
+
+	// the new slot takes the free space in the middle as well
+	if(gap() < len + (int)sizeof(slot_t))
+		defragment();
+
+	slot_t *s = slots();
+	std::memmove(s + pos + 1, s + pos, (size() - pos) * sizeof(slot_t));
+	++size_ref();
+	free_size_ref() -= sizeof(slot_t);
+	s[pos].child = child;
+	s[pos].length = 0;
+	write_key(s[pos], key, len);
+	return true;
+}
+
+void varkey_page::erase(int pos)
+{
+	assert(0 <= pos && pos < size());
+	slot_t *s = slots();
+	if(s[pos].offset == PAGE_SIZE - bottom_used())
+		bottom_used_ref() -= s[pos].length;
+	free_size_ref() += s[pos].length + sizeof(slot_t);
+	std::memmove(s + pos, s + pos + 1, (size() - pos - 1) * sizeof(slot_t));
+	--size_ref();
+}
+
+void varkey_page::defragment()
+{
+	int sz = size();
+	slot_t *s = slots();
+	std::vector<int> index(sz);
+	for(int i = 0; i != sz; ++i)
+		index[i] = i;
+	std::sort(index.begin(), index.end(), [=](int a, int b) {
+		return s[a].offset > s[b].offset;
+	} );
+
+	char *ptr = buf + PAGE_SIZE;
+	for(int i : index)
+	{
+		ptr -= s[i].length;
+		std::memmove(ptr, buf + s[i].offset, s[i].length);
+		s[i].offset = ptr - buf;
+	}
+
+	bottom_used_ref() = buf + PAGE_SIZE - ptr;
+}
+
+std::pair<int, varkey_page> varkey_page::split(int cur_id)
+{
+	if(size() < PAGE_BLOCK_MIN_NUM)
+		return { 0, { nullptr, nullptr } };
+
+	int page_id = pg->new_page();
+	if(!page_id) return { 0, { nullptr, nullptr } };
+	varkey_page upper_page { pg->read_for_write(page_id), pg };
+	upper_page.init(field_size());
+	upper_page.magic_ref() = magic();
+
+	if(next_page())
+	{
+		varkey_page page { pg->read_for_write(next_page()), pg };
+		assert(page.magic() == magic());
+		page.prev_page_ref() = page_id;
+	}
+	upper_page.next_page_ref() = next_page();
+	upper_page.prev_page_ref() = cur_id;
+	next_page_ref() = page_id;
+
+	// the lower part takes the keys up to half of the used space
+	slot_t *s = slots();
+	int lower_size = 0, lower_used = 0;
+	while(lower_size < size() - PAGE_BLOCK_MIN_NUM / 2)
+	{
+		int used = s[lower_size].length + sizeof(slot_t);
+		if(lower_size >= PAGE_BLOCK_MIN_NUM / 2 && lower_used + used > used_size() / 2)
+			break;
+		lower_used += used;
+		++lower_size;
+	}
+
+	for(int i = lower_size; i < size(); ++i)
+	{
+		bool succ_ins = upper_page.insert(i - lower_size, get_key(i), get_child(i));
+		assert(succ_ins);
+		UNUSED(succ_ins);
+	}
+
+	while(size() > lower_size)
+		erase(size() - 1);
+
+	return { page_id, upper_page };
+}
+
+bool varkey_page::merge(varkey_page page, int cur_id)
+{
+	if(used_size() + page.used_size() + field_size() > PAGE_SIZE - header_size())
+		return false;
+
+	next_page_ref() = page.next_page_ref();
+	if(next_page())
+	{
+		varkey_page next { pg->read_for_write(next_page()), pg };
+		assert(next.magic() == magic());
+		next.prev_page_ref() = cur_id;
+	}
+
+	for(int i = 0; i != page.size(); ++i)
+	{
+		bool succ_ins = insert(size(), page.get_key(i), page.get_child(i));
+		assert(succ_ins);
+		UNUSED(succ_ins);
+	}
+
+	return true;
+}
+
+void varkey_page::move_from(varkey_page page, int src_pos, int dest_pos)
+{
+	assert(page.magic() == magic());
+	bool succ_ins = insert(dest_pos,
+		page.get_key(src_pos),
+		page.get_child(src_pos));
+	page.erase(src_pos);
+	assert(succ_ins);
+	UNUSED(succ_ins);
+}
+
+const char *varkey_leaf_page::separator(const char *lower, const char *upper, char *buf)
+{
+	// NULL keys are the smallest
+	if(upper[KEY_PREFIX_SIZE - 1])
+		return lower;
+
+	const char *a = lower + KEY_PREFIX_SIZE, *b = upper + KEY_PREFIX_SIZE;
+	int len = 0;
+	if(!lower[KEY_PREFIX_SIZE - 1])
+	{
+		while(a[len] && a[len] == b[len])
+			++len;
+		// the strings are equal
+		if(!b[len]) return lower;
+		++len;
+	}
+
+	if(!b[len]) return lower;
+	std::memset(buf, 0, KEY_PREFIX_SIZE);
+	std::memcpy(buf + KEY_PREFIX_SIZE, b, len);
+	buf[KEY_PREFIX_SIZE + len] = 0;
+	return buf;
+}
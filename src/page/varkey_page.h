@@ -0,0 +1,122 @@
+#ifndef __TRIVIALDB_VARKEY_PAGE__
+#define __TRIVIALDB_VARKEY_PAGE__
+
+#include <cstring>
+#include <cassert>
+#include <utility>
+#include "page_defs.h"
+#include "pager.h"
+
+/* Page of an index keeping each key with its actual length.
+ *
+ * A key is an index entry [rid, nullmark, data] of a VARCHAR column,
+ * and only the string of data is saved, up to its terminating zero.
+ * The keys are placed from the end of the page, and their slots in the
+ * order of the keys after the header:
+ *
+ *  | header | slot 0 | slot 1 | ... | free | ... | key 1 | key 0 |
+ *
+ * An erased key leaves a hole, which is reclaimed when the free space
+ * in the middle runs out. The header begins with the fields of
+ * fixed_page, so the iterators of index leaves read both kinds. */
+class varkey_page : public general_page
+{
+	struct slot_t
+	{
+		int child;
+		uint16_t offset, length;
+	};
+
+	PAGE_FIELD_PTR(slots,       slot_t,   20);
+
+	int gap() { return PAGE_SIZE - header_size() - (int)sizeof(slot_t) * size() - bottom_used(); }
+	int key_length(const char *key);
+	void write_key(slot_t &slot, const char *key, int len);
+	void defragment();
+
+public:
+	using general_page::general_page;
+	PAGE_FIELD_REF(magic,       uint16_t, 0);   // page type
+	PAGE_FIELD_REF(field_size,  uint16_t, 2);   // size of a whole key
+	PAGE_FIELD_REF(size,        int,      4);   // number of items
+	PAGE_FIELD_REF(next_page,   int,      8);
+	PAGE_FIELD_REF(prev_page,   int,      12);
+	PAGE_FIELD_REF(free_size,   uint16_t, 16);  // size of free space, holes included
+	PAGE_FIELD_REF(bottom_used, uint16_t, 18);  // size of the area of keys
+	static constexpr int header_size() { return 20; }
+	// the largest field size for which a page holds PAGE_BLOCK_MIN_NUM keys
+	static constexpr int max_field_size()
+	{
+		return (PAGE_SIZE - header_size()) / PAGE_BLOCK_MIN_NUM - (int)sizeof(slot_t);
+	}
+
+	int used_size() { return PAGE_SIZE - header_size() - free_size(); }
+	bool underflow()
+	{
+		return free_size() > PAGE_FREE_SPACE_MAX
+			|| size() < PAGE_BLOCK_MIN_NUM / 2;
+	}
+
+	bool underflow_if_remove(int pos)
+	{
+		assert(0 <= pos && pos < size());
+		int free_size_if_remove = free_size() + slots()[pos].length + sizeof(slot_t);
+		return free_size_if_remove > PAGE_FREE_SPACE_MAX
+			|| size() - 1 < PAGE_BLOCK_MIN_NUM / 2;
+	}
+
+	const char *get_key(int id)
+	{
+		assert(0 <= id && id < size());
+		return buf + slots()[id].offset;
+	}
+
+	int get_child(int id)
+	{
+		assert(0 <= id && id < size());
+		return slots()[id].child;
+	}
+
+	void set_child(int id, int child)
+	{
+		assert(0 <= id && id < size());
+		slots()[id].child = child;
+	}
+
+	void init(int field_size);
+	// false if there is no space for the key, which is not in this page
+	bool replace_key(int pos, const char *key);
+	bool insert(int pos, const char *key, int child);
+	void erase(int pos);
+	std::pair<int, varkey_page> split(int cur_id);
+	// keeps space to replace a key after merging
+	bool merge(varkey_page page, int cur_id);
+	void move_from(varkey_page page, int src_pos, int dest_pos);
+};
+
+class varkey_leaf_page : public varkey_page
+{
+public:
+	using varkey_page::varkey_page;
+	void init(int field_size)
+	{
+		varkey_page::init(field_size);
+		magic_ref() = PAGE_VARKEY_LEAF;
+	}
+
+	std::pair<int, varkey_leaf_page> split(int cur_id)
+	{
+		auto ret = varkey_page::split(cur_id);
+		return { ret.first,
+			*reinterpret_cast<varkey_leaf_page*>(&ret.second)
+		};
+	}
+
+	/* A key not less than lower and less than upper, the string of
+	 * which is the shortest prefix of upper's larger than lower's. It
+	 * is built in buf, of the field size. lower is returned if there
+	 * is no such prefix shorter than upper's string. */
+	static const char *separator(const char *lower, const char *upper, char *buf);
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "arena.h"
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#define ARENA_ALIGN       16
+#define ARENA_FIRST_BLOCK (4 << 10)
+#define ARENA_MAX_BLOCK   (1 << 20)
+
+struct arena_block_t
+{
+	arena_block_t *next;
+	size_t size;
+	alignas(ARENA_ALIGN) char data[1];
+};
+
+struct parse_arena_t
+{
+	arena_block_t *blocks;
+	char *cur, *end;
+	// size of the next block, doubled up to ARENA_MAX_BLOCK
+	size_t next_size;
+};
+
+parse_arena_t *arena_create()
+{
+	parse_arena_t *arena = (parse_arena_t*)std::malloc(sizeof(parse_arena_t));
+	arena->blocks = nullptr;
+	arena->cur = arena->end = nullptr;
+	arena->next_size = ARENA_FIRST_BLOCK;
+	return arena;
+}
+
+void arena_destroy(parse_arena_t *arena)
+{
+	if(!arena) return;
+	for(arena_block_t *b = arena->blocks; b; )
+	{
+		arena_block_t *next = b->next;
+		std::free(b);
+		b = next;
+	}
+
+	std::free(arena);
+}
+
+void *arena_alloc(parse_arena_t *arena, size_t size)
+{
+	size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+	if((size_t)(arena->end - arena->cur) < size)
+	{
+		// a large allocation gets a block of its own
+		size_t block_size = std::max(size, arena->next_size);
+		arena_block_t *b = (arena_block_t*)std::malloc(offsetof(arena_block_t, data) + block_size);
+		b->next = arena->blocks;
+		b->size = block_size;
+		arena->blocks = b;
+		arena->cur = b->data;
+		arena->end = b->data + block_size;
+		arena->next_size = std::min<size_t>(arena->next_size * 2, ARENA_MAX_BLOCK);
+	}
+
+	void *ret = arena->cur;
+	arena->cur += size;
+	return ret;
+}
+
+void *arena_calloc(parse_arena_t *arena, size_t size)
+{
+	void *ret = arena_alloc(arena, size);
+	std::memset(ret, 0, size);
+	return ret;
+}
+
+char *arena_strndup(parse_arena_t *arena, const char *s, size_t n)
+{
+	n = strnlen(s, n);
+	char *ret = (char*)arena_alloc(arena, n + 1);
+	std::memcpy(ret, s, n);
+	ret[n] = 0;
+	return ret;
+}
+
+char *arena_strdup(parse_arena_t *arena, const char *s)
+{
+	return arena_strndup(arena, s, std::strlen(s));
+}
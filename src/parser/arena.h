@@ -0,0 +1,26 @@
+#ifndef __TRIVIALDB_PARSER_ARENA__
+#define __TRIVIALDB_PARSER_ARENA__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The memory of the parse tree of one statement. Nodes are never
+ * freed one by one, the whole arena is released after execution. */
+struct parse_arena_t;
+
+struct parse_arena_t *arena_create(void);
+void arena_destroy(struct parse_arena_t *arena);
+
+void *arena_alloc(struct parse_arena_t *arena, size_t size);
+void *arena_calloc(struct parse_arena_t *arena, size_t size);
+char *arena_strdup(struct parse_arena_t *arena, const char *s);
+char *arena_strndup(struct parse_arena_t *arena, const char *s, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
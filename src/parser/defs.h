@@ -93,6 +93,11 @@ typedef struct linked_list_t {
 typedef struct column_ref_t {
 	char *table;
 	char *column;
+	/* bound by dbms::bind_columns to the cached record of a table,
+	 * *record is the record, which may be in a data page,
+	 * record is NULL if unbound, and cid is -1 if it is ambiguous */
+	const char *const *record;
+	int cid, type, offset;
 } column_ref_t;
 
 typedef struct table_def_t {
@@ -119,6 +124,8 @@ typedef struct expr_node_t {
 	struct expr_node_t *right;
 	operator_type_t op;
 	term_type_t term_type;
+	/* the compiled program run by expression::eval, NULL if none */
+	struct expr_program *program;
 } expr_node_t;
 
 typedef struct table_constraint_t {
@@ -138,9 +145,17 @@ typedef struct update_info_t {
 	expr_node_t *where, *value;
 } update_info_t;
 
+typedef struct order_by_item_t {
+	expr_node_t *expr;
+	int desc;
+} order_by_item_t;
+
 typedef struct select_info_t {
 	linked_list_t *tables, *exprs;
 	expr_node_t *where;
+	linked_list_t *groups, *orders;
+	/* limit is -1 if there is no LIMIT */
+	int limit, offset;
 } select_info_t;
 
 typedef struct table_join_info_t {
@@ -163,6 +178,8 @@ typedef enum {
 	SQL_DELETE,
 	SQL_CREATE_INDEX,
 	SQL_DROP_INDEX,
+	SQL_ANALYZE_TABLE,
+	SQL_EXPLAIN,
 	SQL_SWITCH_OUTPUT,
 	SQL_QUIT,
 	SQL_RESET
@@ -174,6 +191,8 @@ typedef enum {
 typedef struct parser_result_t {
 	sql_type_t type;
 	void *param;
+	// holds param and everything it points to
+	struct parse_arena_t *arena;
 } parser_result_t;
 
 #ifdef __cplusplus
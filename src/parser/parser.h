@@ -2,28 +2,34 @@
 #define __TRIVIALDB_PARSER__
 
 #include "defs.h"
+#include "arena.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-extern parser_result_t result;
+/* parses the statements of input, or of stdin if it is NULL, into result,
+ * which is released by parser_free_result after it is executed */
+char run_parser(const char *input, parser_result_t *result);
+void parser_free_result(parser_result_t *result);
 
-void parser_create_database(const char *db_name);
-void parser_use_database(const char *db_name);
-void parser_drop_database(const char *db_name);
-void parser_show_database(const char *db_name);
-void parser_create_table(const table_def_t *table);
-void parser_drop_table(const char *table_name);
-void parser_show_table(const char *table_name);
-void parser_insert(const insert_info_t *insert_info);
-void parser_delete(const delete_info_t *delete_info);
-void parser_select(const select_info_t *select_info);
-void parser_update(const update_info_t *update_info);
-void parser_create_index(const char *table_name, const char *col_name);
-void parser_drop_index(const char *table_name, const char *col_name);
-void parser_switch_output(const char *output_filename);
-void parser_quit();
+void parser_create_database(parser_result_t *result, const char *db_name);
+void parser_use_database(parser_result_t *result, const char *db_name);
+void parser_drop_database(parser_result_t *result, const char *db_name);
+void parser_show_database(parser_result_t *result, const char *db_name);
+void parser_create_table(parser_result_t *result, const table_def_t *table);
+void parser_drop_table(parser_result_t *result, const char *table_name);
+void parser_show_table(parser_result_t *result, const char *table_name);
+void parser_insert(parser_result_t *result, const insert_info_t *insert_info);
+void parser_delete(parser_result_t *result, const delete_info_t *delete_info);
+void parser_select(parser_result_t *result, const select_info_t *select_info);
+void parser_explain(parser_result_t *result, const select_info_t *select_info);
+void parser_update(parser_result_t *result, const update_info_t *update_info);
+void parser_create_index(parser_result_t *result, const char *table_name, const char *col_name);
+void parser_drop_index(parser_result_t *result, const char *table_name, const char *col_name);
+void parser_analyze_table(parser_result_t *result, const char *table_name);
+void parser_switch_output(parser_result_t *result, const char *output_filename);
+void parser_quit(parser_result_t *result);
 
 #ifdef __cplusplus
 }
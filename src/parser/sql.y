@@ -3,17 +3,26 @@
  * Grammar: http://h2database.com/html/grammar.html#select */
 
 %define parse.error verbose
+%define api.pure full
+
+%code requires {
+#include "defs.h"
+
+#ifndef YY_TYPEDEF_YY_SCANNER_T
+#define YY_TYPEDEF_YY_SCANNER_T
+typedef void *yyscan_t;
+#endif
+}
+
+/* the scanner and the result belong to one run_parser call */
+%lex-param   { yyscan_t scanner }
+%parse-param { yyscan_t scanner } { parser_result_t *result }
 
 %{
 #include <stdio.h>
 #include <stdlib.h>
 #include "defs.h"
 #include "parser.h"
-
-void yyerror(const char *s);
-
-#include "sql.yy.c"
-
 %}
 
 %union {
@@ -30,17 +39,24 @@ void yyerror(const char *s);
 	struct delete_info_t      *delete_info;
 	struct select_info_t      *select_info;
 	struct table_join_info_t  *join_info;
+	struct order_by_item_t    *order_item;
 	struct expr_node_t        *expr;
 }
 
+%code {
+void yyerror(yyscan_t scanner, parser_result_t *result, const char *s);
+
+#include "sql.yy.c"
+}
+
 %token TRUE FALSE NULL_TOKEN MIN MAX SUM AVG COUNT
 %token LIKE IS OR AND NOT NEQ GEQ LEQ
 %token INTEGER DOUBLE FLOAT CHAR VARCHAR DATE
 %token INTO FROM WHERE VALUES JOIN INNER OUTER
 %token LEFT RIGHT FULL ASC DESC ORDER BY IN ON AS
-%token DISTINCT GROUP USING INDEX TABLE DATABASE
+%token DISTINCT GROUP LIMIT OFFSET USING INDEX TABLE DATABASE
 %token DEFAULT UNIQUE PRIMARY FOREIGN REFERENCES CHECK KEY OUTPUT
-%token USE CREATE DROP SELECT INSERT UPDATE DELETE SHOW SET EXIT
+%token USE CREATE DROP SELECT INSERT UPDATE DELETE SHOW SET EXIT ANALYZE EXPLAIN
 
 %token IDENTIFIER
 %token DATE_LITERAL
@@ -66,12 +82,15 @@ void yyerror(const char *s);
 %type <insert_info> insert_stmt insert_columns
 %type <update_info> update_stmt
 %type <delete_info> delete_stmt
-%type <select_info> select_stmt
+%type <select_info> select_stmt limit_clause
 %type <expr> expr factor term condition cond_term where_clause literal literal_list_expr
 %type <expr> aggregate_expr aggregate_term select_expr default_expr
 %type <val_i> logical_op compare_op aggregate_op
 %type <list> select_expr_list select_expr_list_s table_refs
 %type <join_info> table_item
+%type <list> group_by_clause order_by_clause order_by_list
+%type <order_item> order_by_item
+%type <val_i> order_direction
 
 %start sql_stmts
 
@@ -81,25 +100,27 @@ sql_stmts  :  sql_stmt
 		   |  sql_stmts sql_stmt
 		   ;
 
-sql_stmt   :  create_table_stmt ';'    { parser_create_table($1); }
-		   |  create_database_stmt ';' { parser_create_database($1); }
-		   |  use_database_stmt ';'    { parser_use_database($1); }
-		   |  show_database_stmt ';'   { parser_show_database($1); }
-		   |  drop_database_stmt ';'   { parser_drop_database($1); }
-		   |  show_table_stmt ';'      { parser_show_table($1); }
-		   |  drop_table_stmt ';'      { parser_drop_table($1); }
-		   |  insert_stmt ';'          { parser_insert($1); }
-		   |  update_stmt ';'          { parser_update($1); }
-		   |  delete_stmt ';'          { parser_delete($1); }
-		   |  select_stmt ';'          { parser_select($1); }
-		   |  EXIT ';'                 { parser_quit(); exit(0); }
-		   |  SET OUTPUT '=' STRING_LITERAL ';'  { parser_switch_output($4); }
-		   |  CREATE INDEX table_name '(' IDENTIFIER ')' ';' { parser_create_index($3, $5); }
-		   |  DROP   INDEX table_name '(' IDENTIFIER ')' ';' { parser_drop_index($3, $5); }
+sql_stmt   :  create_table_stmt ';'    { parser_create_table(result, $1); }
+		   |  create_database_stmt ';' { parser_create_database(result, $1); }
+		   |  use_database_stmt ';'    { parser_use_database(result, $1); }
+		   |  show_database_stmt ';'   { parser_show_database(result, $1); }
+		   |  drop_database_stmt ';'   { parser_drop_database(result, $1); }
+		   |  show_table_stmt ';'      { parser_show_table(result, $1); }
+		   |  drop_table_stmt ';'      { parser_drop_table(result, $1); }
+		   |  insert_stmt ';'          { parser_insert(result, $1); }
+		   |  update_stmt ';'          { parser_update(result, $1); }
+		   |  delete_stmt ';'          { parser_delete(result, $1); }
+		   |  select_stmt ';'          { parser_select(result, $1); }
+		   |  EXPLAIN select_stmt ';'  { parser_explain(result, $2); }
+		   |  EXIT ';'                 { parser_quit(result); exit(0); }
+		   |  SET OUTPUT '=' STRING_LITERAL ';'  { parser_switch_output(result, $4); }
+		   |  CREATE INDEX table_name '(' IDENTIFIER ')' ';' { parser_create_index(result, $3, $5); }
+		   |  DROP   INDEX table_name '(' IDENTIFIER ')' ';' { parser_drop_index(result, $3, $5); }
+		   |  ANALYZE TABLE table_name ';'   { parser_analyze_table(result, $3); }
 		   ;
 
 create_table_stmt : CREATE TABLE table_name '(' table_fields table_extra_options ')' {
-				  	$$ = (table_def_t*)malloc(sizeof(table_def_t));
+				  	$$ = (table_def_t*)arena_alloc(result->arena, sizeof(table_def_t));
 					$$->name = $3;
 					$$->fields = $5;
 					$$->constraints = $6;
@@ -119,25 +140,25 @@ insert_stmt          : INSERT INTO insert_columns VALUES insert_values {
 					 ;
 
 insert_values        : '(' expr_list ')' {
-					 	$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+					 	$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 						$$->data = $2;
 						$$->next = NULL;
 					 }
 					 | insert_values ',' '(' expr_list ')' {
-					 	$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+					 	$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 						$$->data = $4;
 						$$->next = $1;
 					 }
 					 ;
 
 insert_columns       : table_name {
-					 	$$ = (insert_info_t*)malloc(sizeof(insert_info_t));
+					 	$$ = (insert_info_t*)arena_alloc(result->arena, sizeof(insert_info_t));
 						$$->table   = $1;
 						$$->columns = NULL;
 						$$->values  = NULL;
 					 }
 					 | table_name '(' column_list ')' {
-					 	$$ = (insert_info_t*)malloc(sizeof(insert_info_t));
+					 	$$ = (insert_info_t*)arena_alloc(result->arena, sizeof(insert_info_t));
 						$$->table   = $1;
 						$$->columns = $3;
 						$$->values  = NULL;
@@ -145,14 +166,14 @@ insert_columns       : table_name {
 					 ;
 
 delete_stmt         : DELETE FROM table_name where_clause {
-					 	$$ = (delete_info_t*)malloc(sizeof(delete_info_t));
+					 	$$ = (delete_info_t*)arena_alloc(result->arena, sizeof(delete_info_t));
 						$$->table = $3;
 						$$->where = $4;
 					}
 					;
 
 update_stmt         : UPDATE table_name SET column_ref '=' expr where_clause {
-					 	$$ = (update_info_t*)malloc(sizeof(update_info_t));
+					 	$$ = (update_info_t*)arena_alloc(result->arena, sizeof(update_info_t));
 						$$->table = $2;
 						$$->value = $6;
 						$$->where = $7;
@@ -160,33 +181,87 @@ update_stmt         : UPDATE table_name SET column_ref '=' expr where_clause {
 					}
 					;
 
-select_stmt         : SELECT select_expr_list_s FROM table_refs where_clause {
-					 	$$ = (select_info_t*)malloc(sizeof(select_info_t));
+select_stmt         : SELECT select_expr_list_s FROM table_refs where_clause group_by_clause order_by_clause limit_clause {
+					 	$$ = $8;
 						$$->tables = $4;
 						$$->exprs  = $2;
 						$$->where  = $5;
+						$$->groups = $6;
+						$$->orders = $7;
+					}
+					;
+
+limit_clause        : LIMIT INT_LITERAL {
+						$$ = (select_info_t*)arena_calloc(result->arena, sizeof(select_info_t));
+						$$->limit = $2;
+					}
+					| LIMIT INT_LITERAL OFFSET INT_LITERAL {
+						$$ = (select_info_t*)arena_calloc(result->arena, sizeof(select_info_t));
+						$$->limit  = $2;
+						$$->offset = $4;
+					}
+					| LIMIT INT_LITERAL ',' INT_LITERAL {
+						$$ = (select_info_t*)arena_calloc(result->arena, sizeof(select_info_t));
+						$$->limit  = $4;
+						$$->offset = $2;
+					}
+					| /* empty */ {
+						$$ = (select_info_t*)arena_calloc(result->arena, sizeof(select_info_t));
+						$$->limit = -1;
 					}
 					;
 
+group_by_clause     : GROUP BY expr_list { $$ = $3; }
+					| /* empty */        { $$ = NULL; }
+					;
+
+order_by_clause     : ORDER BY order_by_list { $$ = $3; }
+					| /* empty */            { $$ = NULL; }
+					;
+
+order_by_list       : order_by_list ',' order_by_item {
+						$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
+						$$->data = $3;
+						$$->next = $1;
+					}
+					| order_by_item {
+						$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
+						$$->data = $1;
+						$$->next = NULL;
+					}
+					;
+
+order_by_item       : select_expr order_direction {
+						$$ = (order_by_item_t*)arena_alloc(result->arena, sizeof(order_by_item_t));
+						$$->expr = $1;
+						$$->desc = $2;
+					}
+					;
+
+order_direction     : ASC           { $$ = 0; }
+					| DESC          { $$ = 1; }
+					| /* empty */   { $$ = 0; }
+					;
+
 table_refs          : table_refs ',' table_item {
-						$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+						$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 						$$->data = $3;
 						$$->next = $1;
 					}
 					| table_item {
-						$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+						$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 						$$->data = $1;
 						$$->next = NULL;
 					}
 					;
 
 table_item          : table_name {
-					 	$$ = (table_join_info_t*)calloc(1, sizeof(table_join_info_t));
+					 	$$ = (table_join_info_t*)arena_calloc(result->arena, sizeof(table_join_info_t));
 						$$->join_type = TABLE_JOIN_NONE;
 						$$->table = $1;
 					}
 				    | table_name AS IDENTIFIER {
-					 	$$ = (table_join_info_t*)calloc(1, sizeof(table_join_info_t));
+					 	$$ = (table_join_info_t*)arena_calloc(result->arena, sizeof(table_join_info_t));
 						$$->join_type = TABLE_JOIN_NONE;
 						$$->table = $1;
 						$$->alias = $3;
@@ -197,12 +272,12 @@ select_expr_list_s  : select_expr_list { $$ = $1; }
 					| '*'              { $$ = NULL; }
 
 select_expr_list    : select_expr_list ',' select_expr {
-						$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+						$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 						$$->data = $3;
 						$$->next = $1;
 					}
 					| select_expr {
-						$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+						$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 						$$->data = $1;
 						$$->next = NULL;
 					}
@@ -212,24 +287,24 @@ select_expr         : expr            { $$ = $1; }
 					| aggregate_expr  { $$ = $1; }
 
 aggregate_expr      : aggregate_op '(' aggregate_term ')' {
-						$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+						$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 						$$->left  = $3;
 						$$->op    = $1;
 					}
 					| COUNT '(' aggregate_term ')' {
-						$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+						$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 						$$->left  = $3;
 						$$->op    = OPERATOR_COUNT;
 					}
 					| COUNT '(' '*' ')' {
-						$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+						$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 						$$->left  = NULL;
 						$$->op    = OPERATOR_COUNT;
 					}
 					;
 
 aggregate_term      : column_ref {
-						$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+						$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 						$$->column_ref = $1;
 						$$->term_type  = TERM_COLUMN_REF;
 					}
@@ -250,65 +325,65 @@ table_extra_options : ',' table_extra_option_list  { $$ = $2; }
 					;
 
 table_extra_option_list : table_extra_option_list ',' table_extra_option {
-							$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+							$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 							$$->data = $3;
 							$$->next = $1;
 						}
 						| table_extra_option {
-							$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+							$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 							$$->data = $1;
 							$$->next = NULL;
 						}
 						;
 
 table_extra_option : PRIMARY KEY '(' IDENTIFIER ')' {
-				   	$$ = (table_constraint_t*)calloc(1, sizeof(table_constraint_t));
-					$$->column_ref = (column_ref_t*)malloc(sizeof(column_ref_t));
+				   	$$ = (table_constraint_t*)arena_calloc(result->arena, sizeof(table_constraint_t));
+					$$->column_ref = (column_ref_t*)arena_calloc(result->arena, sizeof(column_ref_t));
 					$$->column_ref->table = NULL;
 					$$->column_ref->column = $4;
 					$$->type = TABLE_CONSTRAINT_PRIMARY_KEY;
 				   }
 				   | FOREIGN KEY '(' IDENTIFIER ')' REFERENCES IDENTIFIER '(' IDENTIFIER ')' {
-				   	$$ = (table_constraint_t*)calloc(1, sizeof(table_constraint_t));
-					$$->column_ref = (column_ref_t*)malloc(sizeof(column_ref_t));
+				   	$$ = (table_constraint_t*)arena_calloc(result->arena, sizeof(table_constraint_t));
+					$$->column_ref = (column_ref_t*)arena_calloc(result->arena, sizeof(column_ref_t));
 					$$->column_ref->table = NULL;
 					$$->column_ref->column = $4;
-					$$->foreign_column_ref = (column_ref_t*)malloc(sizeof(column_ref_t));
+					$$->foreign_column_ref = (column_ref_t*)arena_calloc(result->arena, sizeof(column_ref_t));
 					$$->foreign_column_ref->table = $7;
 					$$->foreign_column_ref->column = $9;
 					$$->type = TABLE_CONSTRAINT_FOREIGN_KEY;
 				   }
 				   | UNIQUE '(' column_ref ')' {
-				   	$$ = (table_constraint_t*)calloc(1, sizeof(table_constraint_t));
+				   	$$ = (table_constraint_t*)arena_calloc(result->arena, sizeof(table_constraint_t));
 					$$->type = TABLE_CONSTRAINT_UNIQUE;
 					$$->column_ref = $3;
 				   }
 				   | CHECK '(' condition ')' {
-				   	$$ = (table_constraint_t*)calloc(1, sizeof(table_constraint_t));
+				   	$$ = (table_constraint_t*)arena_calloc(result->arena, sizeof(table_constraint_t));
 					$$->type = TABLE_CONSTRAINT_CHECK;
 					$$->check_cond = $3;
 				   }
 				   ;
 
 column_ref   : IDENTIFIER {
-			 	$$ = (column_ref_t*)malloc(sizeof(column_ref_t));
+			 	$$ = (column_ref_t*)arena_calloc(result->arena, sizeof(column_ref_t));
 				$$->table  = NULL;
 				$$->column = $1;
 			 }
 			 | table_name '.' IDENTIFIER {
-			 	$$ = (column_ref_t*)malloc(sizeof(column_ref_t));
+			 	$$ = (column_ref_t*)arena_calloc(result->arena, sizeof(column_ref_t));
 				$$->table  = $1;
 				$$->column = $3;
 			 }
 			 ;
 
 column_list  : column_list ',' column_ref {
-				$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+				$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 				$$->data = $3;
 				$$->next = $1;
 			 }
 			 | column_ref {
-			 	$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+			 	$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 				$$->data = $1;
 				$$->next = NULL;
 			 }
@@ -320,7 +395,7 @@ table_fields : table_field                  { $$ = $1; }
 			 ;
 
 table_field  : IDENTIFIER field_type field_width field_flags default_expr {
-			 	$$ = (field_item_t*)malloc(sizeof(field_item_t));
+			 	$$ = (field_item_t*)arena_alloc(result->arena, sizeof(field_item_t));
 				$$->name = $1;
 				$$->type = $2;
 				$$->width = $3;
@@ -367,7 +442,7 @@ compare_op : '='  { $$ = OPERATOR_EQ; }
 		   ;
 
 condition  : condition logical_op cond_term {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $1;
 				$$->right = $3;
 				$$->op    = $2;
@@ -376,65 +451,65 @@ condition  : condition logical_op cond_term {
 		   ;
 
 cond_term  : expr compare_op expr {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $1;
 				$$->right = $3;
 				$$->op    = $2;
 		   }
 		   | expr IN '(' literal_list_expr ')' {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $1;
 				$$->right = $4;
 				$$->op    = OPERATOR_IN;
 		   }
 		   | expr IS NULL_TOKEN {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $1;
 				$$->op    = OPERATOR_ISNULL;
 		   }
 		   | expr IS NOT NULL_TOKEN {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $1;
 				$$->op    = OPERATOR_NOTNULL;
 		   }
 		   | NOT cond_term {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $2;
 				$$->op    = OPERATOR_NOT;
 		   }
 		   | '(' condition ')' { $$ = $2; }
 		   | TRUE {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->val_b     = 1;
 				$$->term_type = TERM_BOOL;
 		   }
 		   | FALSE {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->val_b     = 0;
 				$$->term_type = TERM_BOOL;
 		   }
 		   ;
 
 expr_list  : expr_list ',' expr {
-				$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+				$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 				$$->data = $3;
 				$$->next = $1;
 		   }
 		   | expr {
-				$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+				$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 				$$->data = $1;
 				$$->next = NULL;
 		   }
 		   ;
 
 expr       : expr '+' factor {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $1;
 				$$->right = $3;
 				$$->op    = OPERATOR_ADD;
 		   }
 		   | expr '-' factor {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $1;
 				$$->right = $3;
 				$$->op    = OPERATOR_MINUS;
@@ -443,13 +518,13 @@ expr       : expr '+' factor {
 		   ;
 
 factor     : factor '*' term {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $1;
 				$$->right = $3;
 				$$->op    = OPERATOR_MUL;
 		   }
 		   | factor '/' term {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $1;
 				$$->right = $3;
 				$$->op    = OPERATOR_DIV;
@@ -458,59 +533,59 @@ factor     : factor '*' term {
 		   ;
 
 term       : column_ref {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->column_ref = $1;
 				$$->term_type  = TERM_COLUMN_REF;
 		   }
 		   | '-' term {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->left  = $2;
 				$$->op    = OPERATOR_NEGATE;
 		   }
 		   | literal      { $$ = $1; }
 		   | NULL_TOKEN {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->term_type  = TERM_NULL;
 		   }
 		   | '(' expr ')' { $$ = $2; }
 		   ;
 
 literal    : INT_LITERAL {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->val_i      = $1;
 				$$->term_type  = TERM_INT;
 		   }
 		   | FLOAT_LITERAL {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->val_f      = $1;
 				$$->term_type  = TERM_FLOAT;
 		   }
 		   | DATE_LITERAL {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->val_s      = $1;
 				$$->term_type  = TERM_DATE;
 		   }
 		   | STRING_LITERAL {
-		   		$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+		   		$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 				$$->val_s      = $1;
 				$$->term_type  = TERM_STRING;
 		   }
 		   ;
 
 literal_list : literal_list ',' literal {
-				$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+				$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 				$$->data = $3;
 				$$->next = $1;
 			 }
 			 | literal {
-				$$ = (linked_list_t*)malloc(sizeof(linked_list_t));
+				$$ = (linked_list_t*)arena_alloc(result->arena, sizeof(linked_list_t));
 				$$->data = $1;
 				$$->next = NULL;
 			 }
 			 ;
 
 literal_list_expr : literal_list {
-					$$ = (expr_node_t*)calloc(1, sizeof(expr_node_t));
+					$$ = (expr_node_t*)arena_calloc(result->arena, sizeof(expr_node_t));
 					$$->literal_list = $1;
 					$$->term_type    = TERM_LITERAL_LIST;
 				  }
@@ -524,27 +599,29 @@ database_name : IDENTIFIER       { $$ = $1; }
 
 %%
 
-void yyerror(const char *msg)
+void yyerror(yyscan_t scanner, parser_result_t *result, const char *msg)
 {
 	fprintf(stderr, "[Error] %s\n", msg);
 }
 
-int yywrap()
-{
-	return 1;
-}
-
-char run_parser(const char *input)
+char run_parser(const char *input, parser_result_t *result)
 {
 	char ret;
-  	if(input) {
-    	YY_BUFFER_STATE buf = yy_scan_string(input);
-		yy_switch_to_buffer(buf);
-		ret = yyparse();
-		yy_delete_buffer(buf);
+	yyscan_t scanner;
+	result->type  = SQL_RESET;
+	result->param = NULL;
+	result->arena = arena_create();
+	if(yylex_init_extra(result->arena, &scanner))
+		return 1;
+
+	if(input) {
+		YY_BUFFER_STATE buf = yy_scan_string(input, scanner);
+		ret = yyparse(scanner, result);
+		yy_delete_buffer(buf, scanner);
 	} else {
-		ret = yyparse();
+		ret = yyparse(scanner, result);
 	}
 
+	yylex_destroy(scanner);
 	return ret;
 }
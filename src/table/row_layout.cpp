@@ -0,0 +1,154 @@
+#include "row_layout.h"
+#include <algorithm>
+#include <cstring>
+
+void row_layout::init(const table_header_t &header)
+{
+	order.clear();
+	record_size = 4;
+	for(int i = 0; i < header.col_num; ++i)
+	{
+		col_type[i] = header.col_type[i];
+		col_offset[i] = header.col_offset[i];
+		col_length[i] = header.col_length[i];
+		record_size += col_length[i];
+		if(col_offset[i] != 0)
+			order.push_back(i);
+	}
+
+	std::sort(order.begin(), order.end(), [&](int a, int b) {
+		return col_offset[a] < col_offset[b];
+	} );
+
+	fixed_size = 8;
+	last_var = -1;
+	packed_offset[header.main_index] = 0;
+	for(int cid : order)
+	{
+		packed_offset[cid] = fixed_size;
+		if(col_type[cid] == COL_TYPE_VARCHAR)
+		{
+			prev_var[cid] = last_var;
+			last_var = cid;
+			fixed_size += 2;
+		} else {
+			fixed_size += col_length[cid];
+		}
+	}
+
+	packed = header.row_format == ROW_FORMAT_VARLEN && last_var >= 0;
+	scratch.resize(max_size());
+}
+
+int row_layout::var_end(const char *src, int cid) const
+{
+	uint16_t end;
+	std::memcpy(&end, src + packed_offset[cid], 2);
+	return end;
+}
+
+int row_layout::var_begin(const char *src, int cid) const
+{
+	return prev_var[cid] < 0 ? fixed_size : var_end(src, prev_var[cid]);
+}
+
+int row_layout::pack(const char *rec, char *out) const
+{
+	std::memcpy(out, rec, 8);
+	int null_mark = ((const int*)rec)[1];
+	int end = fixed_size;
+	for(int cid : order)
+	{
+		const char *col = rec + col_offset[cid];
+		if(col_type[cid] != COL_TYPE_VARCHAR)
+		{
+			std::memcpy(out + packed_offset[cid], col, col_length[cid]);
+			continue;
+		}
+
+		int len = (null_mark >> cid) & 1 ? 0 : strnlen(col, col_length[cid]);
+		std::memcpy(out + end, col, len);
+		end += len;
+		uint16_t e = end;
+		std::memcpy(out + packed_offset[cid], &e, 2);
+	}
+
+	return end;
+}
+
+void row_layout::unpack(const char *src, char *rec, unsigned mask) const
+{
+	std::memcpy(rec, src, 8);
+	for(int cid : order)
+	{
+		if(!((mask >> cid) & 1))
+			continue;
+
+		char *col = rec + col_offset[cid];
+		if(col_type[cid] != COL_TYPE_VARCHAR)
+		{
+			std::memcpy(col, src + packed_offset[cid], col_length[cid]);
+			continue;
+		}
+
+		// strings are compared and hashed with their padding zeros
+		int begin = var_begin(src, cid), len = var_end(src, cid) - begin;
+		std::memcpy(col, src + begin, len);
+		std::memset(col + len, 0, col_length[cid] - len);
+	}
+}
+
+int row_layout::saved_size(record_manager *rm) const
+{
+	if(!packed) return record_size;
+	uint16_t end;
+	rm->seek(packed_offset[last_var]);
+	rm->read(&end, 2);
+	return end;
+}
+
+void row_layout::read(record_manager *rm, char *rec, unsigned mask)
+{
+	rm->seek(0);
+	if(!packed)
+	{
+		rm->read(rec, record_size);
+		return;
+	}
+
+	auto block = rm->ptr();
+	if(block.second >= fixed_size && block.second >= var_end(block.first, last_var))
+	{
+		// the record has no overflow pages
+		unpack(block.first, rec, mask);
+		return;
+	}
+
+	rm->read(scratch.data(), fixed_size);
+	int size = var_end(scratch.data(), last_var);
+	rm->read(scratch.data() + fixed_size, size - fixed_size);
+	unpack(scratch.data(), rec, mask);
+}
+
+void row_layout::read_column(record_manager *rm, int cid, char *buf) const
+{
+	if(!packed || col_type[cid] != COL_TYPE_VARCHAR)
+	{
+		rm->seek(packed ? packed_offset[cid] : col_offset[cid]);
+		rm->read(buf, col_length[cid]);
+		return;
+	}
+
+	uint16_t begin = fixed_size, end;
+	if(prev_var[cid] >= 0)
+	{
+		rm->seek(packed_offset[prev_var[cid]]);
+		rm->read(&begin, 2);
+	}
+
+	rm->seek(packed_offset[cid]);
+	rm->read(&end, 2);
+	rm->seek(begin);
+	rm->read(buf, end - begin);
+	std::memset(buf + (end - begin), 0, col_length[cid] - (end - begin));
+}
@@ -0,0 +1,59 @@
+#ifndef __TRIVIALDB_ROW_LAYOUT__
+#define __TRIVIALDB_ROW_LAYOUT__
+
+#include <stdint.h>
+#include <vector>
+#include "../defs.h"
+#include "table_header.h"
+#include "record.h"
+
+/* Layout of the records saved in data pages.
+ *
+ * Records are used in memory with every column at its offset in the
+ * table header, a VARCHAR column taking its declared length. Tables of
+ * ROW_FORMAT_VARLEN with VARCHAR columns pack their records to save:
+ *
+ *  | rid | notnull | col or VARCHAR end | ... | VARCHAR characters |
+ *
+ * The other columns keep their lengths and the order of their offsets,
+ * and each VARCHAR column is replaced by the 2-byte offset where its
+ * characters end. The characters follow, without padding and the
+ * terminating zero, in the same order, so a VARCHAR column begins where
+ * the previous one ends. NULL strings are empty. Other tables save
+ * records as they are in memory. */
+class row_layout
+{
+	bool packed;
+	int record_size, fixed_size, last_var;
+	uint8_t col_type[MAX_COL_NUM];
+	int col_offset[MAX_COL_NUM], col_length[MAX_COL_NUM];
+	// offset in the packed record, and the previous VARCHAR column or -1
+	int packed_offset[MAX_COL_NUM], prev_var[MAX_COL_NUM];
+	// the columns in the order of their offsets, except the rid
+	std::vector<int> order;
+	// packed records spanning overflow pages are read here
+	std::vector<char> scratch;
+
+	int var_end(const char *src, int cid) const;
+	int var_begin(const char *src, int cid) const;
+
+public:
+	void init(const table_header_t &header);
+	bool is_packed() const { return packed; }
+	// the largest size of a saved record
+	int max_size() const { return packed ? fixed_size + record_size : record_size; }
+
+	// pack the record into out, return the size
+	int pack(const char *rec, char *out) const;
+	// unpack the rid, null marks and the columns in mask (bit cid set)
+	void unpack(const char *src, char *rec, unsigned mask) const;
+	// the size of the saved record at rm
+	int saved_size(record_manager *rm) const;
+
+	// read the rid, null marks and the columns in mask of the record at rm
+	void read(record_manager *rm, char *rec, unsigned mask);
+	// read a column of the record at rm as it is in memory
+	void read_column(record_manager *rm, int cid, char *buf) const;
+};
+
+#endif
@@ -2,12 +2,19 @@
 #include "../index/index.h"
 #include "../expression/expression.h"
 #include "../utils/type_cast.h"
+#include "../utils/hasher.h"
+#include "../utils/like_matcher.h"
 #include "../database/dbms.h"
 #include <cstdio>
 #include <cassert>
 #include <cstdio>
 #include <cstring>
+#include <cmath>
 #include <string>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
 
 index_manager::comparer_t get_index_comparer(int type)
 {
@@ -25,11 +32,28 @@ index_manager::comparer_t get_index_comparer(int type)
 	}
 }
 
+index_manager::hasher_t get_index_hasher(int type)
+{
+	switch(type)
+	{
+		case COL_TYPE_INT:
+		case COL_TYPE_DATE:
+			return integer_bin_hasher;
+		case COL_TYPE_FLOAT:
+			return float_bin_hasher;
+		case COL_TYPE_VARCHAR:
+			return string_hasher;
+		default:
+			assert(0);
+			return string_hasher;
+	}
+}
+
 record_manager table_manager::open_record_from_index_lower_bound(
-	std::pair<int, int> idx_pos, int *rid)
+	index_manager *index, std::pair<int, int> idx_pos, int *rid)
 {
-	index_btree::leaf_page page { pg->read(idx_pos.first), pg.get() };
-	int r = page.get_child(idx_pos.second);
+	int r;
+	index->get_entry(idx_pos, &r);
 	record_manager rm = get_record_ptr_lower_bound(r, false);
 	if(rid != nullptr) rm.read(rid, 4);
 	return rm;
@@ -38,37 +62,135 @@ record_manager table_manager::open_record_from_index_lower_bound(
 void table_manager::cache_record(record_manager *rm)
 {
 	rm->seek(0);
-	rm->read(tmp_cache, tmp_record_size);
-	cache_record_from_tmp_cache();
+	auto block = rm->ptr();
+	if(!layout.is_packed() && block.second >= tmp_record_size)
+	{
+		// pin the new page before unpinning the old one, which is often the same
+		pg->pin(block.first);
+		unpin_cached_record();
+		cached_row = pinned_row = block.first;
+		return;
+	}
+
+	unpin_cached_record();
+	read_record(rm, tmp_cache);
+	cached_row = tmp_cache;
+}
+
+void table_manager::cache_record(const char *buf)
+{
+	unpin_cached_record();
+	for(auto span : cached_spans)
+		std::memcpy(tmp_cache + span.first, buf + span.first, span.second);
+	cached_row = tmp_cache;
+}
+
+void table_manager::view_record(const char *buf)
+{
+	unpin_cached_record();
+	cached_row = buf;
+}
+
+void table_manager::unpin_cached_record()
+{
+	if(pinned_row)
+	{
+		pg->unpin(pinned_row);
+		pinned_row = nullptr;
+	}
+}
+
+void table_manager::materialize_cached_record()
+{
+	if(cached_row != tmp_cache)
+	{
+		std::memcpy(tmp_cache, cached_row, tmp_record_size);
+		cached_row = tmp_cache;
+	}
+
+	unpin_cached_record();
+}
+
+void table_manager::read_record(record_manager *rm, char *buf)
+{
+	if(layout.is_packed())
+	{
+		layout.read(rm, buf, cached_mask);
+		return;
+	}
+
+	rm->seek(0);
+	auto block = rm->ptr();
+	if(block.second >= tmp_record_size)
+	{
+		// the record has no overflow pages
+		for(auto span : cached_spans)
+			std::memcpy(buf + span.first, block.first + span.first, span.second);
+		return;
+	}
+
+	// overflow pages are followed only as far as the last column read
+	for(auto span : cached_spans)
+	{
+		rm->seek(span.first);
+		rm->read(buf + span.first, span.second);
+	}
 }
 
-void table_manager::cache_record_from_tmp_cache()
+void table_manager::set_cached_columns(unsigned mask)
 {
-	expression::cache_clear(header.table_name);
-	int null_mark = ((int*)tmp_cache)[1];
+	cached_mask = mask;
+	std::vector<std::pair<int, int>> spans;
+	spans.emplace_back(0, 8);
 	for(int i = 0; i < header.col_num; ++i)
 	{
-		if(i == header.main_index && header.is_main_index_additional)
-			continue;
+		if((mask >> i) & 1)
+			spans.emplace_back(header.col_offset[i], header.col_length[i]);
+	}
 
-		char *buf = nullptr;
-		if(!((null_mark >> i) & 1))
-			buf = tmp_cache + header.col_offset[i];
+	// columns close to each other are read at once
+	std::sort(spans.begin(), spans.end());
+	cached_spans.clear();
+	for(auto span : spans)
+	{
+		if(!cached_spans.empty())
+		{
+			auto &last = cached_spans.back();
+			if(span.first < last.first + last.second + RECORD_SKIP_MIN_GAP)
+			{
+				last.second = std::max(last.second, span.first + span.second - last.first);
+				continue;
+			}
+		}
 
-		expression::cache_column(
-			header.table_name,
-			header.col_name[i],
-			typecast::column_to_expr(buf, header.col_type[i])
-		);
+		cached_spans.push_back(span);
 	}
 }
 
+index_manager::hasher_t table_manager::get_column_hasher(int cid)
+{
+	return get_index_hasher(header.col_type[cid]);
+}
+
+bool table_manager::bind_column(column_ref_t *col)
+{
+	int cid = lookup_column(col->column);
+	if(cid < 0 || (cid == header.main_index && header.is_main_index_additional))
+		return false;
+
+	col->record = &cached_row;
+	col->cid    = cid;
+	col->type   = header.col_type[cid];
+	col->offset = header.col_offset[cid];
+	return true;
+}
+
 const char* table_manager::get_cached_column(int cid)
 {
 	assert(cid >= 0 && cid < header.col_num);
-	int null_mark = ((int*)tmp_cache)[1];
+	int null_mark = ((const int*)cached_row)[1];
 	if(!((null_mark >> cid) & 1))
-		return tmp_cache + header.col_offset[cid];
+		return cached_row + header.col_offset[cid];
 	else return nullptr;
 }
 
@@ -82,8 +204,17 @@ void table_manager::load_indices()
 			indices[i] = new index_manager(pg.get(),
 				header.col_length[i],
 				header.index_root[i],
-				get_index_comparer(header.col_type[i])
+				get_index_comparer(header.col_type[i]),
+				header.col_type[i] == COL_TYPE_VARCHAR
 			);
+
+			if((1u << i) & header.flag_bloom)
+			{
+				indices[i]->enable_bloom_filter(
+					get_index_hasher(header.col_type[i]),
+					header.bloom_root[i]
+				);
+			}
 		}
 	}
 }
@@ -96,6 +227,7 @@ void table_manager::free_indices()
 		{
 			assert(indices[i]);
 			header.index_root[i] = indices[i]->get_root_pid();
+			header.bloom_root[i] = indices[i]->save_bloom_filter(header.bloom_root[i]);
 			delete indices[i];
 			indices[i] = nullptr;
 		}
@@ -106,6 +238,7 @@ void table_manager::free_check_constraints()
 {
 	for(int i = 0; i != header.check_constaint_num; ++i)
 	{
+		expression::free_program(check_conds[i]);
 		expression::free_exprnode(check_conds[i]);
 		check_conds[i] = nullptr;
 	}
@@ -118,6 +251,8 @@ void table_manager::load_check_constraints()
 	{
 		std::istringstream is(header.check_constaints[i]);
 		check_conds[i] = expression::load_exprnode(is);
+		dbms::bind_columns(check_conds[i], std::vector<table_manager*>(1, this));
+		expression::compile(check_conds[i]);
 	}
 }
 
@@ -130,6 +265,7 @@ std::shared_ptr<table_manager> table_manager::mirror(const char *alias_name)
 	tb->pg = pg;
 	tb->btr = btr;
 	tb->header = header;
+	tb->stats = stats;
 	tb->allocate_temp_record();
 	std::memcpy(tb->indices, indices, sizeof(indices));
 	std::memcpy(tb->check_conds, check_conds, sizeof(check_conds));
@@ -146,6 +282,17 @@ bool table_manager::open(const char *table_name)
 
 	std::ifstream ifs(thead, std::ios::binary);
 	ifs.read((char*)&header, sizeof(header));
+	if(ifs.gcount() != sizeof(header) || header.magic != TABLE_HEADER_MAGIC)
+	{
+		// saved before the fields after table_name were added, no statistics follow
+		header.upgrade();
+		ifs.setstate(std::ios::failbit);
+	}
+
+	// tables never analyzed have no statistics saved
+	std::memset(&stats, 0, sizeof(stats));
+	ifs.read((char*)&stats, sizeof(stats));
+	if(!ifs) std::memset(&stats, 0, sizeof(stats));
 	pg = std::make_shared<pager>(tdata.c_str());
 	btr = std::make_shared<int_btree>(
 			pg.get(), header.index_root[header.main_index]);
@@ -167,6 +314,7 @@ bool table_manager::create(const char *table_name, const table_header_t *header)
 	btr = std::make_shared<int_btree>(pg.get(), 0);
 
 	this->header = *header;
+	std::memset(&stats, 0, sizeof(stats));
 	this->header.index_root[header->main_index] = btr->get_root_page_id();
 	allocate_temp_record();
 	load_indices();
@@ -201,17 +349,22 @@ void table_manager::close()
 
 		std::ofstream ofs(thead, std::ios::binary);
 		ofs.write((char*)&header, sizeof(header));
+		if(stats.analyzed)
+			ofs.write((char*)&stats, sizeof(stats));
 		pg->close();
 	}
 
+	unpin_cached_record();
 	btr = nullptr;
 	pg = nullptr;
 	delete []tmp_record;
 	delete []tmp_cache;
 	delete []tmp_index;
+	delete []tmp_packed;
 	tmp_cache = nullptr;
 	tmp_record = nullptr;
 	tmp_index = nullptr;
+	tmp_packed = nullptr;
 	is_open = false;
 	is_mirror = false;
 }
@@ -237,6 +390,12 @@ void table_manager::allocate_temp_record()
 	tmp_cache = new char[tot_len];
 	tmp_index = new char[tot_len];
 	tmp_null_mark = reinterpret_cast<int*>(tmp_record + 4);
+	cached_spans.assign(1, std::make_pair(0, tmp_record_size));
+	cached_mask = ~0u;
+	layout.init(header);
+	tmp_packed = new char[layout.max_size()];
+	cached_row = tmp_cache;
+	pinned_row = nullptr;
 }
 
 bool table_manager::set_temp_record(int col, const void *data)
@@ -291,16 +450,16 @@ int table_manager::insert_record()
 	if(header.is_main_index_additional)
 		*rid = header.auto_inc;
 
+	// check constraints are bound to the cached record
 	if(header.check_constaint_num != 0)
-	{
-		std::memcpy(tmp_cache, tmp_record, tmp_record_size);
-		cache_record_from_tmp_cache();
-	}
+		view_record(tmp_record);
 
 	if(!check_constraints(tmp_record))
 		return false;
 
-	btr->insert(*rid, tmp_record, tmp_record_size);
+	if(layout.is_packed())
+		btr->insert(*rid, tmp_packed, layout.pack(tmp_record, tmp_packed));
+	else btr->insert(*rid, tmp_record, tmp_record_size);
 
 	for(int i = 0; i < header.col_num; ++i)
 	{
@@ -337,8 +496,7 @@ bool table_manager::remove_record(int rid)
 				assert(indices[i]);
 				if(!((null_mark >> i) & 1))
 				{
-					rm.seek(header.col_offset[i]);
-					rm.read(tmp_index, header.col_length[i]);
+					layout.read_column(&rm, i, tmp_index);
 					indices[i]->erase(tmp_index, rid);
 				} else indices[i]->erase(nullptr, rid);
 			}
@@ -392,49 +550,65 @@ void table_manager::dump_record(FILE *f, int rid, std::vector<std::string>& row_
 
 void table_manager::dump_record(FILE *f, record_manager *rm, std::vector<std::string>& row_)
 {
-	rm->seek(0);
-	rm->read(tmp_cache, tmp_record_size);
-	int null_mark = ((int*)tmp_cache)[1];
+	unpin_cached_record();
+	layout.read(rm, tmp_cache, ~0u);
+	cached_row = tmp_cache;
+	dump_cached_record(f, row_);
+}
+
+void table_manager::dump_cached_record(FILE *f, std::vector<std::string>& row_)
+{
+	int null_mark = ((const int*)cached_row)[1];
 	for(int i = 0; i < header.col_num - 1; ++i)
 	{
-		if(i != 0) {
+		if(f && i != 0) {
 			std::fprintf(f, ",");
 			printf(",");
 		}
 		if(null_mark & (1u << i))
 		{
-			std::fprintf(f, "NULL");
-			printf("NULL");
-			row_.insert(row_.begin(), "NULL");
+			if(f) {
+				std::fprintf(f, "NULL");
+				printf("NULL");
+			}
+			row_.push_back("NULL");
 			continue;
 		}
 
-		char *buf = tmp_cache + header.col_offset[i];
+		const char *buf = cached_row + header.col_offset[i];
 		switch(header.col_type[i])
 		{
 			case COL_TYPE_INT:
-				std::fprintf(f, "%d", *(int*)buf);
-				printf("%d", *(int*)buf);
-				row_.insert(row_.begin(), std::to_string(*(int*)buf));
+				if(f) {
+					std::fprintf(f, "%d", *(int*)buf);
+					printf("%d", *(int*)buf);
+				}
+				row_.push_back(std::to_string(*(int*)buf));
 				break;
 			case COL_TYPE_FLOAT:
-				std::fprintf(f, "%f", *(float*)buf);
-				printf("%f", *(float*)buf);
-				row_.insert(row_.begin(), std::to_string(*(float*)buf));
+				if(f) {
+					std::fprintf(f, "%f", *(float*)buf);
+					printf("%f", *(float*)buf);
+				}
+				row_.push_back(std::to_string(*(float*)buf));
 				break;
 			case COL_TYPE_VARCHAR:
-				std::fprintf(f, "%s", buf);
-				printf("%s", buf);
-				row_.insert(row_.begin(), std::string(buf));
+				if(f) {
+					std::fprintf(f, "%s", buf);
+					printf("%s", buf);
+				}
+				row_.push_back(std::string(buf));
 				break;
 			case COL_TYPE_DATE: {
 				char date_buf[32];
 				time_t time = *(int*)buf;
 				auto tm = std::localtime(&time);
 				std::strftime(date_buf, 32, DATE_TEMPLATE, tm);
-				std::fprintf(f, "%s", date_buf);
-				printf("%s", date_buf);
-				row_.insert(row_.begin(), std::string(date_buf));
+				if(f) {
+					std::fprintf(f, "%s", date_buf);
+					printf("%s", date_buf);
+				}
+				row_.push_back(std::string(date_buf));
 				break;
 				}
 			default:
@@ -451,29 +625,39 @@ bool table_manager::modify_record(int rid, int col, const void* data)
 	assert(col >= 0 && col < header.col_num);
 
 	// record must be cached by cache_record()
+	materialize_cached_record();
 	int is_old_record_null = ((int*)tmp_cache)[1] & (1u << col);
 	if(data == nullptr)
 	{
 		((int*)tmp_cache)[1] |= 1u << col;
 	} else {
+		((int*)tmp_cache)[1] &= ~(1u << col);
 		std::memcpy(tmp_record, tmp_cache + header.col_offset[col], header.col_length[col]);
 		std::memcpy(tmp_cache + header.col_offset[col], data, header.col_length[col]);
 	}
 
-	expression::cache_replace(
-		header.table_name,
-		header.col_name[col], 
-		typecast::column_to_expr((char*)data, header.col_type[col])
-	);
-
 	if(!check_constraints(tmp_cache))
 		return false;
 
-	if(data != nullptr)
+	if(layout.is_packed())
 	{
-		rec.seek(header.col_offset[col]);
-		rec.write(data, header.col_length[col]);
+		// the record is moved if its size changes
+		int size = layout.pack(tmp_cache, tmp_packed);
+		if(size == layout.saved_size(&rec))
+		{
+			rec.seek(0);
+			rec.write(tmp_packed, size);
+		} else {
+			btr->erase(rid);
+			btr->insert(rid, tmp_packed, size);
+		}
 	} else {
+		if(data != nullptr)
+		{
+			rec.seek(header.col_offset[col]);
+			rec.write(data, header.col_length[col]);
+		}
+
 		rec.seek(4);
 		rec.write(tmp_cache + 4, 4);
 	}
@@ -517,11 +701,14 @@ void table_manager::create_index(const char *col_name)
 		std::fprintf(stderr, "[Error] index for column `%s' already exists.\n", col_name);
 	} else {
 		header.flag_indexed |= 1u << cid;
+		header.flag_bloom |= 1u << cid;
 		indices[cid] = new index_manager(pg.get(),
 			header.col_length[cid],
 			header.index_root[cid],
-			get_index_comparer(header.col_type[cid])
+			get_index_comparer(header.col_type[cid]),
+			header.col_type[cid] == COL_TYPE_VARCHAR
 		);
+		indices[cid]->enable_bloom_filter(get_index_hasher(header.col_type[cid]), 0);
 
 		// TODO: add existed data.
 	}
@@ -585,22 +772,24 @@ bool table_manager::check_foreign(const char *buf, int key_id)
 bool table_manager::check_unique(const char *buf, int col)
 {
 	assert(indices[col]);
+	if(!indices[col]->may_contain(buf + header.col_offset[col]))
+		return true;
+
 	auto it = indices[col]->get_iterator_lower_bound(buf + header.col_offset[col]);
 	if(it.is_end())
 		return true;
 
 	int dest_rid;
-	record_manager r = open_record_from_index_lower_bound(it.get(), &dest_rid);
+	record_manager r = open_record_from_index_lower_bound(indices[col], it.get(), &dest_rid);
 	if(dest_rid == *(int*)buf)
 	{
 		it.next();
 		if(it.is_end()) return true;
-		r = open_record_from_index_lower_bound(it.get(), &dest_rid);
+		r = open_record_from_index_lower_bound(indices[col], it.get(), &dest_rid);
 	}
 
 	// compare values 
-	r.seek(header.col_offset[col]);
-	r.read(tmp_index, header.col_length[col]);
+	layout.read_column(&r, col, tmp_index);
 	auto comparer = get_index_comparer(header.col_type[col]);
 	return comparer(tmp_index, buf + header.col_offset[col]) != 0;
 }
@@ -612,13 +801,16 @@ bool table_manager::check_primary(const char *buf)
 		++first_primary;
 
 	assert(indices[first_primary]);
+	if(!indices[first_primary]->may_contain(buf + header.col_offset[first_primary]))
+		return true;
+
 	auto it = indices[first_primary]->get_iterator_lower_bound(
 			buf + header.col_offset[first_primary]);
 
 	for(; !it.is_end(); it.next())
 	{
 		int rid;
-		record_manager rm = open_record_from_index_lower_bound(it.get(), &rid);
+		record_manager rm = open_record_from_index_lower_bound(indices[first_primary], it.get(), &rid);
 		if(rid == *(int*)buf)
 			continue;
 
@@ -627,8 +819,7 @@ bool table_manager::check_primary(const char *buf)
 		{
 			if(!(header.flag_primary & (1u << i)))
 				continue;
-			rm.seek(header.col_offset[i]);
-			rm.read(tmp_index, header.col_length[i]);
+			layout.read_column(&rm, i, tmp_index);
 			auto comparer = get_index_comparer(header.col_type[i]);
 			if(comparer(tmp_index, buf + header.col_offset[i]) != 0)
 			{
@@ -685,11 +876,232 @@ bool table_manager::value_exists(const char *column, const char *key)
 		return false;
 	}
 
+	if(!idx->may_contain(key))
+		return false;
+
 	auto it = idx->get_iterator_lower_bound(key);
 	if(it.is_end()) return false;
-	record_manager rm = open_record_from_index_lower_bound(it.get());
+	record_manager rm = open_record_from_index_lower_bound(idx, it.get());
 	auto comparer = get_index_comparer(get_column_type(cid));
-	rm.seek(header.col_offset[cid]);
-	rm.read(tmp_index, header.col_length[cid]);
+	layout.read_column(&rm, cid, tmp_index);
 	return comparer(key, tmp_index) == 0;
 }
+
+int table_manager::analyze()
+{
+	assert(!is_mirror);
+	std::vector<int> leaves;
+	int row_num = 0;
+	for(int pid = get_record_iterator_lower_bound(0).get().first; pid; )
+	{
+		int_btree::leaf_page page { pg->read(pid), pg.get() };
+		leaves.push_back(pid);
+		row_num += page.size();
+		pid = page.next_page();
+	}
+
+	// read every stride-th data page
+	int stride = std::max<int>(1, leaves.size() / STATS_SAMPLE_PAGES);
+	int sampled = 0;
+	std::vector<double> values[MAX_COL_NUM];
+	std::unordered_map<uint64_t, int> freq[MAX_COL_NUM];
+	for(size_t i = 0; i < leaves.size(); i += stride)
+	{
+		int_btree::leaf_page page { pg->read(leaves[i]), pg.get() };
+		int size = page.size();
+		for(int pos = 0; pos != size; ++pos)
+		{
+			record_manager rm(pg.get());
+			rm.open(leaves[i], pos, false);
+			layout.read(&rm, tmp_cache, ~0u);
+			int null_mark = ((int*)tmp_cache)[1];
+			for(int c = 0; c < header.col_num; ++c)
+			{
+				if((null_mark >> c) & 1) continue;
+				const char *buf = tmp_cache + header.col_offset[c];
+				values[c].push_back(stats_value(buf, header.col_type[c]));
+				++freq[c][get_index_hasher(header.col_type[c])(buf, header.col_length[c])];
+			}
+		}
+
+		sampled += size;
+	}
+
+	std::memset(&stats, 0, sizeof(stats));
+	stats.analyzed = 1;
+	stats.row_num = row_num;
+	stats.page_num = leaves.size();
+	stats.sampled_rows = sampled;
+	for(int c = 0; c < header.col_num; ++c)
+	{
+		column_stats_t &cs = stats.cols[c];
+		std::vector<double> &v = values[c];
+		int n = v.size();
+		cs.null_frac = sampled ? 1.0 - (double)n / sampled : 0;
+		if(n == 0) continue;
+
+		// Duj1 estimator: n * d / (n - f1 + f1 * n / N)
+		int d = freq[c].size(), f1 = 0;
+		for(auto &kv : freq[c])
+			f1 += kv.second == 1;
+		double total = std::max<double>(n, row_num * (1 - cs.null_frac));
+		cs.ndv = (double)n * d / (n - f1 + f1 * n / total);
+		cs.ndv = std::min(std::max(cs.ndv, (double)d), total);
+
+		std::sort(v.begin(), v.end());
+		cs.min_val = v.front();
+		cs.max_val = v.back();
+		cs.bucket_num = std::min(n, STATS_HISTOGRAM_BUCKETS);
+		for(int b = 0; b <= cs.bucket_num; ++b)
+			cs.bound[b] = v[(size_t)b * (n - 1) / cs.bucket_num];
+	}
+
+	return row_num;
+}
+
+bool table_manager::is_unique_column(int cid)
+{
+	return ((header.flag_unique >> cid) & 1)
+		|| (((header.flag_primary >> cid) & 1) && header.primary_key_num == 1);
+}
+
+int table_manager::estimate_row_num()
+{
+	return stats.analyzed ? stats.row_num : header.records_num;
+}
+
+int table_manager::estimate_page_num()
+{
+	if(stats.analyzed) return std::max(1, stats.page_num);
+	return std::max<int>(1, (int64_t)header.records_num * tmp_record_size / PAGE_SIZE);
+}
+
+double table_manager::estimate_ndv(int cid)
+{
+	double rows = std::max(1, estimate_row_num());
+	if(is_unique_column(cid)) return rows;
+	if(stats.analyzed) return std::max(1.0, stats.cols[cid].ndv);
+	return std::min(rows, 1 / STATS_DEFAULT_EQ_SEL);
+}
+
+double table_manager::estimate_selectivity(const expr_node_t *cond)
+{
+	if(cond == nullptr) return 1;
+
+	switch(cond->op)
+	{
+		case OPERATOR_AND:
+			return estimate_selectivity(cond->left) * estimate_selectivity(cond->right);
+		case OPERATOR_OR: {
+			double a = estimate_selectivity(cond->left);
+			double b = estimate_selectivity(cond->right);
+			return a + b - a * b;
+		}
+		case OPERATOR_NOT:
+			return 1 - estimate_selectivity(cond->left);
+		default:
+			break;
+	}
+
+	auto column_of = [&](const expr_node_t *expr) -> int {
+		if(expr == nullptr || expr->term_type != TERM_COLUMN_REF)
+			return -1;
+		const column_ref_t *col = expr->column_ref;
+		if(col->table && std::strcmp(col->table, header.table_name) != 0)
+			return -1;
+		return lookup_column(col->column);
+	};
+
+	auto literal_of = [&](const expr_node_t *expr, double *val) -> bool {
+		switch(expr->term_type)
+		{
+			case TERM_INT:
+			case TERM_DATE:
+				*val = expr->val_i;
+				return true;
+			case TERM_FLOAT:
+				*val = expr->val_f;
+				return true;
+			case TERM_STRING:
+				*val = stats_value(expr->val_s, COL_TYPE_VARCHAR);
+				return true;
+			default:
+				return false;
+		}
+	};
+
+	if(cond->op == OPERATOR_ISNULL || cond->op == OPERATOR_NOTNULL)
+	{
+		int cid = column_of(cond->left);
+		if(cid < 0) return 1;
+		double sel = stats.null_selectivity(cid);
+		return cond->op == OPERATOR_ISNULL ? sel : 1 - sel;
+	}
+
+	if(cond->op & OPERATOR_UNARY)
+		return 1;
+
+	operator_type_t op = cond->op;
+	const expr_node_t *lhs = cond->left, *rhs = cond->right;
+	if(column_of(lhs) < 0 && column_of(rhs) >= 0)
+	{
+		std::swap(lhs, rhs);
+		switch(op)
+		{
+			case OPERATOR_GT:  op = OPERATOR_LT;  break;
+			case OPERATOR_LT:  op = OPERATOR_GT;  break;
+			case OPERATOR_GEQ: op = OPERATOR_LEQ; break;
+			case OPERATOR_LEQ: op = OPERATOR_GEQ; break;
+			default: break;
+		}
+	}
+
+	int cid = column_of(lhs);
+	if(cid < 0) return 1;
+
+	// at most one row matches a value of unique column
+	double eq = is_unique_column(cid) ? 1.0 / std::max(1, estimate_row_num())
+		: stats.eq_selectivity(cid);
+
+	if(op == OPERATOR_IN)
+	{
+		int num = 0;
+		for(linked_list_t *l = rhs->literal_list; l; l = l->next)
+			++num;
+		return std::min(1.0, num * eq);
+	}
+
+	if(op == OPERATOR_LIKE)
+	{
+		if(rhs->op != OPERATOR_NONE || rhs->term_type != TERM_STRING)
+			return STATS_DEFAULT_RANGE_SEL;
+		// each character of the literal prefix narrows the rows by a fixed factor
+		like_matcher pattern(rhs->val_s);
+		if(pattern.get_kind() == like_matcher::EXACT)
+			return eq;
+		double sel = STATS_DEFAULT_RANGE_SEL
+			* std::pow(STATS_LIKE_CHAR_SEL, (double)pattern.literal_prefix().size());
+		return std::max(sel, eq);
+	}
+
+	double val;
+	if(!stats.analyzed || !literal_of(rhs, &val))
+	{
+		if(op == OPERATOR_EQ) return eq;
+		if(op == OPERATOR_NEQ) return 1 - eq;
+		return STATS_DEFAULT_RANGE_SEL;
+	}
+
+	double lt = stats.lt_selectivity(cid, val);
+	double not_null = 1 - stats.null_selectivity(cid);
+	switch(op)
+	{
+		case OPERATOR_EQ:  return eq;
+		case OPERATOR_NEQ: return std::max(0.0, not_null - eq);
+		case OPERATOR_LT:  return lt;
+		case OPERATOR_LEQ: return std::min(not_null, lt + eq);
+		case OPERATOR_GT:  return std::max(0.0, not_null - lt - eq);
+		case OPERATOR_GEQ: return std::max(0.0, not_null - lt);
+		default: return 1;
+	}
+}
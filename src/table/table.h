@@ -11,17 +11,21 @@
 #include "../btree/iterator.h"
 #include "../index/index.h"
 #include "table_header.h"
+#include "table_stats.h"
 #include "record.h"
+#include "row_layout.h"
 
 /*    Data page structure for rows
  *  | rid (main index) | notnull | fixed col 1 | ... | fixed col n |
  */
 
 struct expr_node_t;
+struct column_ref_t;
 class table_manager
 {
 	bool is_open, is_mirror;
 	table_header_t header;
+	table_stats_t stats;
 	std::shared_ptr<int_btree> btr;
 	std::shared_ptr<pager> pg;
 	std::string tname;
@@ -31,9 +35,20 @@ class table_manager
 
 	int tmp_record_size;
 	char *tmp_record;
-	char *tmp_cache, *tmp_index;
+	char *tmp_cache, *tmp_index, *tmp_packed;
+	row_layout layout;
 	int *tmp_null_mark;
+	// the cached record, which is tmp_cache or a record read in place
+	// from a data page, and the pointer pinning that page if there is one
+	const char *cached_row, *pinned_row;
+	// byte ranges (offset, length) of the records read into the cache,
+	// and the columns read from packed records
+	std::vector<std::pair<int, int>> cached_spans;
+	unsigned cached_mask;
 	void allocate_temp_record();
+	void unpin_cached_record();
+	// copy the cached record into tmp_cache to be modified
+	void materialize_cached_record();
 	void load_indices();
 	void free_indices();
 	void load_check_constraints();
@@ -54,7 +69,22 @@ public:
 	uint8_t get_column_type(int col) { return header.col_type[col]; }
 	int get_column_num() { return header.col_num; }
 	const char *get_table_name() { return header.table_name; }
-	void dump_table_info() { header.dump(); }
+	int get_foreign_key_num() { return header.foreign_key_num; }
+	const char *get_foreign_key_ref_table(int i) { return header.foreign_key_ref_table[i]; }
+	void dump_table_info() {
+		header.dump();
+		stats.dump(header.table_name, header.col_name, header.col_num);
+	}
+
+	// collect statistics from sampled data pages, return the number of rows
+	int analyze();
+	const table_stats_t& get_stats() { return stats; }
+	int estimate_row_num();
+	int estimate_page_num();
+	// estimated number of distinct non-null values of a column
+	double estimate_ndv(int cid);
+	// estimated fraction of rows satisfying cond, 1 for unknown conditions
+	double estimate_selectivity(const expr_node_t *cond);
 
 	void init_temp_record();
 	int insert_record();
@@ -62,14 +92,34 @@ public:
 	bool modify_record(int rid, int col, const void* data);
 	bool set_temp_record(int col, const void* data);
 
+	// a record with no overflow pages is not copied but read in its
+	// data page, which stays pinned until another record is cached
 	void cache_record(record_manager *rm);
+	// cache a record saved from get_cached_record()
+	void cache_record(const char *buf);
+	// cache the record in buf without copying it, buf must stay valid
+	// while the record is used
+	void view_record(const char *buf);
+	// read the columns cached of the record at rm into buf
+	void read_record(record_manager *rm, char *buf);
+	// cache only the rid, null marks and the columns in mask (bit cid
+	// set) of records, the other columns are left undefined. ~0u for all.
+	void set_cached_columns(unsigned mask);
 	const char* get_cached_column(int cid);
+	// bind a column reference to the cached record, false if not found
+	bool bind_column(column_ref_t *col);
+	const char* get_cached_record() { return cached_row; }
+	// where column references bound to the cached record read it
+	const char* const* get_cached_record_ref() { return &cached_row; }
+	int get_record_size() { return tmp_record_size; }
+	index_manager::hasher_t get_column_hasher(int cid);
 
 	void create_index(const char *col_name);
 	bool has_index(const char *col_name);
 	bool has_index(int cid);
 	index_manager *get_index(int cid);
-	record_manager open_record_from_index_lower_bound(std::pair<int, int> idx_pos, int *rid = nullptr);
+	record_manager open_record_from_index_lower_bound(index_manager *index,
+		std::pair<int, int> idx_pos, int *rid = nullptr);
 	bool value_exists(const char *column, const char *key);
 
 	// get the record R such that R.rid = min_{r.rid >= rid} r.rid
@@ -81,6 +131,8 @@ public:
 	void dump_header(FILE *f, std::vector<std::string>& heads);
 	void dump_record(FILE *f, int rid, std::vector<std::string>& row_);
 	void dump_record(FILE *f, record_manager *rm, std::vector<std::string>& row_);
+	// the values are appended to row_, nothing is printed if f is nullptr
+	void dump_cached_record(FILE *f, std::vector<std::string>& row_);
 
 private:
 	bool check_constraints(const char *buf);
@@ -89,7 +141,7 @@ private:
 	bool check_foreign(const char *buf, int key_id);
 	bool check_notnull(const char *buf);
 	bool check_value_constraint(const expr_node_t *expr);
-	void cache_record_from_tmp_cache();
+	bool is_unique_column(int cid);
 };
 
 #endif
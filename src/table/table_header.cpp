@@ -8,6 +8,7 @@
 bool fill_table_header(table_header_t *header, const table_def_t *table)
 {
 	std::memset(header, 0, sizeof(table_header_t));
+	header->magic = TABLE_HEADER_MAGIC;
 	std::strncpy(header->table_name, table->name, MAX_NAME_LEN);
 	int offset = 8;  // 4 bytes for __rowid__, and 4 bytes for not null
 	for(field_item_t *field = table->fields; field; field = field->next)
@@ -128,6 +129,10 @@ bool fill_table_header(table_header_t *header, const table_def_t *table)
 		}
 	}
 
+	// the end offsets of VARCHAR columns in saved records are 2 bytes
+	if(offset + 2 * MAX_COL_NUM <= UINT16_MAX)
+		header->row_format = ROW_FORMAT_VARLEN;
+
 	/* add '__rowid__' column (with highest index) */
 	int index = header->col_num++;
 	std::strcpy(header->col_name[index], "__rowid__");
@@ -147,6 +152,8 @@ bool fill_table_header(table_header_t *header, const table_def_t *table)
 	int first_primary = 0;
 	for(; !(header->flag_primary & (1u << first_primary)); ++first_primary);
 	header->flag_indexed |= 1u << first_primary;
+	// unique and foreign key checks probe these indices for absent keys
+	header->flag_bloom = header->flag_indexed & ~(1u << header->main_index);
 	header->auto_inc = 1;
 
 	header->primary_key_num = 0;
@@ -157,6 +164,17 @@ bool fill_table_header(table_header_t *header, const table_def_t *table)
 	return true;
 }
 
+void table_header_t::upgrade()
+{
+	char *tail = (char*)&magic;
+	std::memset(tail, 0, (char*)(this + 1) - tail);
+	magic = TABLE_HEADER_MAGIC;
+	// the bloom filters are not saved yet, and built from the indices
+	flag_bloom = flag_indexed & ~(1u << main_index);
+	// the records are saved with fixed lengths
+	row_format = ROW_FORMAT_FIXED;
+}
+
 void table_header_t::dump()
 {
 	std::printf("======== Table Info Begin ========\n");
@@ -194,6 +212,8 @@ void table_header_t::dump()
 			std::printf("UNIQUE ");
 		if(flag_indexed & (1 << i))
 			std::printf("INDEXED ");
+		if(flag_bloom & (1 << i))
+			std::printf("BLOOM ");
 		std::puts("");
 	}
 
@@ -33,7 +33,18 @@ struct table_header_t
 	char col_name[MAX_COL_NUM][MAX_NAME_LEN];
 	char table_name[MAX_NAME_LEN];
 
+	/* The fields below were added later, and a header saved before them
+	 * ends here. It is detected by the magic and they are zero then. */
+	uint32_t magic;
+	uint32_t flag_bloom;
+	// first page of the bloom filter of index, 0 if not saved yet
+	int bloom_root[MAX_COL_NUM];
+	// ROW_FORMAT_*
+	uint8_t row_format;
+
 	void dump();
+	// fill the fields missing in a header saved before they were added
+	void upgrade();
 };
 
 bool fill_table_header(table_header_t *header, const table_def_t *table);
@@ -0,0 +1,84 @@
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include "table_stats.h"
+
+double stats_value(const char *data, int type)
+{
+	switch(type)
+	{
+		case COL_TYPE_INT:
+		case COL_TYPE_DATE:
+			return *(int*)data;
+		case COL_TYPE_FLOAT:
+			return *(float*)data;
+		case COL_TYPE_VARCHAR: {
+			// the first 6 bytes fit into the mantissa
+			double v = 0;
+			bool ended = false;
+			for(int i = 0; i != 6; ++i)
+			{
+				ended = ended || !data[i];
+				v = v * 256 + (ended ? 0 : (unsigned char)data[i]);
+			}
+			return v;
+		}
+		default:
+			return 0;
+	}
+}
+
+double table_stats_t::eq_selectivity(int cid) const
+{
+	if(!analyzed) return STATS_DEFAULT_EQ_SEL;
+	const column_stats_t &c = cols[cid];
+	if(c.ndv < 1) return 0;
+	return (1 - c.null_frac) / c.ndv;
+}
+
+double table_stats_t::lt_selectivity(int cid, double val) const
+{
+	if(!analyzed) return STATS_DEFAULT_RANGE_SEL;
+	const column_stats_t &c = cols[cid];
+	if(c.bucket_num == 0 || val <= c.bound[0])
+		return 0;
+	if(val > c.bound[c.bucket_num])
+		return 1 - c.null_frac;
+
+	int i = std::upper_bound(c.bound, c.bound + c.bucket_num + 1, val) - c.bound - 1;
+	i = std::min(i, c.bucket_num - 1);
+	double width = c.bound[i + 1] - c.bound[i];
+	double in_bucket = width > 0 ? (val - c.bound[i]) / width : 0;
+	return (i + in_bucket) / c.bucket_num * (1 - c.null_frac);
+}
+
+double table_stats_t::range_selectivity(int cid, double lo, double hi) const
+{
+	if(!analyzed) return STATS_DEFAULT_RANGE_SEL;
+	if(lo > hi) return 0;
+	double sel = lt_selectivity(cid, hi) - lt_selectivity(cid, lo) + eq_selectivity(cid);
+	return std::min(std::max(sel, 0.0), 1 - cols[cid].null_frac);
+}
+
+double table_stats_t::null_selectivity(int cid) const
+{
+	if(!analyzed) return STATS_DEFAULT_EQ_SEL;
+	return cols[cid].null_frac;
+}
+
+void table_stats_t::dump(const char *table_name, const char col_name[][MAX_NAME_LEN], int col_num) const
+{
+	if(!analyzed) return;
+	std::printf("======== Table Stats Begin ========\n");
+	std::printf("Table name   = %s\n", table_name);
+	std::printf("Row number   = %d\n", row_num);
+	std::printf("Page number  = %d\n", page_num);
+	std::printf("Sampled rows = %d\n", sampled_rows);
+	for(int i = 0; i != col_num; ++i)
+	{
+		const column_stats_t &c = cols[i];
+		std::printf("  [column] name = %s, ndv = %.1f, null_frac = %.3f, min = %g, max = %g, buckets = %d\n",
+			col_name[i], c.ndv, c.null_frac, c.min_val, c.max_val, c.bucket_num);
+	}
+	std::printf("======== Table Stats End   ========\n");
+}
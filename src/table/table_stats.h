@@ -0,0 +1,41 @@
+#ifndef __TRIVIALDB_TABLE_STATS__
+#define __TRIVIALDB_TABLE_STATS__
+#include "../defs.h"
+#include <stdint.h>
+
+/* Statistics collected by ANALYZE TABLE. It is saved in the .thead
+ * file right after table_header_t. Values of all types are mapped to
+ * double by stats_value(), which keeps the order of the values. */
+
+struct column_stats_t
+{
+	// number of distinct values (estimated)
+	double ndv;
+	double null_frac;
+	double min_val, max_val;
+	// boundaries of equi-depth buckets, bucket i is [bound[i], bound[i + 1]]
+	int bucket_num;
+	double bound[STATS_HISTOGRAM_BUCKETS + 1];
+};
+
+struct table_stats_t
+{
+	// 0 if the table has never been analyzed
+	int analyzed;
+	int row_num, page_num, sampled_rows;
+	column_stats_t cols[MAX_COL_NUM];
+
+	// fraction of rows whose column equals to a value
+	double eq_selectivity(int cid) const;
+	// fraction of rows whose column is less than val
+	double lt_selectivity(int cid, double val) const;
+	// fraction of rows whose column is in [lo, hi]
+	double range_selectivity(int cid, double lo, double hi) const;
+	double null_selectivity(int cid) const;
+
+	void dump(const char *table_name, const char col_name[][MAX_NAME_LEN], int col_num) const;
+};
+
+double stats_value(const char *data, int type);
+
+#endif
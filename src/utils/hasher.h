@@ -0,0 +1,52 @@
+#ifndef __TRIVIALDB_HASHER__
+#define __TRIVIALDB_HASHER__
+
+#include <stdint.h>
+#include <cstring>
+
+inline uint64_t hash_mix(uint64_t h)
+{
+	// finalizer of MurmurHash3
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ull;
+	h ^= h >> 33;
+	return h;
+}
+
+inline uint64_t hash_bytes(const char *data, int size)
+{
+	// FNV-1a
+	uint64_t h = 0xcbf29ce484222325ull;
+	for(int i = 0; i < size; ++i)
+	{
+		h ^= (unsigned char)data[i];
+		h *= 0x100000001b3ull;
+	}
+
+	return hash_mix(h);
+}
+
+inline uint64_t integer_bin_hasher(const char *x, int)
+{
+	return hash_mix((uint32_t)*(int*)x);
+}
+
+inline uint64_t float_bin_hasher(const char *x, int)
+{
+	// +0.0 and -0.0 are equal under float_bin_comparer
+	float f = *(float*)x;
+	uint32_t bits = 0;
+	if(f != 0) std::memcpy(&bits, &f, sizeof(bits));
+	return hash_mix(bits);
+}
+
+inline uint64_t string_hasher(const char *x, int size)
+{
+	int len = 0;
+	while(len < size && x[len]) ++len;
+	return hash_bytes(x, len);
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef __TRIVIALDB_LIKE_MATCHER__
+#define __TRIVIALDB_LIKE_MATCHER__
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+/* A LIKE pattern parsed once to match many strings.
+ *
+ * '%' matches any sequence of characters, '_' any single character,
+ * and '\' makes the next character literal. The pattern is split at
+ * '%' into pieces: the first piece is matched at the beginning of the
+ * string, the last one at the end, and the pieces between are matched
+ * at their leftmost occurrences one after another, which is enough
+ * since every match of the rest of the pattern after a later occurrence
+ * is also a match after the leftmost one. Patterns of the common forms
+ * 'abc', 'abc%', '%abc' and '%abc%' are matched by memcmp or strstr. */
+class like_matcher
+{
+public:
+	enum kind_t { EXACT, PREFIX, SUFFIX, CONTAINS, GENERAL };
+
+private:
+	struct piece_t
+	{
+		std::string text;
+		// '_' at the position, or an empty string if there is none
+		std::string any;
+	};
+
+	kind_t kind;
+	std::vector<piece_t> pieces;
+
+	static bool piece_at(const piece_t &p, const char *s)
+	{
+		if(p.any.empty())
+			return std::memcmp(s, p.text.data(), p.text.size()) == 0;
+		for(size_t i = 0; i != p.text.size(); ++i)
+		{
+			if(!p.any[i] && s[i] != p.text[i])
+				return false;
+		}
+
+		return true;
+	}
+
+	// the leftmost occurrence of p in s[0, n), nullptr if not found
+	static const char *find_piece(const piece_t &p, const char *s, size_t n)
+	{
+		size_t len = p.text.size();
+		if(len > n) return nullptr;
+		if(p.any.empty())
+		{
+			const char *r = std::strstr(s, p.text.c_str());
+			return r && (size_t)(r - s) + len <= n ? r : nullptr;
+		}
+
+		for(size_t i = 0; i + len <= n; ++i)
+		{
+			if(piece_at(p, s + i))
+				return s + i;
+		}
+
+		return nullptr;
+	}
+
+public:
+	explicit like_matcher(const char *pattern)
+	{
+		pieces.emplace_back();
+		bool has_any = false;
+		for(const char *c = pattern; *c; ++c)
+		{
+			piece_t &p = pieces.back();
+			if(*c == '%')
+			{
+				pieces.emplace_back();
+				continue;
+			}
+
+			bool any = *c == '_';
+			if(*c == '\\')
+			{
+				// a trailing backslash is ignored
+				if(!*++c) break;
+			}
+
+			if(any && p.any.empty())
+				p.any.assign(p.text.size(), 0);
+			if(any || !p.any.empty())
+				p.any.push_back(any);
+			p.text.push_back(any ? 0 : *c);
+			has_any |= any;
+		}
+
+		size_t n = pieces.size();
+		if(has_any)
+			kind = GENERAL;
+		else if(n == 1)
+			kind = EXACT;
+		else if(n == 2 && pieces[1].text.empty())
+			kind = PREFIX;
+		else if(n == 2 && pieces[0].text.empty())
+			kind = SUFFIX;
+		else if(n == 3 && pieces[0].text.empty() && pieces[2].text.empty())
+			kind = CONTAINS;
+		else kind = GENERAL;
+	}
+
+	kind_t get_kind() const { return kind; }
+
+	// the characters every matched string begins with
+	std::string literal_prefix() const
+	{
+		const piece_t &p = pieces[0];
+		size_t len = 0;
+		while(len != p.text.size() && (p.any.empty() || !p.any[len]))
+			++len;
+		return p.text.substr(0, len);
+	}
+
+	bool match(const char *s) const
+	{
+		switch(kind)
+		{
+			case EXACT:
+				return std::strcmp(s, pieces[0].text.c_str()) == 0;
+			case PREFIX:
+				return std::strncmp(s, pieces[0].text.data(), pieces[0].text.size()) == 0;
+			case CONTAINS:
+				return std::strstr(s, pieces[1].text.c_str()) != nullptr;
+			default:
+				break;
+		}
+
+		size_t n = std::strlen(s);
+		const piece_t &first = pieces.front(), &last = pieces.back();
+		if(pieces.size() == 1)
+			return n == first.text.size() && piece_at(first, s);
+
+		size_t lo = first.text.size(), hi = n - last.text.size();
+		if(lo > n || last.text.size() > n || lo > hi)
+			return false;
+		if(!piece_at(first, s) || !piece_at(last, s + hi))
+			return false;
+
+		for(size_t i = 1; i + 1 < pieces.size(); ++i)
+		{
+			const char *r = find_piece(pieces[i], s + lo, hi - lo);
+			if(!r) return false;
+			lo = (r - s) + pieces[i].text.size();
+		}
+
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,26 @@
+CREATE DATABASE db_analyze;
+USE db_analyze;
+CREATE TABLE Persons (
+    PersonID int PRIMARY KEY,
+    Name varchar(20),
+    City varchar(20),
+    Age int,
+    UNIQUE(Name));
+
+CREATE INDEX Persons(City);
+
+INSERT INTO Persons VALUES (1, 'Person_1', 'Beijing', 20), (2, 'Person_2', 'Beijing', 21), (3, 'Person_3', 'Beijing', 22), (4, 'Person_4', 'Shanghai', NULL), (5, 'Person_5', 'Beijing', 30);
+
+ANALYZE TABLE Persons;
+
+SHOW TABLE Persons;
+
+SELECT * FROM Persons WHERE City = 'Beijing' AND Name = 'Person_2';
+
+EXPLAIN SELECT * FROM Persons WHERE City = 'Beijing' AND Name = 'Person_2';
+
+EXPLAIN SELECT * FROM Persons WHERE PersonID > 2 AND PersonID <= 4;
+
+SELECT * FROM Persons WHERE PersonID > 2 AND PersonID <= 4;
+
+ANALYZE TABLE NotExists;
@@ -0,0 +1,20 @@
+CREATE DATABASE db_group_by;
+USE db_group_by;
+CREATE TABLE Orders (
+    OrderID int PRIMARY KEY,
+    City varchar(20),
+    Amount int,
+    Price float,
+    OrderDate date);
+
+INSERT INTO Orders VALUES (1, 'Beijing', 3, 10.5, '2020-01-03'), (2, 'Shanghai', 1, 99.0, '2020-01-05'), (3, 'Beijing', 7, 2.25, '2020-02-01'), (4, NULL, 2, NULL, '2020-02-11'), (5, 'Shanghai', 4, 15.0, '2020-03-01'), (6, 'Beijing', NULL, 8.0, '2020-03-09');
+
+SELECT City, COUNT(*), SUM(Amount), MIN(Price), MAX(OrderDate) FROM Orders GROUP BY City;
+
+SELECT City, Amount, COUNT(*) FROM Orders WHERE OrderID > 1 GROUP BY City, Amount ORDER BY City, Amount;
+
+SELECT City, AVG(Price) FROM Orders GROUP BY City ORDER BY AVG(Price) DESC;
+
+SELECT City, Amount FROM Orders GROUP BY City;
+
+EXPLAIN SELECT City, COUNT(*) FROM Orders GROUP BY City ORDER BY COUNT(*) DESC;
@@ -0,0 +1,19 @@
+-- Reopens a table saved before the table header was extended (bloom filters,
+-- row formats). Copy testsql/legacy_data/* into the data directory first.
+USE db_legacy;
+SHOW TABLE Legacy;
+SELECT COUNT(*) FROM Legacy;
+SELECT * FROM Legacy WHERE id = 123;
+SELECT * FROM Legacy WHERE name = 'name_045';
+SELECT id, name FROM Legacy WHERE city = 'Hangzhou' AND age < 30;
+SELECT COUNT(*) FROM Legacy WHERE city IS NULL;
+INSERT INTO Legacy VALUES (201, 'name_100', 'Beijing', 20);
+INSERT INTO Legacy VALUES (100, 'name_201', 'Beijing', 20);
+INSERT INTO Legacy VALUES (201, 'name_201', 'Wuhan', 33);
+SELECT * FROM Legacy WHERE city = 'Wuhan';
+UPDATE Legacy SET city = 'a city with a much longer name' WHERE id = 7;
+SELECT * FROM Legacy WHERE id = 7;
+DELETE FROM Legacy WHERE age > 60;
+SELECT COUNT(*) FROM Legacy;
+CREATE INDEX Legacy(age);
+SELECT id, name FROM Legacy WHERE age = 20;
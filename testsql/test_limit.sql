@@ -0,0 +1,18 @@
+CREATE DATABASE db_limit;
+USE db_limit;
+CREATE TABLE Persons (
+    PersonID int PRIMARY KEY,
+    Name varchar(20),
+    Age int);
+
+INSERT INTO Persons VALUES (1, 'Person_1', 20), (2, 'Person_2', 31), (3, 'Person_3', 22), (4, 'Person_4', 45), (5, 'Person_5', 30), (6, 'Person_6', 27);
+
+SELECT * FROM Persons LIMIT 2;
+
+SELECT * FROM Persons LIMIT 2 OFFSET 3;
+
+SELECT * FROM Persons ORDER BY Age DESC LIMIT 3;
+
+SELECT Name, Age FROM Persons ORDER BY Age LIMIT 1, 2;
+
+EXPLAIN SELECT * FROM Persons ORDER BY Age DESC LIMIT 3;
@@ -0,0 +1,21 @@
+CREATE DATABASE db_order_by;
+USE db_order_by;
+CREATE TABLE Persons (
+    PersonID int PRIMARY KEY,
+    Name varchar(20),
+    Score float,
+    Birthday date);
+
+INSERT INTO Persons VALUES (1, 'bob', 1.5, '2020-01-03'), (2, 'alice', -2.25, '2019-05-01'), (3, NULL, 0.0, NULL), (4, 'carol', NULL, '2021-12-31'), (5, 'bob', -0.5, '2020-01-02'), (6, '', 3.75, '2018-07-07');
+
+SELECT * FROM Persons ORDER BY Name;
+
+SELECT * FROM Persons ORDER BY Name DESC, PersonID;
+
+SELECT * FROM Persons ORDER BY Score DESC;
+
+SELECT * FROM Persons WHERE PersonID > 2 ORDER BY Birthday;
+
+SELECT * FROM Persons ORDER BY PersonID DESC;
+
+EXPLAIN SELECT * FROM Persons ORDER BY Name DESC, PersonID;
@@ -0,0 +1,69 @@
+-- Records with VARCHAR columns are packed to their actual lengths, so an
+-- UPDATE that changes a string erases the record and inserts it again under
+-- the same rid. Deleting most rows afterwards makes the leaves of the rowid
+-- tree borrow from and merge with their siblings under one parent. The rows
+-- are found again through the rowid tree and through the index of tag. The
+-- wide column left NULL costs little once packed, but it keeps the estimated
+-- size of the table large enough for the index to be chosen.
+CREATE DATABASE db_varchar;
+USE db_varchar;
+CREATE TABLE Notes (
+    id int PRIMARY KEY,
+    tag varchar(20) UNIQUE,
+    note varchar(200),
+    score int,
+    extra varchar(2000));
+
+INSERT INTO Notes VALUES
+    (1, 'tag_001', 'n1', 3, NULL), (2, 'tag_002', 'n2', 6, NULL), (3, 'tag_003', 'n3', 9, NULL), (4, 'tag_004', 'n4', 12, NULL), (5, 'tag_005', 'n5', 15, NULL), (6, 'tag_006', 'n6', 18, NULL),
+    (7, 'tag_007', 'n7', 21, NULL), (8, 'tag_008', 'n8', 24, NULL), (9, 'tag_009', 'n9', 27, NULL), (10, 'tag_010', 'n10', 30, NULL), (11, 'tag_011', 'n11', 33, NULL), (12, 'tag_012', 'n12', 36, NULL),
+    (13, 'tag_013', 'n13', 39, NULL), (14, 'tag_014', 'n14', 42, NULL), (15, 'tag_015', 'n15', 45, NULL), (16, 'tag_016', 'n16', 48, NULL), (17, 'tag_017', 'n17', 51, NULL), (18, 'tag_018', 'n18', 54, NULL),
+    (19, 'tag_019', 'n19', 57, NULL), (20, 'tag_020', 'n20', 60, NULL), (21, 'tag_021', 'n21', 63, NULL), (22, 'tag_022', 'n22', 66, NULL), (23, 'tag_023', 'n23', 69, NULL), (24, 'tag_024', 'n24', 72, NULL),
+    (25, 'tag_025', 'n25', 75, NULL), (26, 'tag_026', 'n26', 78, NULL), (27, 'tag_027', 'n27', 81, NULL), (28, 'tag_028', 'n28', 84, NULL), (29, 'tag_029', 'n29', 87, NULL), (30, 'tag_030', 'n30', 90, NULL),
+    (31, 'tag_031', 'n31', 93, NULL), (32, 'tag_032', 'n32', 96, NULL), (33, 'tag_033', 'n33', 99, NULL), (34, 'tag_034', 'n34', 2, NULL), (35, 'tag_035', 'n35', 5, NULL), (36, 'tag_036', 'n36', 8, NULL),
+    (37, 'tag_037', 'n37', 11, NULL), (38, 'tag_038', 'n38', 14, NULL), (39, 'tag_039', 'n39', 17, NULL), (40, 'tag_040', 'n40', 20, NULL), (41, 'tag_041', 'n41', 23, NULL), (42, 'tag_042', 'n42', 26, NULL),
+    (43, 'tag_043', 'n43', 29, NULL), (44, 'tag_044', 'n44', 32, NULL), (45, 'tag_045', 'n45', 35, NULL), (46, 'tag_046', 'n46', 38, NULL), (47, 'tag_047', 'n47', 41, NULL), (48, 'tag_048', 'n48', 44, NULL),
+    (49, 'tag_049', 'n49', 47, NULL), (50, 'tag_050', 'n50', 50, NULL), (51, 'tag_051', 'n51', 53, NULL), (52, 'tag_052', 'n52', 56, NULL), (53, 'tag_053', 'n53', 59, NULL), (54, 'tag_054', 'n54', 62, NULL),
+    (55, 'tag_055', 'n55', 65, NULL), (56, 'tag_056', 'n56', 68, NULL), (57, 'tag_057', 'n57', 71, NULL), (58, 'tag_058', 'n58', 74, NULL), (59, 'tag_059', 'n59', 77, NULL), (60, 'tag_060', 'n60', 80, NULL),
+    (61, 'tag_061', 'n61', 83, NULL), (62, 'tag_062', 'n62', 86, NULL), (63, 'tag_063', 'n63', 89, NULL), (64, 'tag_064', 'n64', 92, NULL), (65, 'tag_065', 'n65', 95, NULL), (66, 'tag_066', 'n66', 98, NULL),
+    (67, 'tag_067', 'n67', 1, NULL), (68, 'tag_068', 'n68', 4, NULL), (69, 'tag_069', 'n69', 7, NULL), (70, 'tag_070', 'n70', 10, NULL), (71, 'tag_071', 'n71', 13, NULL), (72, 'tag_072', 'n72', 16, NULL),
+    (73, 'tag_073', 'n73', 19, NULL), (74, 'tag_074', 'n74', 22, NULL), (75, 'tag_075', 'n75', 25, NULL), (76, 'tag_076', 'n76', 28, NULL), (77, 'tag_077', 'n77', 31, NULL), (78, 'tag_078', 'n78', 34, NULL),
+    (79, 'tag_079', 'n79', 37, NULL), (80, 'tag_080', 'n80', 40, NULL), (81, 'tag_081', 'n81', 43, NULL), (82, 'tag_082', 'n82', 46, NULL), (83, 'tag_083', 'n83', 49, NULL), (84, 'tag_084', 'n84', 52, NULL),
+    (85, 'tag_085', 'n85', 55, NULL), (86, 'tag_086', 'n86', 58, NULL), (87, 'tag_087', 'n87', 61, NULL), (88, 'tag_088', 'n88', 64, NULL), (89, 'tag_089', 'n89', 67, NULL), (90, 'tag_090', 'n90', 70, NULL),
+    (91, 'tag_091', 'n91', 73, NULL), (92, 'tag_092', 'n92', 76, NULL), (93, 'tag_093', 'n93', 79, NULL), (94, 'tag_094', 'n94', 82, NULL), (95, 'tag_095', 'n95', 85, NULL), (96, 'tag_096', 'n96', 88, NULL),
+    (97, 'tag_097', 'n97', 91, NULL), (98, 'tag_098', 'n98', 94, NULL), (99, 'tag_099', 'n99', 97, NULL), (100, 'tag_100', 'n100', 0, NULL), (101, 'tag_101', 'n101', 3, NULL), (102, 'tag_102', 'n102', 6, NULL),
+    (103, 'tag_103', 'n103', 9, NULL), (104, 'tag_104', 'n104', 12, NULL), (105, 'tag_105', 'n105', 15, NULL), (106, 'tag_106', 'n106', 18, NULL), (107, 'tag_107', 'n107', 21, NULL), (108, 'tag_108', 'n108', 24, NULL),
+    (109, 'tag_109', 'n109', 27, NULL), (110, 'tag_110', 'n110', 30, NULL), (111, 'tag_111', 'n111', 33, NULL), (112, 'tag_112', 'n112', 36, NULL), (113, 'tag_113', 'n113', 39, NULL), (114, 'tag_114', 'n114', 42, NULL),
+    (115, 'tag_115', 'n115', 45, NULL), (116, 'tag_116', 'n116', 48, NULL), (117, 'tag_117', 'n117', 51, NULL), (118, 'tag_118', 'n118', 54, NULL), (119, 'tag_119', 'n119', 57, NULL), (120, 'tag_120', 'n120', 60, NULL);
+
+SELECT COUNT(*) FROM Notes;
+
+UPDATE Notes SET note = 'a note long enough that only a few records fit in one page of the rowid tree, so that growing every record splits the leaves and shrinking them merges the leaves' WHERE id > 0;
+SELECT COUNT(*) FROM Notes WHERE note LIKE 'a note long enough%';
+SELECT id, tag, score FROM Notes WHERE id = 57;
+SELECT id, score FROM Notes WHERE tag = 'tag_057';
+SELECT id, score FROM Notes WHERE tag LIKE 'tag_07%';
+EXPLAIN SELECT id, score FROM Notes WHERE tag = 'tag_057';
+EXPLAIN SELECT id, score FROM Notes WHERE tag LIKE 'tag_07%';
+
+UPDATE Notes SET note = 'short' WHERE id > 60;
+UPDATE Notes SET tag = 'a much longer tag' WHERE id = 33;
+UPDATE Notes SET note = NULL WHERE id = 33;
+SELECT id, tag, note, score FROM Notes WHERE id = 33;
+SELECT id, tag, note, score FROM Notes WHERE id = 61;
+SELECT id, note FROM Notes WHERE tag = 'a much longer tag';
+SELECT id, note FROM Notes WHERE tag = 'tag_033';
+SELECT COUNT(*) FROM Notes WHERE tag LIKE 'tag_03%';
+SELECT COUNT(*) FROM Notes WHERE note = 'short';
+
+DELETE FROM Notes WHERE id > 5 AND id < 115;
+SELECT id, tag, score FROM Notes;
+SELECT id, tag, score FROM Notes WHERE tag LIKE 'tag_1%';
+SELECT id, tag, score FROM Notes WHERE tag = 'tag_003';
+SELECT id, note FROM Notes WHERE id > 3 AND id < 118;
+SELECT COUNT(*) FROM Notes WHERE tag = 'a much longer tag';
+
+INSERT INTO Notes VALUES (57, 'tag_057', 'back again', 71, NULL);
+UPDATE Notes SET note = 'back again, and a little longer' WHERE id = 57;
+SELECT id, tag, note, score FROM Notes WHERE tag = 'tag_057';
+SELECT id, tag, note, score FROM Notes WHERE id = 57;
@@ -0,0 +1,80 @@
+-- An index on a VARCHAR column keeps its keys with their actual lengths.
+-- Long keys that share a prefix make long separators, so the interior pages
+-- of the index split as well, and the deletes at the end merge them again.
+-- The index of w is made by UNIQUE, so the only duplicate keys in it are the
+-- NULL ones. The wide column left NULL keeps the estimated size of the table
+-- large enough for the index to be chosen.
+CREATE DATABASE db_varkey;
+USE db_varkey;
+CREATE TABLE Words (
+    id int PRIMARY KEY,
+    w varchar(900) UNIQUE,
+    n int,
+    extra varchar(3000));
+
+INSERT INTO Words VALUES
+    (1, 'w001', 1, NULL), (2, 'w002', 2, NULL), (3, 'w003', 3, NULL), (4, 'w004', 4, NULL), (5, 'w005', 5, NULL), (6, 'w006', 6, NULL),
+    (7, 'w007', 0, NULL), (8, 'w008', 1, NULL), (9, 'w009', 2, NULL), (10, NULL, 3, NULL), (11, 'w011', 4, NULL), (12, 'w012', 5, NULL),
+    (13, 'w013', 6, NULL), (14, 'w014', 0, NULL), (15, 'w015', 1, NULL), (16, 'w016', 2, NULL), (17, 'w017', 3, NULL), (18, 'w018', 4, NULL),
+    (19, 'w019', 5, NULL), (20, NULL, 6, NULL), (21, 'w021', 0, NULL), (22, 'w022', 1, NULL), (23, 'w023', 2, NULL), (24, 'w024', 3, NULL),
+    (25, 'w025', 4, NULL), (26, 'w026', 5, NULL), (27, 'w027', 6, NULL), (28, 'w028', 0, NULL), (29, 'w029', 1, NULL), (30, NULL, 2, NULL),
+    (31, 'w031', 3, NULL), (32, 'w032', 4, NULL), (33, 'w033', 5, NULL), (34, 'w034', 6, NULL), (35, 'w035', 0, NULL), (36, 'w036', 1, NULL),
+    (37, 'w037', 2, NULL), (38, 'w038', 3, NULL), (39, 'w039', 4, NULL), (40, NULL, 5, NULL), (41, 'w041', 6, NULL), (42, 'w042', 0, NULL),
+    (43, 'w043', 1, NULL), (44, 'w044', 2, NULL), (45, 'w045', 3, NULL), (46, 'w046', 4, NULL), (47, 'w047', 5, NULL), (48, 'w048', 6, NULL),
+    (49, 'w049', 0, NULL), (50, NULL, 1, NULL), (51, 'w051', 2, NULL), (52, 'w052', 3, NULL), (53, 'w053', 4, NULL), (54, 'w054', 5, NULL),
+    (55, 'w055', 6, NULL), (56, 'w056', 0, NULL), (57, 'w057', 1, NULL), (58, 'w058', 2, NULL), (59, 'w059', 3, NULL), (60, NULL, 4, NULL);
+
+INSERT INTO Words VALUES (101, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 01', 1, NULL);
+INSERT INTO Words VALUES (102, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 02', 2, NULL);
+INSERT INTO Words VALUES (103, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 03', 3, NULL);
+INSERT INTO Words VALUES (104, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 04', 4, NULL);
+INSERT INTO Words VALUES (105, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 05', 5, NULL);
+INSERT INTO Words VALUES (106, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 06', 6, NULL);
+INSERT INTO Words VALUES (107, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 07', 0, NULL);
+INSERT INTO Words VALUES (108, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 08', 1, NULL);
+INSERT INTO Words VALUES (109, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 09', 2, NULL);
+INSERT INTO Words VALUES (110, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 10', 3, NULL);
+INSERT INTO Words VALUES (111, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 11', 4, NULL);
+INSERT INTO Words VALUES (112, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 12', 5, NULL);
+INSERT INTO Words VALUES (113, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 13', 6, NULL);
+INSERT INTO Words VALUES (114, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 14', 0, NULL);
+INSERT INTO Words VALUES (115, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 15', 1, NULL);
+INSERT INTO Words VALUES (116, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 16', 2, NULL);
+
+SELECT COUNT(*) FROM Words;
+SELECT COUNT(*) FROM Words WHERE w IS NULL;
+SELECT id FROM Words WHERE w IS NULL;
+EXPLAIN SELECT id, n FROM Words WHERE w = 'w007';
+SELECT id, n FROM Words WHERE w = 'w007';
+SELECT id FROM Words WHERE w = 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 09';
+SELECT id FROM Words WHERE w = 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 1';
+SELECT id FROM Words WHERE w = 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key ';
+EXPLAIN SELECT id FROM Words WHERE w LIKE 'the words of this%';
+SELECT COUNT(*) FROM Words WHERE w LIKE 'the words of this%';
+SELECT id FROM Words WHERE w LIKE 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 1%';
+SELECT id FROM Words WHERE w LIKE 'w05%';
+SELECT id FROM Words WHERE w IN ('w001', 'w042', 'w999', 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 12', 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 17');
+EXPLAIN SELECT id FROM Words ORDER BY w LIMIT 3;
+SELECT id FROM Words ORDER BY w LIMIT 3;
+SELECT id FROM Words ORDER BY w DESC LIMIT 3;
+
+INSERT INTO Words VALUES (200, 'w013', 0, NULL);
+INSERT INTO Words VALUES (200, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 05', 0, NULL);
+INSERT INTO Words VALUES (200, NULL, 0, NULL);
+UPDATE Words SET w = 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 03' WHERE id = 1;
+UPDATE Words SET w = 'w001' WHERE id = 2;
+UPDATE Words SET w = 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 17' WHERE id = 3;
+SELECT id FROM Words WHERE w = 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 17';
+SELECT COUNT(*) FROM Words WHERE w IS NULL;
+
+DELETE FROM Words WHERE id > 101 AND id < 116;
+DELETE FROM Words WHERE id > 10 AND id < 50;
+SELECT COUNT(*) FROM Words;
+SELECT id FROM Words WHERE w IS NULL;
+SELECT id FROM Words WHERE w LIKE 'the words of this%';
+SELECT id FROM Words WHERE w = 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 01';
+SELECT id FROM Words WHERE w = 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 09';
+SELECT id FROM Words WHERE w IN ('w007', 'w013', 'w055', 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 16');
+SELECT id FROM Words ORDER BY w DESC LIMIT 3;
+INSERT INTO Words VALUES (109, 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 09', 2, NULL);
+SELECT id, n FROM Words WHERE w = 'the words of this index share a long prefix, so the separators pushed up from the leaves are long as well and an interior page holds only a few of them; once enough leaves are split the interior pages of the index split too, and deleting the rows again merges them back with their siblings, which is why every one of these keys is written out at such length, and why they are told apart only by the few characters at the very end of them, after all of the shared text that comes before, so that not one of the separators can be cut short; a key of this length takes up a fifth of a page, a leaf holds four of them and an interior page holds about as many separators, so some sixteen of the keys are enough for three levels: key 09';